@@ -0,0 +1,101 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/alert_types.hpp>
+#include <libtorrent/session.hpp>
+#include <libtorrent/session_params.hpp>
+#include <libtorrent/settings_pack.hpp>
+#pragma managed(pop)
+
+#include "SyntheticTorrents.h"
+
+using namespace BenchmarkDotNet::Attributes;
+using namespace System;
+using namespace System::Collections::Generic;
+
+namespace LibtorrentDotNet::Benchmarks
+{
+	/// <summary>
+	/// Runs a batch of alerts through the session's alert handler. The batch comes from a second, plain libtorrent
+	/// session with the given number of torrents: one add and one pause alert per torrent, a state update holding
+	/// every torrent and a stats sample. The alerts stay valid because that session is never popped again.
+	/// </summary>
+	[MemoryDiagnoser]
+	public ref class AlertBenchmarks
+	{
+		TorrentSession^ session;
+		libtorrent::session* alertSource;
+		std::vector<libtorrent::alert*>* alerts;
+
+	public:
+		/// <summary>
+		/// Gets or sets the number of torrents the batch is made for.
+		/// </summary>
+		[ParamsSource("TorrentCounts")]
+		property int TorrentCount;
+
+		static property IEnumerable<int>^ TorrentCounts
+		{
+			IEnumerable<int>^ get() { return gcnew array<int> { 1000, 10000 }; }
+		}
+
+		[GlobalSetup]
+		void Setup()
+		{
+			session = SyntheticTorrents::CreateSession();
+
+			libtorrent::settings_pack settings;
+			settings.set_str(libtorrent::settings_pack::listen_interfaces, "127.0.0.1:0");
+			settings.set_bool(libtorrent::settings_pack::enable_dht, false);
+			settings.set_bool(libtorrent::settings_pack::enable_lsd, false);
+			settings.set_bool(libtorrent::settings_pack::enable_upnp, false);
+			settings.set_bool(libtorrent::settings_pack::enable_natpmp, false);
+			settings.set_int(libtorrent::settings_pack::alert_mask,
+				libtorrent::alert_category::status | libtorrent::alert_category::error);
+			settings.set_int(libtorrent::settings_pack::alert_queue_size, TorrentCount * 4 + 64);
+			alertSource = new libtorrent::session(libtorrent::session_params(settings));
+
+			std::mt19937_64 random(TorrentCount);
+			std::vector<libtorrent::torrent_handle> handles;
+			for (int i = 0; i < TorrentCount; i++)
+			{
+				libtorrent::add_torrent_params params;
+				params.info_hashes = SyntheticTorrents::CreateInfoHash(random, false);
+				params.save_path = ".";
+				params.flags = libtorrent::torrent_flags::update_subscribe;
+				handles.push_back(alertSource->add_torrent(std::move(params)));
+			}
+			for (const auto& handle : handles)
+			{
+				handle.pause();
+			}
+			alertSource->post_torrent_updates();
+			alertSource->post_session_stats();
+
+			// A blocking call runs after every request posted before it, so all the alerts above are queued by now
+			alertSource->get_torrents();
+			alerts = new std::vector<libtorrent::alert*>();
+			alertSource->pop_alerts(alerts);
+		}
+
+		[GlobalCleanup]
+		void Cleanup()
+		{
+			delete alerts;
+			alerts = nullptr;
+			delete alertSource;
+			alertSource = nullptr;
+			delete session;
+		}
+
+		[Benchmark]
+		int ProcessAlerts()
+		{
+			for (libtorrent::alert* alert : *alerts)
+			{
+				session->ProcessAlert(alert);
+			}
+			return static_cast<int>(alerts->size());
+		}
+	};
+}
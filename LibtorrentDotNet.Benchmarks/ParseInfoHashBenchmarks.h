@@ -0,0 +1,68 @@
+#pragma once
+
+#include <msclr/marshal_cppstd.h>
+#include "SyntheticTorrents.h"
+
+using namespace BenchmarkDotNet::Attributes;
+using namespace msclr::interop;
+using namespace System;
+
+namespace LibtorrentDotNet::Benchmarks
+{
+	/// <summary>
+	/// Turns a <see cref="TorrentId"/> back into an info hash, which every method taking a torrent ID does first.
+	/// The baseline is the std::string and std::stoi parsing the session used before decoding the managed string.
+	/// </summary>
+	[MemoryDiagnoser]
+	public ref class ParseInfoHashBenchmarks
+	{
+		TorrentSession^ session;
+		TorrentId^ torrentId;
+
+	public:
+		/// <summary>
+		/// Gets or sets whether the ID holds a v2 (SHA-256) hash rather than a v1 (SHA-1) hash.
+		/// </summary>
+		[ParamsAllValues]
+		property bool IsV2;
+
+		[GlobalSetup]
+		void Setup()
+		{
+			std::mt19937_64 random(1);
+			session = SyntheticTorrents::CreateSession();
+			torrentId = TorrentId::FromInfoHash(SyntheticTorrents::CreateInfoHash(random, IsV2));
+		}
+
+		[GlobalCleanup]
+		void Cleanup()
+		{
+			delete session;
+		}
+
+		[Benchmark(Baseline = true)]
+		bool Stoi()
+		{
+			marshal_context context;
+			const auto& hashString = context.marshal_as<std::string>(torrentId->ToString());
+			const size_t hashSize = hashString.length() / 2;
+			std::vector<char> hashBytes(hashSize);
+			for (size_t i = 0; i < hashSize; i++)
+			{
+				hashBytes[i] = static_cast<char>(std::stoi(hashString.substr(i * 2, 2), nullptr, 16));
+			}
+
+			if (hashString.length() == 40)
+			{
+				return libtorrent::info_hash_t(libtorrent::sha1_hash(hashBytes.data())).has_v1();
+			}
+			return libtorrent::info_hash_t(libtorrent::sha256_hash(hashBytes.data())).has_v1();
+		}
+
+		[Benchmark]
+		bool ParseInfoHash()
+		{
+			return session->ParseInfoHash(torrentId).has_v1();
+		}
+	};
+}
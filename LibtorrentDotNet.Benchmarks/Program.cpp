@@ -0,0 +1,24 @@
+#include "AlertBenchmarks.h"
+#include "ParseInfoHashBenchmarks.h"
+#include "TorrentIdBenchmarks.h"
+#include "TorrentInfoBenchmarks.h"
+#include "TorrentOperationBenchmarks.h"
+#include "TorrentStatusBenchmarks.h"
+
+using namespace BenchmarkDotNet::Configs;
+using namespace BenchmarkDotNet::Jobs;
+using namespace BenchmarkDotNet::Running;
+using namespace BenchmarkDotNet::Toolchains::InProcess::Emit;
+using namespace System;
+
+int main(array<String^>^ args)
+{
+	// The default toolchain rebuilds the benchmarks from their .csproj in a separate process, and there is none for a
+	// C++/CLI project, so the benchmarks run in this process instead.
+	auto job = JobExtensions::WithToolchain(Job::Default, InProcessEmitToolchain::Instance);
+	auto config = ManualConfig::Create(DefaultConfig::Instance)->AddJob(gcnew array<Job^> { job });
+
+	const auto assembly = LibtorrentDotNet::Benchmarks::TorrentIdBenchmarks::typeid->Assembly;
+	BenchmarkSwitcher::FromAssembly(assembly)->Run(args, config);
+	return 0;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/create_torrent.hpp>
+#include <libtorrent/file_storage.hpp>
+#include <libtorrent/info_hash.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#pragma managed(pop)
+
+#include "TorrentSession.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+using namespace System::IO;
+using namespace System::Threading;
+
+namespace LibtorrentDotNet::Benchmarks
+{
+	/// <summary>
+	/// Builds the torrents and sessions the benchmarks run against. Nothing is downloaded: torrents are added without
+	/// peers, and sessions keep their data in memory so a torrent with 100k files does not touch the disk.
+	/// </summary>
+	ref class SyntheticTorrents abstract sealed
+	{
+	internal:
+		/// <summary>
+		/// Returns a random info hash, fixed for a given seed so every run measures the same input.
+		/// </summary>
+		static libtorrent::info_hash_t CreateInfoHash(std::mt19937_64& random, const bool v2)
+		{
+			char bytes[32];
+			for (auto& byte : bytes)
+			{
+				byte = static_cast<char>(random());
+			}
+
+			if (v2)
+			{
+				return libtorrent::info_hash_t(libtorrent::sha256_hash(bytes));
+			}
+			return libtorrent::info_hash_t(libtorrent::sha1_hash(bytes));
+		}
+
+		/// <summary>
+		/// Creates the .torrent data of a v1 torrent with the given number of 1 KiB files. The piece hashes are zero,
+		/// which is fine since the data is never checked.
+		/// </summary>
+		static array<Byte>^ CreateTorrentData(const int fileCount)
+		{
+			libtorrent::file_storage files;
+			if (fileCount == 1)
+			{
+				files.add_file("payload.bin", 1024);
+			}
+			else
+			{
+				for (int i = 0; i < fileCount; i++)
+				{
+					files.add_file("payload/" + std::to_string(i / 1000) + "/" + std::to_string(i) + ".bin", 1024);
+				}
+			}
+
+			libtorrent::create_torrent creator(files, 16 * 1024, libtorrent::create_torrent::v1_only);
+			for (const auto piece : creator.files().piece_range())
+			{
+				creator.set_hash(piece, libtorrent::sha1_hash());
+			}
+
+			std::vector<char> buffer;
+			libtorrent::bencode(std::back_inserter(buffer), creator.generate());
+
+			auto torrentData = gcnew array<Byte>(static_cast<int>(buffer.size()));
+			Runtime::InteropServices::Marshal::Copy(IntPtr(buffer.data()), torrentData, 0, torrentData->Length);
+			return torrentData;
+		}
+
+		/// <summary>
+		/// Creates a session that does not look for peers and keeps torrent data in memory.
+		/// </summary>
+		static TorrentSession^ CreateSession()
+		{
+			auto config = gcnew TorrentSessionConfig();
+			config->ListenInterfaces = Optional<String^>::Some("127.0.0.1:0");
+			config->EnableUpnp = Optional<bool>::Some(false);
+			config->EnableNatPmp = Optional<bool>::Some(false);
+			config->EnableLsd = Optional<bool>::Some(false);
+			config->DhtSettings->EnableDht = Optional<bool>::Some(false);
+			config->DiskBackend = DiskIoBackend::Memory;
+
+			return safe_cast<TorrentSession^>(TorrentSession::Create(config));
+		}
+
+		/// <summary>
+		/// Adds torrents without metadata to the session, one per info hash, and waits until the session has all of
+		/// them. Torrents are added in the background, so the count is polled.
+		/// </summary>
+		static List<TorrentId^>^ AddMagnetTorrents(TorrentSession^ session, const int count)
+		{
+			std::mt19937_64 random(count);
+			auto torrentIds = gcnew List<TorrentId^>(count);
+			for (int i = 0; i < count; i++)
+			{
+				const auto torrentId = TorrentId::FromInfoHash(CreateInfoHash(random, false));
+				const auto magnetLink = String::Format("magnet:?xt=urn:btih:{0}", torrentId);
+				session->AddTorrent(gcnew AddTorrentFromMagnetLinkRequest(magnetLink, Path::GetTempPath()));
+				torrentIds->Add(torrentId);
+			}
+
+			while (session->GetTorrentStatuses()->Count < count)
+			{
+				Thread::Sleep(100);
+			}
+			return torrentIds;
+		}
+
+		/// <summary>
+		/// Adds a synthetic torrent with the given number of files and returns its ID once the session has it.
+		/// </summary>
+		static TorrentId^ AddTorrent(TorrentSession^ session, const int fileCount)
+		{
+			session->AddTorrent(gcnew AddTorrentFromByteArrayRequest(CreateTorrentData(fileCount), Path::GetTempPath()));
+
+			while (session->GetTorrentStatuses()->Count == 0)
+			{
+				Thread::Sleep(100);
+			}
+			return session->GetTorrentStatuses()[0]->Id;
+		}
+	};
+}
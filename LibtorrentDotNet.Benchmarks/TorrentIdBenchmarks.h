@@ -0,0 +1,60 @@
+#pragma once
+
+#include "SyntheticTorrents.h"
+
+using namespace BenchmarkDotNet::Attributes;
+using namespace System;
+using namespace System::Text;
+
+namespace LibtorrentDotNet::Benchmarks
+{
+	/// <summary>
+	/// Converts an info hash to a <see cref="TorrentId"/>, which happens for every torrent in every state update.
+	/// The baseline is the StringBuilder conversion the session used before TorrentId::FromInfoHash.
+	/// </summary>
+	[MemoryDiagnoser]
+	public ref class TorrentIdBenchmarks
+	{
+		libtorrent::info_hash_t* infoHash;
+
+	public:
+		/// <summary>
+		/// Gets or sets whether the hash is a v2 (SHA-256) hash rather than a v1 (SHA-1) hash.
+		/// </summary>
+		[ParamsAllValues]
+		property bool IsV2;
+
+		[GlobalSetup]
+		void Setup()
+		{
+			std::mt19937_64 random(1);
+			infoHash = new libtorrent::info_hash_t(SyntheticTorrents::CreateInfoHash(random, IsV2));
+		}
+
+		[GlobalCleanup]
+		void Cleanup()
+		{
+			delete infoHash;
+			infoHash = nullptr;
+		}
+
+		[Benchmark(Baseline = true)]
+		TorrentId^ AppendFormat()
+		{
+			const char* hash = infoHash->has_v2() ? infoHash->v2.data() : infoHash->v1.data();
+			const int hashSize = infoHash->has_v2() ? 32 : 20;
+			auto hexString = gcnew StringBuilder(hashSize * 2);
+			for (int i = 0; i < hashSize; i++)
+			{
+				hexString->AppendFormat("{0:X2}", static_cast<unsigned char>(hash[i]));
+			}
+			return gcnew TorrentId(hexString->ToString());
+		}
+
+		[Benchmark]
+		TorrentId^ FromInfoHash()
+		{
+			return TorrentId::FromInfoHash(*infoHash);
+		}
+	};
+}
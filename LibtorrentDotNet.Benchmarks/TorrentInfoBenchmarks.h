@@ -0,0 +1,88 @@
+#pragma once
+
+#include "SyntheticTorrents.h"
+
+using namespace BenchmarkDotNet::Attributes;
+using namespace System;
+using namespace System::Collections::Generic;
+
+namespace LibtorrentDotNet::Benchmarks
+{
+	/// <summary>
+	/// Wraps a torrent and its file list, as GetTorrentInfo, GetTorrents and metadata alerts do. The baseline is the
+	/// file listing the session used before, which asked the network thread for the torrent file three times and
+	/// copied each file name to a std::string.
+	/// </summary>
+	[MemoryDiagnoser]
+	public ref class TorrentInfoBenchmarks
+	{
+		TorrentSession^ session;
+		libtorrent::torrent_handle* handle;
+
+	public:
+		/// <summary>
+		/// Gets or sets the number of files in the torrent.
+		/// </summary>
+		[ParamsSource("FileCounts")]
+		property int FileCount;
+
+		static property IEnumerable<int>^ FileCounts
+		{
+			IEnumerable<int>^ get() { return gcnew array<int> { 1, 100, 10000, 100000 }; }
+		}
+
+		[GlobalSetup]
+		void Setup()
+		{
+			session = SyntheticTorrents::CreateSession();
+			const auto torrentId = SyntheticTorrents::AddTorrent(session, FileCount);
+			handle = new libtorrent::torrent_handle(session->FindTorrent(session->ParseInfoHash(torrentId).get_best()));
+		}
+
+		[GlobalCleanup]
+		void Cleanup()
+		{
+			delete handle;
+			handle = nullptr;
+			delete session;
+		}
+
+		[Benchmark(Baseline = true)]
+		TorrentInfo^ RepeatedTorrentFile()
+		{
+			TorrentId^ torrentId = TorrentId::FromInfoHash(handle->info_hashes());
+			const auto& status = handle->status();
+			auto name = gcnew String(status.name.c_str());
+			auto savePath = gcnew String(status.save_path.c_str());
+			TorrentStatus^ managedStatus = session->CreateTorrentStatus(status, torrentId);
+			UInt64 totalSize = 0;
+
+			List<TorrentFileEntry^>^ fileEntries;
+			if (handle->torrent_file())
+			{
+				fileEntries = gcnew List<TorrentFileEntry^>(handle->torrent_file()->num_files());
+				for (const auto& torrentFile = handle->torrent_file(); const auto& index : torrentFile->files().file_range())
+				{
+					const auto& path = gcnew String(torrentFile->files().file_path(index, status.save_path).c_str());
+					const auto& filename = gcnew String(torrentFile->files().file_name(index).to_string().c_str());
+					const auto& size = torrentFile->files().file_size(index);
+
+					fileEntries->Add(gcnew TorrentFileEntry(static_cast<int>(index), path, filename, size));
+				}
+				totalSize = handle->torrent_file()->total_size();
+			}
+			else
+			{
+				fileEntries = gcnew List<TorrentFileEntry^>(0);
+			}
+
+			return gcnew TorrentInfo(torrentId, name, managedStatus, fileEntries, totalSize, savePath);
+		}
+
+		[Benchmark]
+		TorrentInfo^ CreateTorrentInfo()
+		{
+			return session->CreateTorrentInfo(*handle);
+		}
+	};
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "SyntheticTorrents.h"
+
+using namespace BenchmarkDotNet::Attributes;
+using namespace System;
+using namespace System::Collections::Generic;
+
+namespace LibtorrentDotNet::Benchmarks
+{
+	/// <summary>
+	/// Pauses and resumes torrents in a session holding the given number of torrents, through the lookup and dispatch
+	/// shared by PauseTorrents, ResumeTorrents and RemoveTorrents. Each benchmark pauses and then resumes, so the
+	/// session is in the same state for every invocation.
+	/// </summary>
+	[MemoryDiagnoser]
+	public ref class TorrentOperationBenchmarks
+	{
+		TorrentSession^ session;
+		List<TorrentId^>^ allTorrents;
+		List<TorrentId^>^ oneTorrent;
+
+	public:
+		/// <summary>
+		/// Gets or sets the number of torrents in the session.
+		/// </summary>
+		[ParamsSource("TorrentCounts")]
+		property int TorrentCount;
+
+		static property IEnumerable<int>^ TorrentCounts
+		{
+			IEnumerable<int>^ get() { return gcnew array<int> { 1000, 10000, 50000 }; }
+		}
+
+		[GlobalSetup]
+		void Setup()
+		{
+			session = SyntheticTorrents::CreateSession();
+			allTorrents = SyntheticTorrents::AddMagnetTorrents(session, TorrentCount);
+			oneTorrent = gcnew List<TorrentId^>(1);
+			oneTorrent->Add(allTorrents[TorrentCount / 2]);
+		}
+
+		[GlobalCleanup]
+		void Cleanup()
+		{
+			delete session;
+		}
+
+		[Benchmark]
+		bool PauseAndResumeAll()
+		{
+			const bool paused = session->PauseTorrents(allTorrents);
+			return session->ResumeTorrents(allTorrents) && paused;
+		}
+
+		[Benchmark]
+		bool PauseAndResumeOne()
+		{
+			const bool paused = session->PauseTorrents(oneTorrent);
+			return session->ResumeTorrents(oneTorrent) && paused;
+		}
+	};
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "SyntheticTorrents.h"
+
+using namespace BenchmarkDotNet::Attributes;
+using namespace System;
+
+namespace LibtorrentDotNet::Benchmarks
+{
+	/// <summary>
+	/// Wraps a native torrent status, which a state update does once per changed torrent.
+	/// </summary>
+	[MemoryDiagnoser]
+	public ref class TorrentStatusBenchmarks
+	{
+		TorrentSession^ session;
+		TorrentId^ torrentId;
+		libtorrent::torrent_status* status;
+
+	public:
+		[GlobalSetup]
+		void Setup()
+		{
+			session = SyntheticTorrents::CreateSession();
+			torrentId = SyntheticTorrents::AddTorrent(session, 1);
+			status = new libtorrent::torrent_status(
+				session->FindTorrent(session->ParseInfoHash(torrentId).get_best()).status());
+		}
+
+		[GlobalCleanup]
+		void Cleanup()
+		{
+			delete status;
+			status = nullptr;
+			delete session;
+		}
+
+		[Benchmark]
+		TorrentStatus^ CreateTorrentStatus()
+		{
+			return session->CreateTorrentStatus(*status, torrentId);
+		}
+	};
+}
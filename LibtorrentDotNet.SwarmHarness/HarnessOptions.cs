@@ -0,0 +1,132 @@
+namespace LibtorrentDotNet.SwarmHarness;
+
+/// <summary>
+/// The shape of a swarm run, read from the command line.
+/// </summary>
+internal sealed record HarnessOptions
+{
+    public const string Usage = """
+        Usage: LibtorrentDotNet.SwarmHarness [options]
+
+          --leechers <n>      Number of leecher sessions (default 4)
+          --size-mb <n>       Total payload size in MiB (default 256)
+          --piece-kb <n>      Piece size in KiB, a power of two of at least 16 (default 1024)
+          --files <n>         Number of files the payload is split into (default 1)
+          --disk <backend>    Leechers' disk backend: default, mmap, posix, memory, or all to run once with each
+                              (default: default)
+          --stream            Let the first leecher read the first file through a TorrentStream while it downloads
+          --http              Serve the first file of the last leecher over TorrentHttpServer during the download and
+                              check ranges, HEAD and a full GET against the seeder's copy
+          --timeout <s>       Seconds to wait for all leechers before failing (default 600)
+          --seed <n>          Seed of the payload's random content (default 1)
+          --keep              Keep the payload and downloaded files instead of deleting them
+        """;
+
+    /// <summary>
+    /// Gets the number of leecher sessions.
+    /// </summary>
+    public int Leechers { get; private init; } = 4;
+
+    /// <summary>
+    /// Gets the total payload size in bytes.
+    /// </summary>
+    public long PayloadBytes { get; private init; } = 256L * 1024 * 1024;
+
+    /// <summary>
+    /// Gets the piece size in bytes.
+    /// </summary>
+    public int PieceSize { get; private init; } = 1024 * 1024;
+
+    /// <summary>
+    /// Gets the number of files the payload is split into.
+    /// </summary>
+    public int FileCount { get; private init; } = 1;
+
+    /// <summary>
+    /// Gets the disk backends of the leechers. The swarm runs once per backend, which compares their throughput on the
+    /// same payload. The seeder always uses the default backend, since it reads the payload from its files.
+    /// </summary>
+    public IReadOnlyList<DiskIoBackend> DiskBackends { get; private init; } = [DiskIoBackend.Default];
+
+    /// <summary>
+    /// Gets whether the first leecher streams the first file while it downloads.
+    /// </summary>
+    public bool Stream { get; private init; }
+
+    /// <summary>
+    /// Gets whether the last leecher serves the first file over HTTP during the download, checked against the seeder.
+    /// </summary>
+    public bool Http { get; private init; }
+
+    /// <summary>
+    /// Gets how long to wait for all leechers to complete.
+    /// </summary>
+    public TimeSpan Timeout { get; private init; } = TimeSpan.FromMinutes(10);
+
+    /// <summary>
+    /// Gets the seed of the payload's random content.
+    /// </summary>
+    public int Seed { get; private init; } = 1;
+
+    /// <summary>
+    /// Gets whether the working directory is kept after the run.
+    /// </summary>
+    public bool Keep { get; private init; }
+
+    /// <summary>
+    /// Parses the command line.
+    /// </summary>
+    /// <exception cref="ArgumentException">Thrown for an unknown option or a value out of range.</exception>
+    public static HarnessOptions Parse(string[] args)
+    {
+        var options = new HarnessOptions();
+        for (var i = 0; i < args.Length; i++)
+        {
+            options = args[i] switch
+            {
+                "--leechers" => options with { Leechers = ReadInt(args, ref i, 1) },
+                "--size-mb" => options with { PayloadBytes = ReadInt(args, ref i, 1) * 1024L * 1024 },
+                "--piece-kb" => options with { PieceSize = ReadInt(args, ref i, 16) * 1024 },
+                "--files" => options with { FileCount = ReadInt(args, ref i, 1) },
+                "--disk" => options with { DiskBackends = ReadDiskBackends(args, ref i) },
+                "--stream" => options with { Stream = true },
+                "--http" => options with { Http = true },
+                "--timeout" => options with { Timeout = TimeSpan.FromSeconds(ReadInt(args, ref i, 1)) },
+                "--seed" => options with { Seed = ReadInt(args, ref i, 0) },
+                "--keep" => options with { Keep = true },
+                _ => throw new ArgumentException($"Unknown option '{args[i]}'."),
+            };
+        }
+
+        if (!int.IsPow2(options.PieceSize))
+        {
+            throw new ArgumentException("The piece size must be a power of two.");
+        }
+        if (options.PayloadBytes < options.FileCount)
+        {
+            throw new ArgumentException("The payload must hold at least one byte per file.");
+        }
+        return options;
+    }
+
+    private static IReadOnlyList<DiskIoBackend> ReadDiskBackends(string[] args, ref int index) =>
+        (++index < args.Length ? args[index] : null) switch
+        {
+            "default" => [DiskIoBackend.Default],
+            "mmap" => [DiskIoBackend.MemoryMapped],
+            "posix" => [DiskIoBackend.Posix],
+            "memory" => [DiskIoBackend.Memory],
+            "all" => [DiskIoBackend.Default, DiskIoBackend.MemoryMapped, DiskIoBackend.Posix, DiskIoBackend.Memory],
+            _ => throw new ArgumentException("--disk needs one of default, mmap, posix, memory or all."),
+        };
+
+    private static int ReadInt(string[] args, ref int index, int minimum)
+    {
+        var name = args[index];
+        if (++index >= args.Length || !int.TryParse(args[index], out var value) || value < minimum)
+        {
+            throw new ArgumentException($"{name} needs a number of at least {minimum}.");
+        }
+        return value;
+    }
+}
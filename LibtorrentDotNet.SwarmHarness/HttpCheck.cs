@@ -0,0 +1,122 @@
+using System.Net;
+using System.Net.Http.Headers;
+
+namespace LibtorrentDotNet.SwarmHarness;
+
+/// <summary>
+/// Reads a file through <see cref="TorrentHttpServer"/> with a plain HttpClient while it downloads, and compares
+/// every response with the seeder's copy of the file.
+/// </summary>
+internal static class HttpCheck
+{
+    private const int RangeLength = 64 * 1024;
+
+    /// <summary>
+    /// Runs the checks against the first file of a torrent.
+    /// </summary>
+    /// <param name="session">The session to serve the file from.</param>
+    /// <param name="torrentId">The torrent holding the file.</param>
+    /// <param name="expectedPath">The seeder's copy of the file, which the responses must match.</param>
+    /// <param name="timeout">How long a single request may take.</param>
+    /// <returns>A description of each failed check; empty if all passed.</returns>
+    public static async Task<IReadOnlyList<string>> RunAsync(ITorrentSession session, TorrentId torrentId,
+        string expectedPath, TimeSpan timeout)
+    {
+        var failures = new List<string>();
+        var fileLength = new FileInfo(expectedPath).Length;
+
+        using var server = TorrentHttpServer.Start(session);
+        using var client = new HttpClient { Timeout = timeout };
+        var uri = server.GetFileUri(torrentId, 0);
+
+        try
+        {
+            // Ranges first, so they are served while the file is still downloading
+            var tailLength = Math.Min(RangeLength, fileLength);
+            await CheckRange(client, uri, $"bytes=-{tailLength}", fileLength - tailLength, tailLength, expectedPath,
+                failures);
+            var middle = fileLength / 2;
+            var middleEnd = Math.Min(middle + RangeLength, fileLength) - 1;
+            await CheckRange(client, uri, $"bytes={middle}-{middleEnd}", middle, middleEnd - middle + 1, expectedPath,
+                failures);
+
+            using (var request = new HttpRequestMessage(HttpMethod.Get, uri))
+            {
+                request.Headers.Range = RangeHeaderValue.Parse($"bytes={fileLength}-");
+                using var response = await client.SendAsync(request);
+                Expect(response.StatusCode == HttpStatusCode.RequestedRangeNotSatisfiable,
+                    $"a range past the end gave {(int)response.StatusCode} instead of 416", failures);
+            }
+
+            using (var request = new HttpRequestMessage(HttpMethod.Head, uri))
+            {
+                using var response = await client.SendAsync(request);
+                Expect(response.Content.Headers.ContentLength == fileLength,
+                    $"HEAD gave a length of {response.Content.Headers.ContentLength} instead of {fileLength}",
+                    failures);
+            }
+
+            using (var response = await client.GetAsync(uri, HttpCompletionOption.ResponseHeadersRead))
+            {
+                await using var body = await response.Content.ReadAsStreamAsync();
+                Expect(response.StatusCode == HttpStatusCode.OK &&
+                    await MatchesAsync(body, expectedPath, 0, fileLength),
+                    $"the whole file gave {(int)response.StatusCode} or did not match", failures);
+            }
+        }
+        catch (Exception ex) when (ex is HttpRequestException or TaskCanceledException)
+        {
+            failures.Add($"a request failed: {ex.Message}");
+        }
+
+        return failures;
+    }
+
+    private static async Task CheckRange(HttpClient client, Uri uri, string range, long offset, long length,
+        string expectedPath, List<string> failures)
+    {
+        using var request = new HttpRequestMessage(HttpMethod.Get, uri);
+        request.Headers.Range = RangeHeaderValue.Parse(range);
+        using var response = await client.SendAsync(request, HttpCompletionOption.ResponseHeadersRead);
+        await using var body = await response.Content.ReadAsStreamAsync();
+
+        Expect(response.StatusCode == HttpStatusCode.PartialContent &&
+            response.Content.Headers.ContentLength == length && await MatchesAsync(body, expectedPath, offset, length),
+            $"{range} gave {(int)response.StatusCode} or did not match", failures);
+    }
+
+    /// <summary>
+    /// Compares a response body with a part of the expected file, and checks that the body ends there.
+    /// </summary>
+    private static async Task<bool> MatchesAsync(Stream body, string expectedPath, long offset, long length)
+    {
+        await using var expected = File.OpenRead(expectedPath);
+        expected.Seek(offset, SeekOrigin.Begin);
+
+        var actualBuffer = new byte[RangeLength];
+        var expectedBuffer = new byte[RangeLength];
+        for (var remaining = length; remaining > 0;)
+        {
+            var count = await body.ReadAsync(actualBuffer.AsMemory(0, (int)Math.Min(actualBuffer.Length, remaining)));
+            if (count == 0)
+            {
+                return false;
+            }
+            await expected.ReadExactlyAsync(expectedBuffer.AsMemory(0, count));
+            if (!actualBuffer.AsSpan(0, count).SequenceEqual(expectedBuffer.AsSpan(0, count)))
+            {
+                return false;
+            }
+            remaining -= count;
+        }
+        return await body.ReadAsync(actualBuffer) == 0;
+    }
+
+    private static void Expect(bool condition, string failure, List<string> failures)
+    {
+        if (!condition)
+        {
+            failures.Add(failure);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+namespace LibtorrentDotNet.SwarmHarness;
+
+/// <summary>
+/// Writes the synthetic payload the seeder shares.
+/// </summary>
+internal static class Payload
+{
+    /// <summary>
+    /// Fills <paramref name="directory"/> with random data of the configured size and file count. The content only
+    /// depends on the seed, so runs with the same options share the same pieces.
+    /// </summary>
+    /// <returns>The path to create the torrent from: the file itself for one file, otherwise their directory.</returns>
+    public static string Write(string directory, HarnessOptions options)
+    {
+        Directory.CreateDirectory(directory);
+        if (options.FileCount == 1)
+        {
+            var filePath = Path.Combine(directory, "payload.bin");
+            WriteFile(filePath, options.PayloadBytes, new Random(options.Seed));
+            return filePath;
+        }
+
+        var payloadDirectory = Directory.CreateDirectory(Path.Combine(directory, "payload")).FullName;
+        var random = new Random(options.Seed);
+        var fileBytes = options.PayloadBytes / options.FileCount;
+        for (var i = 0; i < options.FileCount; i++)
+        {
+            // The last file takes the remainder, so the total is exactly the configured size
+            var length = i == options.FileCount - 1 ? options.PayloadBytes - fileBytes * i : fileBytes;
+            WriteFile(Path.Combine(payloadDirectory, $"{i:D6}.bin"), length, random);
+        }
+        return payloadDirectory;
+    }
+
+    private static void WriteFile(string path, long length, Random random)
+    {
+        var buffer = new byte[1024 * 1024];
+        using var file = new FileStream(path, FileMode.Create, FileAccess.Write, FileShare.None, 0);
+        for (var remaining = length; remaining > 0; remaining -= buffer.Length)
+        {
+            var count = (int)Math.Min(buffer.Length, remaining);
+            random.NextBytes(buffer.AsSpan(0, count));
+            file.Write(buffer, 0, count);
+        }
+    }
+}
@@ -0,0 +1,95 @@
+using LibtorrentDotNet;
+using LibtorrentDotNet.SwarmHarness;
+
+HarnessOptions options;
+try
+{
+    options = HarnessOptions.Parse(args);
+}
+catch (ArgumentException ex)
+{
+    Console.Error.WriteLine(ex.Message);
+    Console.Error.WriteLine(HarnessOptions.Usage);
+    return 2;
+}
+
+const double MiB = 1024 * 1024;
+
+Console.WriteLine($"payload      {options.PayloadBytes / MiB:F0} MiB in {options.FileCount} file(s), " +
+    $"{options.PieceSize / 1024} KiB pieces");
+Console.WriteLine($"leechers     {options.Leechers}");
+
+var exitCode = 0;
+foreach (var diskBackend in options.DiskBackends)
+{
+    Console.WriteLine();
+    Console.WriteLine($"disk backend {diskBackend}");
+
+    using var swarm = new Swarm(options, diskBackend);
+    try
+    {
+        if (!Report(swarm.Run(), diskBackend))
+        {
+            exitCode = 1;
+        }
+    }
+    catch (TimeoutException ex)
+    {
+        Console.Error.WriteLine(ex.Message);
+        exitCode = 1;
+    }
+
+    if (options.Keep)
+    {
+        Console.WriteLine($"files        {swarm.WorkDirectory}");
+    }
+}
+return exitCode;
+
+// Prints a run's numbers; returns false if a check failed
+bool Report(SwarmResult result, DiskIoBackend diskBackend)
+{
+    var completionTimes = result.CompletionTimes.Order().ToList();
+    Console.WriteLine($"completion   min {completionTimes[0].TotalSeconds:F2} s, " +
+        $"median {completionTimes[completionTimes.Count / 2].TotalSeconds:F2} s, " +
+        $"max {completionTimes[^1].TotalSeconds:F2} s");
+    Console.WriteLine($"throughput   {result.TotalBytes / MiB / result.Duration.TotalSeconds:F1} MiB/s " +
+        "received by all leechers");
+
+    // The in-memory backend does not update libtorrent's disk counters
+    Console.WriteLine(diskBackend == DiskIoBackend.Memory || result.BytesWritten == 0
+        ? "disk writes  not counted by this backend"
+        : $"disk writes  {result.BytesWritten / MiB / result.Duration.TotalSeconds:F1} MiB/s");
+    Console.WriteLine($"cpu          {result.CpuTime.TotalMilliseconds / (result.TotalBytes / MiB):F2} ms per MiB " +
+        "received, seeder and leechers together");
+
+    if (result.StreamMetrics is { } stream)
+    {
+        var firstByte = stream.TimeToFirstByte.HasValue ? $"{stream.TimeToFirstByte.Value.TotalSeconds:F2} s" : "none";
+        Console.WriteLine($"stream       first byte {firstByte}, {stream.StallCount} stalls " +
+            $"({stream.TotalStallDuration.TotalSeconds:F2} s), {stream.DeadlineMisses} deadline misses");
+    }
+    else if (options.Stream)
+    {
+        Console.WriteLine("stream       did not finish reading within the timeout");
+    }
+
+    if (!options.Http)
+    {
+        return true;
+    }
+    if (result.HttpFailures is null)
+    {
+        Console.WriteLine("http         did not finish within the timeout");
+        return false;
+    }
+    foreach (var failure in result.HttpFailures)
+    {
+        Console.WriteLine($"http         FAILED: {failure}");
+    }
+    if (result.HttpFailures.Count == 0)
+    {
+        Console.WriteLine("http         ranges, HEAD and full GET match the seeder");
+    }
+    return result.HttpFailures.Count == 0;
+}
@@ -0,0 +1,180 @@
+using System.Diagnostics;
+using System.Net;
+
+namespace LibtorrentDotNet.SwarmHarness;
+
+/// <summary>
+/// A seeder and a number of leechers in this process, joined over 127.0.0.1 with ConnectPeer. DHT, LSD, UPnP and
+/// NAT-PMP are off and there is no tracker, so a run needs no outside network.
+/// </summary>
+internal sealed class Swarm : IDisposable
+{
+    // libtorrent's disk counters count 16 KiB blocks
+    private const int BlockSize = 16 * 1024;
+
+    private static readonly TimeSpan PollInterval = TimeSpan.FromMilliseconds(50);
+
+    private readonly HarnessOptions options;
+    private readonly DiskIoBackend leecherDiskBackend;
+    private readonly string workDirectory;
+    private readonly List<ITorrentSession> sessions = [];
+
+    public Swarm(HarnessOptions options, DiskIoBackend leecherDiskBackend)
+    {
+        this.options = options;
+        this.leecherDiskBackend = leecherDiskBackend;
+        workDirectory = Path.Combine(Path.GetTempPath(), "LibtorrentDotNet.SwarmHarness", Guid.NewGuid().ToString("N"));
+    }
+
+    /// <summary>
+    /// Gets the directory holding the payload and the leechers' downloads.
+    /// </summary>
+    public string WorkDirectory => workDirectory;
+
+    /// <summary>
+    /// Creates the payload, seeds it, and waits until every leecher has downloaded it.
+    /// </summary>
+    /// <exception cref="TimeoutException">
+    /// Thrown if the leechers did not complete within the configured timeout.
+    /// </exception>
+    public SwarmResult Run()
+    {
+        var sourcePath = Payload.Write(Path.Combine(workDirectory, "seed"), options);
+        var created = TorrentCreator.CreateTorrent(new TorrentCreationOptions(sourcePath)
+        {
+            PieceSize = Optional<int>.Some(options.PieceSize),
+        });
+
+        var seeder = CreateSession(DiskIoBackend.Default);
+        seeder.AddTorrent(created.ToAddRequest());
+        var endPoints = new List<IPEndPoint> { new(IPAddress.Loopback, seeder.GetListenPort()) };
+        WaitUntil(() => seeder.GetTorrentStatuses().Count > 0, Stopwatch.StartNew());
+
+        var process = Process.GetCurrentProcess();
+        var cpuStarted = process.TotalProcessorTime;
+        var clock = Stopwatch.StartNew();
+
+        var leechers = new List<ITorrentSession>(options.Leechers);
+        for (var i = 0; i < options.Leechers; i++)
+        {
+            var leecher = CreateSession(leecherDiskBackend);
+            leecher.AddTorrent(new AddTorrentFromByteArrayRequest(created.TorrentData,
+                Path.Combine(workDirectory, $"leecher{i}")));
+
+            // Each leecher also connects to the ones before it, so pieces spread between leechers as in a real swarm
+            WaitUntil(() => leecher.ConnectPeer(created.Id, endPoints[0]), clock);
+            foreach (var endPoint in endPoints.Skip(1))
+            {
+                leecher.ConnectPeer(created.Id, endPoint);
+            }
+            endPoints.Add(new IPEndPoint(IPAddress.Loopback, leecher.GetListenPort()));
+            leechers.Add(leecher);
+        }
+
+        var streamRead = options.Stream ? Task.Run(() => ReadStream(leechers[0], created.Id)) : null;
+        var httpCheck = options.Http
+            ? HttpCheck.RunAsync(leechers[^1], created.Id, seeder.GetTorrentInfo(created.Id).TorrentFileEntries[0].Path,
+                options.Timeout)
+            : null;
+
+        var completionTimes = new TimeSpan?[leechers.Count];
+        WaitUntil(() =>
+        {
+            for (var i = 0; i < leechers.Count; i++)
+            {
+                if (completionTimes[i] is null && IsComplete(leechers[i].GetTorrentStatus(created.Id)))
+                {
+                    completionTimes[i] = clock.Elapsed;
+                }
+            }
+            return completionTimes.All(time => time is not null);
+        }, clock);
+        var cpuTime = process.TotalProcessorTime - cpuStarted;
+
+        var streamMetrics = streamRead?.Wait(options.Timeout) == true ? streamRead.Result : null;
+        var httpFailures = httpCheck?.Wait(options.Timeout) == true ? httpCheck.Result : null;
+
+        return new SwarmResult(completionTimes.Select(time => time!.Value).ToList(), GetPayloadBytes(sourcePath),
+            cpuTime, GetBytesWritten(leechers), streamMetrics, httpFailures);
+    }
+
+    public void Dispose()
+    {
+        foreach (var session in sessions)
+        {
+            session.Dispose();
+        }
+        sessions.Clear();
+
+        if (!options.Keep && Directory.Exists(workDirectory))
+        {
+            Directory.Delete(workDirectory, true);
+        }
+    }
+
+    private ITorrentSession CreateSession(DiskIoBackend diskBackend)
+    {
+        var config = new TorrentSessionConfig
+        {
+            ListenInterfaces = Optional<string>.Some("127.0.0.1:0"),
+            EnableUpnp = Optional<bool>.Some(false),
+            EnableNatPmp = Optional<bool>.Some(false),
+            EnableLsd = Optional<bool>.Some(false),
+            DiskBackend = diskBackend,
+        };
+        config.DhtSettings.EnableDht = Optional<bool>.Some(false);
+        config.StatsSettings.Enabled = Optional<bool>.Some(true);
+        config.StatsSettings.SamplingInterval = Optional<TimeSpan>.Some(TimeSpan.FromSeconds(1));
+        config.AdvancedSettings.Set("allow_multiple_connections_per_ip", true);
+
+        var session = TorrentSession.Create(config);
+        sessions.Add(session);
+        return session;
+    }
+
+    private static bool IsComplete(TorrentStatus status) =>
+        status.State is TorrentState.Seeding or TorrentState.Finished;
+
+    private TorrentStreamMetrics ReadStream(ITorrentSession leecher, TorrentId torrentId)
+    {
+        using var stream = leecher.StreamFile(torrentId, 0, options.Timeout);
+        var buffer = new byte[64 * 1024];
+        while (stream.Read(buffer, 0, buffer.Length) > 0)
+        {
+        }
+        return stream.GetMetrics();
+    }
+
+    private long GetBytesWritten(IEnumerable<ITorrentSession> leechers)
+    {
+        // The counters are sampled on the session timer, so wait for a sample taken after the last write
+        Thread.Sleep(TimeSpan.FromSeconds(2));
+
+        long blocks = 0;
+        foreach (var leecher in leechers)
+        {
+            if (leecher.GetSessionStatistics()?.TryGetValue("disk.num_blocks_written", out var written) == true)
+            {
+                blocks += written;
+            }
+        }
+        return blocks * BlockSize;
+    }
+
+    private static long GetPayloadBytes(string sourcePath) =>
+        File.Exists(sourcePath)
+            ? new FileInfo(sourcePath).Length
+            : new DirectoryInfo(sourcePath).EnumerateFiles().Sum(file => file.Length);
+
+    private void WaitUntil(Func<bool> condition, Stopwatch clock)
+    {
+        while (!condition())
+        {
+            if (clock.Elapsed > options.Timeout)
+            {
+                throw new TimeoutException($"The swarm did not complete within {options.Timeout.TotalSeconds} s.");
+            }
+            Thread.Sleep(PollInterval);
+        }
+    }
+}
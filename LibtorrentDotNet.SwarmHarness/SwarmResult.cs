@@ -0,0 +1,33 @@
+namespace LibtorrentDotNet.SwarmHarness;
+
+/// <summary>
+/// What a swarm run measured.
+/// </summary>
+/// <param name="CompletionTimes">
+/// How long each leecher took to download the whole payload, counted from when the first leecher was added.
+/// </param>
+/// <param name="PayloadBytes">The size of the payload each leecher downloaded.</param>
+/// <param name="CpuTime">The processor time the whole process used until the last leecher completed.</param>
+/// <param name="BytesWritten">The bytes the leechers' disk backends wrote, from libtorrent's disk counters.</param>
+/// <param name="StreamMetrics">The metrics of the stream the first leecher read, if streaming was enabled.</param>
+/// <param name="HttpFailures">
+/// The HTTP checks that failed, if they were enabled and finished; empty if all passed.
+/// </param>
+internal sealed record SwarmResult(
+    IReadOnlyList<TimeSpan> CompletionTimes,
+    long PayloadBytes,
+    TimeSpan CpuTime,
+    long BytesWritten,
+    TorrentStreamMetrics? StreamMetrics,
+    IReadOnlyList<string>? HttpFailures)
+{
+    /// <summary>
+    /// Gets the time until the last leecher completed.
+    /// </summary>
+    public TimeSpan Duration => CompletionTimes.Max();
+
+    /// <summary>
+    /// Gets the payload bytes all leechers downloaded together.
+    /// </summary>
+    public long TotalBytes => PayloadBytes * CompletionTimes.Count;
+}
@@ -0,0 +1 @@
+#include "AddTorrentOptions.h"
@@ -0,0 +1,149 @@
+#pragma once
+#include "Optional.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents how the files of a torrent are allocated on disk.
+	/// </summary>
+	public enum class TorrentStorageMode
+	{
+		/// <summary>
+		/// Files are created sparse and grow as pieces arrive. This is fast to start, but files downloaded out of
+		/// order can end up fragmented.
+		/// </summary>
+		Sparse,
+
+		/// <summary>
+		/// Files are allocated at their full size before any piece is written, which keeps large files contiguous
+		/// on disk at the cost of a slower start.
+		/// </summary>
+		Allocate
+	};
+
+	/// <summary>
+	/// Represents the priority of a file or piece. Any value between 0 and 7 is valid.
+	/// </summary>
+	public enum class DownloadPriority : Byte
+	{
+		/// <summary>
+		/// The file or piece is not downloaded.
+		/// </summary>
+		DontDownload = 0,
+
+		/// <summary>
+		/// The lowest priority that is still downloaded.
+		/// </summary>
+		Low = 1,
+
+		/// <summary>
+		/// The priority files and pieces have unless set otherwise.
+		/// </summary>
+		Default = 4,
+
+		/// <summary>
+		/// The highest priority.
+		/// </summary>
+		Top = 7
+	};
+
+	/// <summary>
+	/// Represents how many pieces of a torrent added in seed mode are hashed right after it is added, to catch
+	/// missing or corrupt data before peers ask for it. The larger the sample, the smaller the share of corrupt
+	/// pieces that can go unnoticed; see <see cref="SeedVerificationResult::GetDetectionProbability"/>.
+	/// </summary>
+	public ref class SeedVerificationPolicy sealed
+	{
+	public:
+		/// <summary>
+		/// Gets or sets the number of pieces picked at random and hashed. The default is 64, which finds at least
+		/// one bad piece with a probability of about 47% when 1% of the pieces are corrupt, and 99.9% at 10%.
+		/// </summary>
+		property int SampleSize;
+
+		/// <summary>
+		/// Gets or sets the seed of the random piece selection, for a sample that is the same on every run. By
+		/// default a different sample is picked each time.
+		/// </summary>
+		property Optional<int>^ RandomSeed;
+
+		/// <summary>
+		/// Gets or sets whether a torrent whose sample has a bad piece leaves seed mode and checks all of its
+		/// files. The default is true.
+		/// </summary>
+		property bool RecheckOnFailure;
+
+		/// <summary>
+		/// Initializes a new instance of the SeedVerificationPolicy class with default values.
+		/// </summary>
+		SeedVerificationPolicy()
+		{
+			SampleSize = 64;
+			RandomSeed = Optional<int>::None();
+			RecheckOnFailure = true;
+		}
+	};
+
+	/// <summary>
+	/// Represents the options applied to a torrent as it is added to the session.
+	/// </summary>
+	public ref class AddTorrentOptions sealed
+	{
+	public:
+		/// <summary>
+		/// Gets or sets how the files of the torrent are allocated on disk. The default is <see cref="TorrentStorageMode::Sparse"/>.
+		/// </summary>
+		property TorrentStorageMode StorageMode;
+
+		/// <summary>
+		/// Gets or sets whether the torrent is queued, so that it is started and stopped by the session to stay
+		/// within the active limits of <see cref="QueueConfig"/>. A torrent that is not auto managed starts right
+		/// away and stays active. The default is true.
+		/// </summary>
+		property bool AutoManaged;
+
+		/// <summary>
+		/// Gets or sets the initial priority of each file, by file index. Files past the end of the list keep the
+		/// default priority. For magnet links, the priorities are applied once the metadata is received.
+		/// </summary>
+		property IReadOnlyList<DownloadPriority>^ FilePriorities;
+
+		/// <summary>
+		/// Gets or sets the initial priority of each piece, by piece index. Pieces past the end of the list keep the
+		/// default priority. Piece priorities are ignored for magnet links, whose piece count is not known yet.
+		/// </summary>
+		property IReadOnlyList<DownloadPriority>^ PiecePriorities;
+
+		/// <summary>
+		/// Gets or sets whether the files at the save path are trusted to be complete, so the torrent starts seeding
+		/// without checking them first. Each piece is then hashed the first time a peer asks for it, and a piece
+		/// that fails takes the torrent out of seed mode and checks all of its files. Ignored for magnet links.
+		/// The default is false.
+		/// </summary>
+		property bool SeedMode;
+
+		/// <summary>
+		/// Gets or sets how many pieces are hashed up front when the torrent is added in seed mode, or null to rely
+		/// on the hashing of requested pieces alone. The sample is read in the background after the torrent is
+		/// added and its outcome is raised with <see cref="ITorrentSession::SeedVerificationCompleted"/>. Only
+		/// torrents with v1 piece hashes are sampled.
+		/// </summary>
+		property SeedVerificationPolicy^ SeedVerification;
+
+		/// <summary>
+		/// Initializes a new instance of the AddTorrentOptions class with default values.
+		/// </summary>
+		AddTorrentOptions()
+		{
+			StorageMode = TorrentStorageMode::Sparse;
+			AutoManaged = true;
+			FilePriorities = nullptr;
+			PiecePriorities = nullptr;
+			SeedMode = false;
+			SeedVerification = nullptr;
+		}
+	};
+}
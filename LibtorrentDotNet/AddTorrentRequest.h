@@ -1,4 +1,5 @@
 #pragma once
+#include "AddTorrentOptions.h"
 
 using namespace System;
 
@@ -26,14 +27,37 @@ namespace LibtorrentDotNet
             String^ get() { return savePath; }
         }
 
+        /// <summary>
+        /// Gets the options applied to the torrent as it is added.
+        /// </summary>
+        property AddTorrentOptions^ Options
+        {
+            AddTorrentOptions^ get() { return options; }
+        }
+
         /// <summary>
         /// Initializes a new instance of the AddTorrentFromMagnetLinkRequest class.
         /// </summary>
         /// <param name="magnetLink">The magnet link for the torrent.</param>
         /// <param name="savePath">The path where torrent files will be saved.</param>
         /// <exception cref="ArgumentException">Thrown when magnetLink or savePath is null, empty, or invalid.</exception>
-        AddTorrentFromMagnetLinkRequest(String^ magnetLink, String^ savePath)
+        AddTorrentFromMagnetLinkRequest(String^ magnetLink, String^ savePath) :
+            AddTorrentFromMagnetLinkRequest(magnetLink, savePath, gcnew AddTorrentOptions())
         {
+        }
+
+        /// <summary>
+        /// Initializes a new instance of the AddTorrentFromMagnetLinkRequest class.
+        /// </summary>
+        /// <param name="magnetLink">The magnet link for the torrent.</param>
+        /// <param name="savePath">The path where torrent files will be saved.</param>
+        /// <param name="options">The options applied to the torrent as it is added.</param>
+        /// <exception cref="ArgumentNullException">Thrown when options is null.</exception>
+        /// <exception cref="ArgumentException">Thrown when magnetLink or savePath is null, empty, or invalid.</exception>
+        AddTorrentFromMagnetLinkRequest(String^ magnetLink, String^ savePath, AddTorrentOptions^ options)
+        {
+            ArgumentNullException::ThrowIfNull(options, "options");
+
             if (String::IsNullOrWhiteSpace(magnetLink))
                 throw gcnew ArgumentException("Magnet link cannot be null or empty.", "magnetLink");
 
@@ -48,11 +72,13 @@ namespace LibtorrentDotNet
 
             this->magnetLink = magnetLink;
             this->savePath = savePath;
+            this->options = options;
         }
 
     private:
         String^ magnetLink;
         String^ savePath;
+        AddTorrentOptions^ options;
     };
 
     /// <summary>
@@ -77,15 +103,39 @@ namespace LibtorrentDotNet
             String^ get() { return savePath; }
         }
 
+        /// <summary>
+        /// Gets the options applied to the torrent as it is added.
+        /// </summary>
+        property AddTorrentOptions^ Options
+        {
+            AddTorrentOptions^ get() { return options; }
+        }
+
+        /// <summary>
+        /// Initializes a new instance of the AddTorrentFromTorrentFileRequest class.
+        /// </summary>
+        /// <param name="torrentFilePath">The file path of the torrent file.</param>
+        /// <param name="savePath">The path where torrent files will be saved.</param>
+        /// <exception cref="ArgumentException">Thrown when torrentFilePath or savePath is null, empty, or invalid.</exception>
+        /// <exception cref="IO::FileNotFoundException">Thrown when the torrent file does not exist.</exception>
+        AddTorrentFromTorrentFileRequest(String^ torrentFilePath, String^ savePath) :
+            AddTorrentFromTorrentFileRequest(torrentFilePath, savePath, gcnew AddTorrentOptions())
+        {
+        }
+
         /// <summary>
         /// Initializes a new instance of the AddTorrentFromTorrentFileRequest class.
         /// </summary>
         /// <param name="torrentFilePath">The file path of the torrent file.</param>
         /// <param name="savePath">The path where torrent files will be saved.</param>
+        /// <param name="options">The options applied to the torrent as it is added.</param>
+        /// <exception cref="ArgumentNullException">Thrown when options is null.</exception>
         /// <exception cref="ArgumentException">Thrown when torrentFilePath or savePath is null, empty, or invalid.</exception>
         /// <exception cref="IO::FileNotFoundException">Thrown when the torrent file does not exist.</exception>
-        AddTorrentFromTorrentFileRequest(String^ torrentFilePath, String^ savePath)
+        AddTorrentFromTorrentFileRequest(String^ torrentFilePath, String^ savePath, AddTorrentOptions^ options)
         {
+            ArgumentNullException::ThrowIfNull(options, "options");
+
             if (String::IsNullOrWhiteSpace(torrentFilePath))
                 throw gcnew ArgumentException("Torrent file path cannot be null or empty.", "torrentFilePath");
 
@@ -103,11 +153,13 @@ namespace LibtorrentDotNet
 
             this->torrentFilePath = torrentFilePath;
             this->savePath = savePath;
+            this->options = options;
         }
 
     private:
         String^ torrentFilePath;
         String^ savePath;
+        AddTorrentOptions^ options;
     };
 
     /// <summary>
@@ -132,14 +184,37 @@ namespace LibtorrentDotNet
             String^ get() { return savePath; }
         }
 
+        /// <summary>
+        /// Gets the options applied to the torrent as it is added.
+        /// </summary>
+        property AddTorrentOptions^ Options
+        {
+            AddTorrentOptions^ get() { return options; }
+        }
+
         /// <summary>
         /// Initializes a new instance of the AddTorrentFromByteArrayRequest class.
         /// </summary>
         /// <param name="torrentData">The byte array containing the torrent data.</param>
         /// <param name="savePath">The path where torrent files will be saved.</param>
         /// <exception cref="ArgumentException">Thrown when torrentData is null or empty, or when savePath is null, empty, or invalid.</exception>
-        AddTorrentFromByteArrayRequest(array<Byte>^ torrentData, String^ savePath)
+        AddTorrentFromByteArrayRequest(array<Byte>^ torrentData, String^ savePath) :
+            AddTorrentFromByteArrayRequest(torrentData, savePath, gcnew AddTorrentOptions())
         {
+        }
+
+        /// <summary>
+        /// Initializes a new instance of the AddTorrentFromByteArrayRequest class.
+        /// </summary>
+        /// <param name="torrentData">The byte array containing the torrent data.</param>
+        /// <param name="savePath">The path where torrent files will be saved.</param>
+        /// <param name="options">The options applied to the torrent as it is added.</param>
+        /// <exception cref="ArgumentNullException">Thrown when options is null.</exception>
+        /// <exception cref="ArgumentException">Thrown when torrentData is null or empty, or when savePath is null, empty, or invalid.</exception>
+        AddTorrentFromByteArrayRequest(array<Byte>^ torrentData, String^ savePath, AddTorrentOptions^ options)
+        {
+            ArgumentNullException::ThrowIfNull(options, "options");
+
             if (torrentData == nullptr || torrentData->Length == 0)
                 throw gcnew ArgumentException("Torrent data cannot be null or empty.", "torrentData");
 
@@ -151,10 +226,12 @@ namespace LibtorrentDotNet
 
             this->torrentData = torrentData;
             this->savePath = savePath;
+            this->options = options;
         }
 
     private:
         array<Byte>^ torrentData;
         String^ savePath;
+        AddTorrentOptions^ options;
     };
 }
\ No newline at end of file
@@ -0,0 +1 @@
+#include "AlertTrace.h"
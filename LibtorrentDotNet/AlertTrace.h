@@ -0,0 +1,356 @@
+#pragma once
+#include "TorrentFileEntry.h"
+#include "TorrentId.h"
+#include "TorrentInfo.h"
+#include "TorrentOperationEvent.h"
+#include "TorrentState.h"
+#include "TorrentStatus.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+using namespace System::Diagnostics;
+using namespace System::IO;
+using namespace System::Text;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents how fast an alert trace is replayed.
+	/// </summary>
+	public enum class AlertReplaySpeed
+	{
+		/// <summary>
+		/// Alerts are dispatched with the same spacing as when they were recorded.
+		/// </summary>
+		Recorded,
+
+		/// <summary>
+		/// Alerts are dispatched back to back, as fast as the event handlers allow.
+		/// </summary>
+		Maximum
+	};
+
+	/// <summary>
+	/// Represents the outcome of replaying an alert trace.
+	/// </summary>
+	public ref class AlertReplayResult sealed
+	{
+	public:
+		/// <summary>
+		/// Gets the number of alerts read from the trace.
+		/// </summary>
+		property int AlertCount { int get() { return alertCount; } }
+
+		/// <summary>
+		/// Gets the number of alerts that raised an event. Alerts the session only handles internally, such as
+		/// read_piece_alert, are counted in AlertCount but not dispatched.
+		/// </summary>
+		property int DispatchedCount { int get() { return dispatchedCount; } }
+
+		/// <summary>
+		/// Gets the time between the first and the last alert when the trace was recorded.
+		/// </summary>
+		property TimeSpan RecordedDuration { TimeSpan get() { return recordedDuration; } }
+
+		/// <summary>
+		/// Gets the time the replay took.
+		/// </summary>
+		property TimeSpan Elapsed { TimeSpan get() { return elapsed; } }
+
+	internal:
+		AlertReplayResult(const int alertCount, const int dispatchedCount, const TimeSpan recordedDuration,
+			const TimeSpan elapsed) : alertCount(alertCount), dispatchedCount(dispatchedCount),
+			recordedDuration(recordedDuration), elapsed(elapsed)
+		{
+		}
+
+	private:
+		int alertCount;
+		int dispatchedCount;
+		TimeSpan recordedDuration;
+		TimeSpan elapsed;
+	};
+
+	/// <summary>
+	/// Identifies the payload of a record in an alert trace.
+	/// </summary>
+	enum class AlertTraceKind : Byte
+	{
+		Other,
+		Operation,
+		Error,
+		StateUpdate,
+		MetadataReceived
+	};
+
+	/// <summary>
+	/// Represents one alert read from an alert trace, with the managed payload the session raised for it.
+	/// </summary>
+	ref class AlertTraceRecord sealed
+	{
+	internal:
+		AlertTraceKind Kind;
+		int AlertType;
+		TimeSpan Timestamp;
+		TorrentId^ Id;
+		TorrentOperationEvent OperationEvent;
+		String^ Error;
+		IReadOnlyList<TorrentStatus^>^ Statuses;
+		TorrentInfo^ Info;
+	};
+
+	/// <summary>
+	/// Writes the alerts popped by the session to a compact binary trace. Each record holds the kind of payload,
+	/// libtorrent's alert type, the time since the previous record and the payload the session raised an event
+	/// with. Integers are 7-bit encoded and info hashes are stored as raw bytes.
+	/// </summary>
+	ref class AlertTraceWriter sealed
+	{
+		BinaryWriter^ writer;
+		Stopwatch^ clock;
+		TimeSpan lastTimestamp;
+
+	internal:
+		/// <summary>
+		/// The bytes every trace starts with, followed by the format version.
+		/// </summary>
+		static initonly array<Byte>^ Magic = gcnew array<Byte>{ 0x4C, 0x54, 0x41, 0x54 }; // "LTAT"
+
+		static const Byte Version = 1;
+
+		/// <summary>
+		/// Initializes a new instance of the AlertTraceWriter class and writes the trace header.
+		/// </summary>
+		/// <param name="output">The stream to write to. It is left open.</param>
+		AlertTraceWriter(Stream^ output) : writer(gcnew BinaryWriter(output, Encoding::UTF8, true)),
+			clock(Stopwatch::StartNew()), lastTimestamp(TimeSpan::Zero)
+		{
+			writer->Write(Magic);
+			writer->Write(Version);
+		}
+
+		void WriteOther(const int alertType)
+		{
+			WriteHeader(AlertTraceKind::Other, alertType);
+		}
+
+		void WriteOperation(const int alertType, TorrentId^ torrentId, const TorrentOperationEvent operationEvent)
+		{
+			WriteHeader(AlertTraceKind::Operation, alertType);
+			WriteTorrentId(torrentId);
+			writer->Write(static_cast<Byte>(operationEvent));
+		}
+
+		void WriteError(const int alertType, TorrentId^ torrentId, String^ error)
+		{
+			WriteHeader(AlertTraceKind::Error, alertType);
+			WriteTorrentId(torrentId);
+			writer->Write(error);
+		}
+
+		void WriteStateUpdate(const int alertType, IReadOnlyList<TorrentStatus^>^ statuses)
+		{
+			WriteHeader(AlertTraceKind::StateUpdate, alertType);
+			writer->Write7BitEncodedInt(statuses->Count);
+			for each (auto status in statuses)
+			{
+				WriteStatus(status);
+			}
+		}
+
+		void WriteMetadataReceived(const int alertType, TorrentInfo^ info)
+		{
+			WriteHeader(AlertTraceKind::MetadataReceived, alertType);
+			WriteTorrentId(info->Id);
+			writer->Write(info->Name);
+			writer->Write(info->SavePath);
+			writer->Write7BitEncodedInt64(info->TotalSize);
+			WriteStatus(info->Status);
+			writer->Write7BitEncodedInt(info->TorrentFileEntries->Count);
+			for each (auto file in info->TorrentFileEntries)
+			{
+				writer->Write7BitEncodedInt(file->FileIndex);
+				writer->Write(file->Path);
+				writer->Write(file->Name);
+				writer->Write7BitEncodedInt64(static_cast<Int64>(file->Size));
+			}
+		}
+
+		void Flush()
+		{
+			writer->Flush();
+		}
+
+	private:
+		void WriteHeader(const AlertTraceKind kind, const int alertType)
+		{
+			const auto timestamp = clock->Elapsed;
+			writer->Write(static_cast<Byte>(kind));
+			writer->Write7BitEncodedInt(alertType);
+			writer->Write7BitEncodedInt64((timestamp - lastTimestamp).Ticks);
+			lastTimestamp = timestamp;
+		}
+
+		void WriteTorrentId(TorrentId^ torrentId)
+		{
+			const auto hash = Convert::FromHexString(torrentId->ToString());
+			writer->Write(static_cast<Byte>(hash->Length));
+			writer->Write(hash);
+		}
+
+		void WriteStatus(TorrentStatus^ status)
+		{
+			WriteTorrentId(status->Id);
+			writer->Write(static_cast<Byte>(status->State));
+			writer->Write(status->Progress);
+			writer->Write7BitEncodedInt64(status->TotalDownload);
+			writer->Write7BitEncodedInt64(status->TotalUpload);
+			writer->Write7BitEncodedInt(status->DownloadRate);
+			writer->Write7BitEncodedInt(status->UploadRate);
+			writer->Write7BitEncodedInt(status->NumPeers);
+			writer->Write7BitEncodedInt(status->NumSeeds);
+			writer->Write7BitEncodedInt(status->QueuePosition);
+		}
+	};
+
+	/// <summary>
+	/// Reads the records of a trace written by <see cref="AlertTraceWriter"/>.
+	/// </summary>
+	ref class AlertTraceReader sealed
+	{
+		BinaryReader^ reader;
+		TimeSpan timestamp;
+
+	internal:
+		/// <summary>
+		/// Initializes a new instance of the AlertTraceReader class and checks the trace header.
+		/// </summary>
+		/// <param name="input">The stream to read from. It is left open.</param>
+		/// <exception cref="InvalidDataException">Thrown if the stream does not start with an alert trace header.</exception>
+		AlertTraceReader(Stream^ input) : reader(gcnew BinaryReader(input, Encoding::UTF8, true)),
+			timestamp(TimeSpan::Zero)
+		{
+			const auto magic = reader->ReadBytes(AlertTraceWriter::Magic->Length);
+			bool isTrace = magic->Length == AlertTraceWriter::Magic->Length;
+			for (int i = 0; isTrace && i < magic->Length; i++)
+			{
+				isTrace = magic[i] == AlertTraceWriter::Magic[i];
+			}
+
+			if (!isTrace)
+			{
+				throw gcnew InvalidDataException("The stream is not an alert trace.");
+			}
+
+			if (const auto version = reader->ReadByte(); version != AlertTraceWriter::Version)
+			{
+				throw gcnew InvalidDataException(String::Format("Unsupported alert trace version {0}.", version));
+			}
+		}
+
+		/// <summary>
+		/// Reads the next record.
+		/// </summary>
+		/// <returns>The record, or null at the end of the trace.</returns>
+		/// <exception cref="InvalidDataException">Thrown if the trace is corrupt.</exception>
+		AlertTraceRecord^ Read()
+		{
+			const int kind = reader->BaseStream->ReadByte();
+			if (kind < 0)
+			{
+				return nullptr;
+			}
+
+			try
+			{
+				auto record = gcnew AlertTraceRecord();
+				record->Kind = static_cast<AlertTraceKind>(kind);
+				record->AlertType = reader->Read7BitEncodedInt();
+				timestamp += TimeSpan::FromTicks(reader->Read7BitEncodedInt64());
+				record->Timestamp = timestamp;
+
+				switch (record->Kind)
+				{
+				case AlertTraceKind::Other:
+					break;
+				case AlertTraceKind::Operation:
+					record->Id = ReadTorrentId();
+					record->OperationEvent = static_cast<TorrentOperationEvent>(reader->ReadByte());
+					break;
+				case AlertTraceKind::Error:
+					record->Id = ReadTorrentId();
+					record->Error = reader->ReadString();
+					break;
+				case AlertTraceKind::StateUpdate:
+					{
+						const int count = reader->Read7BitEncodedInt();
+						auto statuses = gcnew List<TorrentStatus^>(count);
+						for (int i = 0; i < count; i++)
+						{
+							statuses->Add(ReadStatus());
+						}
+						record->Statuses = statuses;
+					}
+					break;
+				case AlertTraceKind::MetadataReceived:
+					record->Info = ReadTorrentInfo();
+					break;
+				default:
+					throw gcnew InvalidDataException(String::Format("Unknown alert trace record kind {0}.", kind));
+				}
+
+				return record;
+			}
+			catch (EndOfStreamException^ e)
+			{
+				throw gcnew InvalidDataException("The alert trace ends in the middle of a record.", e);
+			}
+		}
+
+	private:
+		TorrentId^ ReadTorrentId()
+		{
+			const int length = reader->ReadByte();
+			return gcnew TorrentId(Convert::ToHexString(reader->ReadBytes(length)));
+		}
+
+		TorrentStatus^ ReadStatus()
+		{
+			auto torrentId = ReadTorrentId();
+			const auto state = static_cast<TorrentState>(reader->ReadByte());
+			const auto progress = reader->ReadDouble();
+			const auto totalDownload = reader->Read7BitEncodedInt64();
+			const auto totalUpload = reader->Read7BitEncodedInt64();
+			const auto downloadRate = reader->Read7BitEncodedInt();
+			const auto uploadRate = reader->Read7BitEncodedInt();
+			const auto numPeers = reader->Read7BitEncodedInt();
+			const auto numSeeds = reader->Read7BitEncodedInt();
+			const auto queuePosition = reader->Read7BitEncodedInt();
+
+			return gcnew TorrentStatus(torrentId, state, progress, totalDownload, totalUpload, downloadRate,
+				uploadRate, numPeers, numSeeds, queuePosition);
+		}
+
+		TorrentInfo^ ReadTorrentInfo()
+		{
+			auto torrentId = ReadTorrentId();
+			auto name = reader->ReadString();
+			auto savePath = reader->ReadString();
+			const auto totalSize = reader->Read7BitEncodedInt64();
+			auto status = ReadStatus();
+
+			const int fileCount = reader->Read7BitEncodedInt();
+			auto files = gcnew List<TorrentFileEntry^>(fileCount);
+			for (int i = 0; i < fileCount; i++)
+			{
+				const int fileIndex = reader->Read7BitEncodedInt();
+				auto path = reader->ReadString();
+				auto fileName = reader->ReadString();
+				const auto size = static_cast<UInt64>(reader->Read7BitEncodedInt64());
+				files->Add(gcnew TorrentFileEntry(fileIndex, path, fileName, size));
+			}
+
+			return gcnew TorrentInfo(torrentId, name, status, files, totalSize, savePath);
+		}
+	};
+}
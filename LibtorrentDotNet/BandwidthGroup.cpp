@@ -0,0 +1 @@
+#include "BandwidthGroup.h"
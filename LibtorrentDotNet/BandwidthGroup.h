@@ -0,0 +1,59 @@
+#pragma once
+#include "Optional.h"
+
+using namespace System;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents a named tier of torrents, such as "premium" or "archive", that shares one aggregate rate limit.
+	/// </summary>
+	public ref class BandwidthGroup sealed
+	{
+	public:
+		/// <summary>
+		/// Gets the name that identifies the group.
+		/// </summary>
+		property String^ Name
+		{
+			String^ get() { return name; }
+		}
+
+		/// <summary>
+		/// Gets or sets the combined download rate limit of the torrents in the group, in bytes per second.
+		/// The default is no limit.
+		/// </summary>
+		property Optional<int>^ DownloadRateLimit;
+
+		/// <summary>
+		/// Gets or sets the combined upload rate limit of the torrents in the group, in bytes per second.
+		/// The default is no limit.
+		/// </summary>
+		property Optional<int>^ UploadRateLimit;
+
+		/// <summary>
+		/// Gets or sets the weight of the group when the session-wide rate limit is divided between groups.
+		/// A group with weight 2 gets twice the share of a group with weight 1. The default is 1.
+		/// </summary>
+		property int Weight;
+
+		/// <summary>
+		/// Initializes a new instance of the BandwidthGroup class with no limits.
+		/// </summary>
+		/// <param name="name">The name that identifies the group.</param>
+		/// <exception cref="ArgumentException">Thrown when name is null or empty.</exception>
+		BandwidthGroup(String^ name)
+		{
+			if (String::IsNullOrWhiteSpace(name))
+				throw gcnew ArgumentException("Group name cannot be null or empty.", "name");
+
+			this->name = name;
+			DownloadRateLimit = Optional<int>::None();
+			UploadRateLimit = Optional<int>::None();
+			Weight = 1;
+		}
+
+	private:
+		String^ name;
+	};
+}
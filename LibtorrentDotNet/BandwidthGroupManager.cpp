@@ -0,0 +1 @@
+#include "BandwidthGroupManager.h"
@@ -0,0 +1,561 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/info_hash.hpp>
+#include <libtorrent/session.hpp>
+#include <libtorrent/settings_pack.hpp>
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/torrent_status.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// The group a torrent belongs to, the limits it had before joining it and the limits the group gave it.
+	/// </summary>
+	struct BandwidthGroupMember
+	{
+		int groupId;
+		int previousDownloadLimit;
+		int previousUploadLimit;
+		int downloadAllocation;
+		int uploadAllocation;
+	};
+
+	inline std::vector<libtorrent::torrent_status> GetAllTorrentStatuses(const libtorrent::session& session)
+	{
+		return session.get_torrent_status([](const libtorrent::torrent_status&) { return true; });
+	}
+}
+#pragma managed(pop)
+
+#include "BandwidthGroup.h"
+#include "StreamingBandwidthScheduler.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+using namespace System::Threading;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Enforces the aggregate rate limits of bandwidth groups. libtorrent 2.x cannot assign peer classes to a torrent
+	/// through its public API, so each group's limit is divided into per-torrent limits instead, and redistributed
+	/// every tick: torrents that leave part of their share unused keep what they use plus some headroom, and the
+	/// rest is split evenly between the others. When the session has a global rate limit, it is divided between
+	/// the groups by weight in the same way.
+	/// </summary>
+	ref class BandwidthGroupManager sealed
+	{
+		static initonly Int32 MinimumRateLimit = 1024;
+		static initonly double UnusedShareThreshold = 0.9;
+		static initonly double Headroom = 1.2;
+
+		ref class GroupState sealed
+		{
+		public:
+			int id;
+			int downloadLimit;
+			int uploadLimit;
+			int weight;
+		};
+
+		Dictionary<String^, GroupState^>^ groups;
+		int nextGroupId;
+		std::unordered_map<libtorrent::info_hash_t, BandwidthGroupMember>* members;
+		Object^ syncRoot;
+
+	internal:
+		BandwidthGroupManager() :
+			groups(gcnew Dictionary<String^, GroupState^>(StringComparer::Ordinal)),
+			nextGroupId(0),
+			members(new std::unordered_map<libtorrent::info_hash_t, BandwidthGroupMember>()),
+			syncRoot(gcnew Object())
+		{
+		}
+
+		~BandwidthGroupManager()
+		{
+			this->!BandwidthGroupManager();
+		}
+
+		!BandwidthGroupManager()
+		{
+			if (members != nullptr)
+			{
+				delete members;
+				members = nullptr;
+			}
+		}
+
+		/// <summary>
+		/// Creates a group or replaces the limits and weight of an existing group with the same name.
+		/// </summary>
+		void SetGroup(BandwidthGroup^ group)
+		{
+			if (group->Weight < 1)
+			{
+				throw gcnew ArgumentOutOfRangeException("group", group->Weight, "The weight must be at least 1.");
+			}
+
+			Monitor::Enter(syncRoot);
+			try
+			{
+				GroupState^ state;
+				if (!groups->TryGetValue(group->Name, state))
+				{
+					state = gcnew GroupState();
+					state->id = nextGroupId++;
+					groups->Add(group->Name, state);
+				}
+
+				state->downloadLimit = group->DownloadRateLimit->GetValueOrDefault(-1);
+				state->uploadLimit = group->UploadRateLimit->GetValueOrDefault(-1);
+				state->weight = group->Weight;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Removes a group and gives its torrents back the limits they had before joining it.
+		/// </summary>
+		/// <returns>true if the group existed.</returns>
+		bool RemoveGroup(libtorrent::session* session, String^ name)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				GroupState^ state;
+				if (!groups->TryGetValue(name, state))
+				{
+					return false;
+				}
+
+				groups->Remove(name);
+				for (auto member = members->begin(); member != members->end();)
+				{
+					if (member->second.groupId == state->id)
+					{
+						RestoreLimits(session, member->first, member->second);
+						member = members->erase(member);
+					}
+					else
+					{
+						++member;
+					}
+				}
+				return true;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Moves torrents into a group, or out of their group when no group name is given. Their limits are taken over
+		/// by the group on the next tick.
+		/// </summary>
+		/// <returns>The number of torrents that were found in the session.</returns>
+		int Assign(libtorrent::session* session, const std::vector<libtorrent::torrent_handle>& handles, String^ name)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				GroupState^ state = nullptr;
+				if (name != nullptr && !groups->TryGetValue(name, state))
+				{
+					throw gcnew ArgumentException(String::Format("Unknown bandwidth group '{0}'.", name), "groupName");
+				}
+
+				for (const auto& handle : handles)
+				{
+					const auto& infoHash = handle.info_hashes();
+					const auto member = members->find(infoHash);
+
+					if (state == nullptr)
+					{
+						if (member != members->end())
+						{
+							RestoreLimits(session, infoHash, member->second);
+							members->erase(member);
+						}
+					}
+					else if (member != members->end())
+					{
+						member->second.groupId = state->id;
+					}
+					else
+					{
+						BandwidthGroupMember joined{};
+						joined.groupId = state->id;
+						joined.previousDownloadLimit = handle.download_limit();
+						joined.previousUploadLimit = handle.upload_limit();
+						joined.downloadAllocation = joined.previousDownloadLimit;
+						joined.uploadAllocation = joined.previousUploadLimit;
+						members->emplace(infoHash, joined);
+					}
+				}
+
+				return static_cast<int>(handles.size());
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Replaces the download limit a grouped torrent returns to once it leaves its group.
+		/// </summary>
+		/// <returns>true if the torrent is in a group and the new limit was deferred.</returns>
+		bool DeferDownloadLimit(const libtorrent::info_hash_t& infoHash, const int downloadLimit)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				const auto member = members->find(infoHash);
+				if (member == members->end())
+				{
+					return false;
+				}
+
+				member->second.previousDownloadLimit = downloadLimit;
+				return true;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Replaces the upload limit a grouped torrent returns to once it leaves its group.
+		/// </summary>
+		/// <returns>true if the torrent is in a group and the new limit was deferred.</returns>
+		bool DeferUploadLimit(const libtorrent::info_hash_t& infoHash, const int uploadLimit)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				const auto member = members->find(infoHash);
+				if (member == members->end())
+				{
+					return false;
+				}
+
+				member->second.previousUploadLimit = uploadLimit;
+				return true;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Redistributes the limit of every group between its torrents based on what they used since the last tick.
+		/// Torrents the streaming scheduler is throttling are left alone.
+		/// </summary>
+		void Rebalance(libtorrent::session* session, StreamingBandwidthScheduler^ streamingScheduler)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				if (members->empty())
+				{
+					return;
+				}
+
+				const auto& settings = session->get_settings();
+				const int sessionDownloadLimit = settings.get_int(libtorrent::settings_pack::download_rate_limit);
+				const int sessionUploadLimit = settings.get_int(libtorrent::settings_pack::upload_rate_limit);
+
+				std::vector<libtorrent::torrent_status> samples;
+				std::vector<BandwidthGroupMember*> sampledMembers;
+				for (auto& status : GetAllTorrentStatuses(*session))
+				{
+					if (const auto member = members->find(status.info_hashes); member != members->end())
+					{
+						samples.push_back(std::move(status));
+						sampledMembers.push_back(&member->second);
+					}
+				}
+
+				// Forget torrents that were removed from the session
+				if (samples.size() < members->size())
+				{
+					std::unordered_map<libtorrent::info_hash_t, BandwidthGroupMember> present;
+					for (size_t i = 0; i < samples.size(); i++)
+					{
+						present.emplace(samples[i].info_hashes, *sampledMembers[i]);
+					}
+					members->swap(present);
+					for (size_t i = 0; i < samples.size(); i++)
+					{
+						sampledMembers[i] = &members->at(samples[i].info_hashes);
+					}
+				}
+
+				const int sampleCount = static_cast<int>(samples.size());
+
+				// A group without live torrents would take a weighted slice of the session limit that nobody can use
+				auto liveGroupIds = gcnew HashSet<int>();
+				for (int i = 0; i < sampleCount; i++)
+				{
+					liveGroupIds->Add(sampledMembers[i]->groupId);
+				}
+				auto groupList = gcnew List<GroupState^>(groups->Count);
+				for each (auto group in groups->Values)
+				{
+					if (liveGroupIds->Contains(group->id))
+					{
+						groupList->Add(group);
+					}
+				}
+
+				for (int direction = 0; direction < 2; direction++)
+				{
+					const bool download = direction == 0;
+					auto allocations = gcnew array<double>(sampleCount);
+					auto groupDemands = gcnew List<double>(groupList->Count);
+					auto groupWeights = gcnew List<double>(groupList->Count);
+					auto groupCaps = gcnew List<double>(groupList->Count);
+
+					for each (auto group in groupList)
+					{
+						double demand = 0;
+						for (int i = 0; i < sampleCount; i++)
+						{
+							if (sampledMembers[i]->groupId == group->id)
+							{
+								demand += EstimateDemand(download ? samples[i].download_rate : samples[i].upload_rate,
+									download ? sampledMembers[i]->downloadAllocation : sampledMembers[i]->uploadAllocation);
+							}
+						}
+						const int groupLimit = download ? group->downloadLimit : group->uploadLimit;
+						groupDemands->Add(groupLimit > 0 ? Math::Min(demand, static_cast<double>(groupLimit)) : demand);
+						groupWeights->Add(group->weight);
+						groupCaps->Add(groupLimit > 0 ? groupLimit : Double::PositiveInfinity);
+					}
+
+					const int sessionLimit = download ? sessionDownloadLimit : sessionUploadLimit;
+					auto groupCapacities = sessionLimit > 0
+						? Distribute(sessionLimit, groupDemands, groupWeights, groupCaps)
+						: gcnew array<double>(groupList->Count);
+					if (sessionLimit <= 0)
+					{
+						for (int g = 0; g < groupList->Count; g++)
+						{
+							const int groupLimit = download ? groupList[g]->downloadLimit : groupList[g]->uploadLimit;
+							groupCapacities[g] = groupLimit > 0 ? groupLimit : Double::PositiveInfinity;
+						}
+					}
+
+					for (int g = 0; g < groupList->Count; g++)
+					{
+						auto memberIndices = gcnew List<int>();
+						auto memberDemands = gcnew List<double>();
+						auto memberWeights = gcnew List<double>();
+						for (int i = 0; i < sampleCount; i++)
+						{
+							if (sampledMembers[i]->groupId == groupList[g]->id)
+							{
+								memberIndices->Add(i);
+								memberDemands->Add(EstimateDemand(
+									download ? samples[i].download_rate : samples[i].upload_rate,
+									download ? sampledMembers[i]->downloadAllocation : sampledMembers[i]->uploadAllocation));
+								memberWeights->Add(1);
+							}
+						}
+
+						auto memberAllocations = Distribute(groupCapacities[g], memberDemands, memberWeights, nullptr);
+						for (int m = 0; m < memberIndices->Count; m++)
+						{
+							allocations[memberIndices[m]] = memberAllocations[m];
+						}
+					}
+
+					for (int i = 0; i < sampleCount; i++)
+					{
+						const int limit = Double::IsPositiveInfinity(allocations[i])
+							? -1
+							: static_cast<int>(Math::Max(static_cast<double>(MinimumRateLimit), allocations[i]));
+						int& applied = download ? sampledMembers[i]->downloadAllocation : sampledMembers[i]->uploadAllocation;
+
+						if (limit == applied || streamingScheduler->IsThrottled(samples[i].info_hashes))
+						{
+							continue;
+						}
+
+						if (download)
+						{
+							samples[i].handle.set_download_limit(limit);
+						}
+						else
+						{
+							samples[i].handle.set_upload_limit(limit);
+						}
+						applied = limit;
+					}
+				}
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+	private:
+		/// <summary>
+		/// Estimates how much a torrent would use: what it uses plus headroom if it left part of its share unused,
+		/// otherwise as much as it can get.
+		/// </summary>
+		static double EstimateDemand(const int rate, const int allocation)
+		{
+			if (allocation > 0 && rate < allocation * UnusedShareThreshold)
+			{
+				return rate * Headroom + MinimumRateLimit;
+			}
+
+			return Double::PositiveInfinity;
+		}
+
+		/// <summary>
+		/// Divides a capacity by weight, giving no one more than their demand and splitting what they leave over
+		/// between the others (weighted max-min fairness). Capacity nobody asks for is spread by weight over those
+		/// below their cap so that the whole limit stays usable; what no one may take stays unallocated.
+		/// </summary>
+		/// <param name="caps">The most each may get, or nullptr if nobody is capped.</param>
+		static array<double>^ Distribute(const double capacity, List<double>^ demands, List<double>^ weights,
+			List<double>^ caps)
+		{
+			auto allocations = gcnew array<double>(demands->Count);
+			if (Double::IsPositiveInfinity(capacity))
+			{
+				Array::Fill(allocations, Double::PositiveInfinity);
+				return allocations;
+			}
+
+			auto open = gcnew List<int>(demands->Count);
+			for (int i = 0; i < demands->Count; i++)
+			{
+				open->Add(i);
+			}
+
+			double remaining = capacity;
+			while (open->Count > 0)
+			{
+				double totalWeight = 0;
+				for each (int i in open)
+				{
+					totalWeight += weights[i];
+				}
+
+				// Settle everyone who needs less than their share and go around again with what they leave
+				auto satisfied = open->FindAll(gcnew Predicate<int>(gcnew DemandCheck(demands, weights, remaining, totalWeight),
+					&DemandCheck::IsSatisfied));
+				if (satisfied->Count == 0)
+				{
+					for each (int i in open)
+					{
+						allocations[i] = remaining * weights[i] / totalWeight;
+					}
+					break;
+				}
+
+				for each (int i in satisfied)
+				{
+					allocations[i] = demands[i];
+					remaining -= demands[i];
+					open->Remove(i);
+				}
+			}
+
+			if (open->Count > 0)
+			{
+				return allocations;
+			}
+
+			// Everyone is satisfied. Hand out the surplus, settling anyone it would take past their cap and going
+			// around again with what they leave.
+			auto uncapped = gcnew List<int>(allocations->Length);
+			for (int i = 0; i < allocations->Length; i++)
+			{
+				if (caps == nullptr || allocations[i] < caps[i])
+				{
+					uncapped->Add(i);
+				}
+			}
+
+			while (remaining > 0 && uncapped->Count > 0)
+			{
+				double totalWeight = 0;
+				for each (int i in uncapped)
+				{
+					totalWeight += weights[i];
+				}
+
+				auto capped = gcnew List<int>();
+				for each (int i in uncapped)
+				{
+					if (caps != nullptr && allocations[i] + remaining * weights[i] / totalWeight >= caps[i])
+					{
+						capped->Add(i);
+					}
+				}
+				if (capped->Count == 0)
+				{
+					for each (int i in uncapped)
+					{
+						allocations[i] += remaining * weights[i] / totalWeight;
+					}
+					break;
+				}
+
+				for each (int i in capped)
+				{
+					remaining -= caps[i] - allocations[i];
+					allocations[i] = caps[i];
+					uncapped->Remove(i);
+				}
+			}
+
+			return allocations;
+		}
+
+		ref class DemandCheck sealed
+		{
+			List<double>^ demands;
+			List<double>^ weights;
+			double remaining;
+			double totalWeight;
+
+		public:
+			DemandCheck(List<double>^ demands, List<double>^ weights, const double remaining, const double totalWeight) :
+				demands(demands), weights(weights), remaining(remaining), totalWeight(totalWeight)
+			{
+			}
+
+			bool IsSatisfied(int i)
+			{
+				return demands[i] <= remaining * weights[i] / totalWeight;
+			}
+		};
+
+		static void RestoreLimits(libtorrent::session* session, const libtorrent::info_hash_t& infoHash,
+			const BandwidthGroupMember& member)
+		{
+			// Removing a torrent from the session discards its limits, so a removed member has nothing to restore
+			if (const auto& handle = session->find_torrent(infoHash.get_best()); handle.is_valid())
+			{
+				handle.set_download_limit(member.previousDownloadLimit);
+				handle.set_upload_limit(member.previousUploadLimit);
+			}
+		}
+	};
+}
@@ -0,0 +1 @@
+#include "LatencyReport.h"
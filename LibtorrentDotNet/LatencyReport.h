@@ -0,0 +1,277 @@
+#pragma once
+
+using namespace System;
+using namespace System::Collections::Generic;
+using namespace System::Diagnostics;
+using namespace System::Numerics;
+using namespace System::Threading;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Maps durations, in Stopwatch ticks, to log-linear buckets in the style of an HDR histogram: every power of two
+	/// is split into 16 linear buckets, which keeps the error below 1/16 of the value at any magnitude.
+	/// </summary>
+	ref class LatencyBuckets abstract sealed
+	{
+		static const int SubBucketBits = 5;
+		static const int SubBucketCount = 1 << SubBucketBits;
+		static const int SubBucketHalfCount = SubBucketCount / 2;
+
+	internal:
+		/// <summary>
+		/// The number of buckets needed to cover every non-negative Int64.
+		/// </summary>
+		static const int Count = SubBucketCount + (64 - SubBucketBits) * SubBucketHalfCount;
+
+		/// <summary>
+		/// Gets the highest duration that falls into a bucket.
+		/// </summary>
+		static Int64 UpperBound(const int index)
+		{
+			if (index < SubBucketCount)
+			{
+				return index;
+			}
+
+			const int shift = (index - SubBucketCount) / SubBucketHalfCount + 1;
+			const Int64 subBucket = (index - SubBucketCount) % SubBucketHalfCount + SubBucketHalfCount;
+			return ((subBucket + 1) << shift) - 1;
+		}
+
+		/// <summary>
+		/// Gets the bucket a duration falls into.
+		/// </summary>
+		static int IndexOf(const Int64 value)
+		{
+			if (value < SubBucketCount)
+			{
+				return static_cast<int>(value);
+			}
+
+			const int shift = 63 - BitOperations::LeadingZeroCount(static_cast<UInt64>(value)) - (SubBucketBits - 1);
+			const int subBucket = static_cast<int>(value >> shift);
+			return SubBucketCount + (shift - 1) * SubBucketHalfCount + (subBucket - SubBucketHalfCount);
+		}
+	};
+
+	/// <summary>
+	/// Represents a snapshot of the latency distribution of one operation.
+	/// </summary>
+	public ref class LatencyStatistics sealed
+	{
+	public:
+		/// <summary>
+		/// Gets the name of the measured operation.
+		/// </summary>
+		property String^ Name { String^ get() { return name; } }
+
+		/// <summary>
+		/// Gets the number of recorded calls.
+		/// </summary>
+		property Int64 Count { Int64 get() { return count; } }
+
+		/// <summary>
+		/// Gets the fastest recorded call, or zero if none was recorded.
+		/// </summary>
+		property TimeSpan Min { TimeSpan get() { return FromTicks(count > 0 ? min : 0); } }
+
+		/// <summary>
+		/// Gets the slowest recorded call.
+		/// </summary>
+		property TimeSpan Max { TimeSpan get() { return FromTicks(max); } }
+
+		/// <summary>
+		/// Gets the mean duration of the recorded calls.
+		/// </summary>
+		property TimeSpan Mean { TimeSpan get() { return FromTicks(count > 0 ? sum / count : 0); } }
+
+		/// <summary>
+		/// Gets the median duration.
+		/// </summary>
+		property TimeSpan P50 { TimeSpan get() { return GetPercentile(50); } }
+
+		/// <summary>
+		/// Gets the 90th percentile duration.
+		/// </summary>
+		property TimeSpan P90 { TimeSpan get() { return GetPercentile(90); } }
+
+		/// <summary>
+		/// Gets the 99th percentile duration.
+		/// </summary>
+		property TimeSpan P99 { TimeSpan get() { return GetPercentile(99); } }
+
+		/// <summary>
+		/// Gets the 99.9th percentile duration.
+		/// </summary>
+		property TimeSpan P999 { TimeSpan get() { return GetPercentile(99.9); } }
+
+		/// <summary>
+		/// Gets the duration that the given percentage of the recorded calls did not exceed. The result is accurate
+		/// to within 1/16 of the value.
+		/// </summary>
+		/// <param name="percentile">The percentile, from 0 to 100.</param>
+		/// <exception cref="ArgumentOutOfRangeException">Thrown if percentile is not between 0 and 100.</exception>
+		TimeSpan GetPercentile(double percentile)
+		{
+			if (!(percentile >= 0 && percentile <= 100))
+			{
+				throw gcnew ArgumentOutOfRangeException("percentile", "Percentile must be between 0 and 100.");
+			}
+
+			if (count == 0)
+			{
+				return TimeSpan::Zero;
+			}
+
+			const auto rank = Math::Max(1LL, static_cast<Int64>(Math::Ceiling(percentile / 100 * count)));
+			Int64 seen = 0;
+			for (int i = 0; i < buckets->Length; i++)
+			{
+				seen += buckets[i];
+				if (seen >= rank)
+				{
+					return FromTicks(Math::Min(max, Math::Max(min, LatencyBuckets::UpperBound(i))));
+				}
+			}
+			return FromTicks(max);
+		}
+
+	internal:
+		LatencyStatistics(String^ name, array<Int64>^ buckets, const Int64 count, const Int64 sum, const Int64 min,
+			const Int64 max) : name(name), buckets(buckets), count(count), sum(sum), min(min), max(max)
+		{
+		}
+
+	private:
+		String^ name;
+		array<Int64>^ buckets;
+		Int64 count;
+		Int64 sum;
+		Int64 min;
+		Int64 max;
+
+		static TimeSpan FromTicks(const Int64 timestamp)
+		{
+			return TimeSpan::FromTicks(static_cast<Int64>(timestamp * (static_cast<double>(TimeSpan::TicksPerSecond) /
+				Stopwatch::Frequency)));
+		}
+	};
+
+	/// <summary>
+	/// Records durations into <see cref="LatencyBuckets"/>. Recording is lock-free and can be done from any thread.
+	/// </summary>
+	ref class LatencyHistogram sealed
+	{
+		String^ name;
+		array<Int64>^ buckets;
+		Int64 sum;
+		Int64 min;
+		Int64 max;
+
+	internal:
+		LatencyHistogram(String^ name) : name(name), buckets(gcnew array<Int64>(LatencyBuckets::Count)), sum(0),
+			min(Int64::MaxValue), max(0)
+		{
+		}
+
+		/// <summary>
+		/// Gets the name of the measured operation.
+		/// </summary>
+		property String^ Name { String^ get() { return name; } }
+
+		/// <summary>
+		/// Records a duration, in Stopwatch ticks.
+		/// </summary>
+		void Record(Int64 elapsed)
+		{
+			elapsed = Math::Max(0LL, elapsed);
+			Interlocked::Increment(buckets[LatencyBuckets::IndexOf(elapsed)]);
+			Interlocked::Add(sum, elapsed);
+
+			for (Int64 current = Interlocked::Read(min); elapsed < current;)
+			{
+				const auto previous = Interlocked::CompareExchange(min, elapsed, current);
+				if (previous == current)
+				{
+					break;
+				}
+				current = previous;
+			}
+
+			for (Int64 current = Interlocked::Read(max); elapsed > current;)
+			{
+				const auto previous = Interlocked::CompareExchange(max, elapsed, current);
+				if (previous == current)
+				{
+					break;
+				}
+				current = previous;
+			}
+		}
+
+		/// <summary>
+		/// Copies the histogram into a snapshot. Calls recorded while copying may be partially included.
+		/// </summary>
+		LatencyStatistics^ Snapshot()
+		{
+			auto copy = gcnew array<Int64>(LatencyBuckets::Count);
+			Int64 copiedCount = 0;
+			for (int i = 0; i < LatencyBuckets::Count; i++)
+			{
+				copy[i] = Interlocked::Read(buckets[i]);
+				copiedCount += copy[i];
+			}
+
+			return gcnew LatencyStatistics(name, copy, copiedCount, Interlocked::Read(sum), Interlocked::Read(min),
+				Interlocked::Read(max));
+		}
+	};
+
+	/// <summary>
+	/// Represents a snapshot of the time spent in the wrapper, as recorded when latency tracking is enabled in
+	/// <see cref="TorrentSessionConfig::EnableLatencyTracking"/>.
+	/// </summary>
+	public ref class LatencyReport sealed
+	{
+	public:
+		/// <summary>
+		/// Gets the latency of the public session methods, by method name.
+		/// </summary>
+		property IReadOnlyDictionary<String^, LatencyStatistics^>^ Operations
+		{
+			IReadOnlyDictionary<String^, LatencyStatistics^>^ get() { return operations; }
+		}
+
+		/// <summary>
+		/// Gets the latency of the steps inside the session methods, such as waiting for the session lock
+		/// ("ReadLockWait", "WriteLockWait"), parsing torrent IDs ("ParseInfoHash"), looking up torrents
+		/// ("FindTorrent") and converting libtorrent's types ("CreateTorrentStatus", "CreateTorrentInfo").
+		/// </summary>
+		property IReadOnlyDictionary<String^, LatencyStatistics^>^ Steps
+		{
+			IReadOnlyDictionary<String^, LatencyStatistics^>^ get() { return steps; }
+		}
+
+		/// <summary>
+		/// Gets the time spent handling each type of libtorrent alert, by alert name.
+		/// </summary>
+		property IReadOnlyDictionary<String^, LatencyStatistics^>^ Alerts
+		{
+			IReadOnlyDictionary<String^, LatencyStatistics^>^ get() { return alerts; }
+		}
+
+	internal:
+		LatencyReport(IReadOnlyDictionary<String^, LatencyStatistics^>^ operations,
+			IReadOnlyDictionary<String^, LatencyStatistics^>^ steps,
+			IReadOnlyDictionary<String^, LatencyStatistics^>^ alerts) : operations(operations), steps(steps),
+			alerts(alerts)
+		{
+		}
+
+	private:
+		IReadOnlyDictionary<String^, LatencyStatistics^>^ operations;
+		IReadOnlyDictionary<String^, LatencyStatistics^>^ steps;
+		IReadOnlyDictionary<String^, LatencyStatistics^>^ alerts;
+	};
+}
@@ -0,0 +1 @@
+#include "LatencyTracker.h"
@@ -0,0 +1,189 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/alert.hpp>
+#include <libtorrent/alert_types.hpp>
+#pragma managed(pop)
+
+#include "LatencyReport.h"
+
+using namespace System;
+using namespace System::Collections::Concurrent;
+using namespace System::Collections::Generic;
+using namespace System::Diagnostics;
+using namespace System::Diagnostics::Metrics;
+using namespace System::Threading;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Records how long the session spends in its public methods, in the steps inside them and in alert handlers.
+	/// The durations are kept in <see cref="LatencyHistogram"/> instances and also published as
+	/// System.Diagnostics.Metrics histograms. When tracking is disabled, Start returns 0 without reading the clock
+	/// and every Record call returns right away.
+	/// </summary>
+	ref class LatencyTracker sealed
+	{
+		bool enabled;
+		ConcurrentDictionary<String^, LatencyHistogram^>^ operations;
+		ConcurrentDictionary<String^, LatencyHistogram^>^ steps;
+		array<LatencyHistogram^>^ alerts;
+		Func<String^, LatencyHistogram^>^ createHistogram;
+		Meter^ meter;
+		Histogram<double>^ operationDuration;
+		Histogram<double>^ stepDuration;
+		Histogram<double>^ alertDuration;
+
+	internal:
+		/// <summary>
+		/// The name of the meter the instruments are published on.
+		/// </summary>
+		static initonly String^ MeterName = "LibtorrentDotNet.Latency";
+
+		/// <summary>
+		/// Initializes a new instance of the LatencyTracker class.
+		/// </summary>
+		/// <param name="enabled">Whether durations are recorded.</param>
+		LatencyTracker(const bool enabled) : enabled(enabled)
+		{
+			if (!enabled)
+			{
+				return;
+			}
+
+			operations = gcnew ConcurrentDictionary<String^, LatencyHistogram^>(StringComparer::Ordinal);
+			steps = gcnew ConcurrentDictionary<String^, LatencyHistogram^>(StringComparer::Ordinal);
+			alerts = gcnew array<LatencyHistogram^>(libtorrent::num_alert_types);
+			createHistogram = gcnew Func<String^, LatencyHistogram^>(&LatencyTracker::CreateHistogram);
+
+			meter = gcnew Meter(MeterName);
+			operationDuration = meter->CreateHistogram<double>("libtorrentdotnet.operation.duration", "ms",
+				"Time spent in a public session method.");
+			stepDuration = meter->CreateHistogram<double>("libtorrentdotnet.step.duration", "ms",
+				"Time spent in a step inside a session method, such as waiting for the session lock.");
+			alertDuration = meter->CreateHistogram<double>("libtorrentdotnet.alert.duration", "ms",
+				"Time spent handling a libtorrent alert.");
+		}
+
+		~LatencyTracker()
+		{
+			if (meter != nullptr)
+			{
+				delete meter;
+				meter = nullptr;
+			}
+		}
+
+		/// <summary>
+		/// Gets a value indicating whether durations are recorded.
+		/// </summary>
+		property bool IsEnabled { bool get() { return enabled; } }
+
+		/// <summary>
+		/// Returns the timestamp to pass to a Record method, or 0 if tracking is disabled.
+		/// </summary>
+		Int64 Start()
+		{
+			return enabled ? Stopwatch::GetTimestamp() : 0;
+		}
+
+		/// <summary>
+		/// Records the time since <paramref name="started"/> for a public session method.
+		/// </summary>
+		void RecordOperation(String^ name, const Int64 started)
+		{
+			if (started != 0)
+			{
+				Record(operations->GetOrAdd(name, createHistogram), operationDuration, "operation", name, started);
+			}
+		}
+
+		/// <summary>
+		/// Records the time since <paramref name="started"/> for a step inside a session method.
+		/// </summary>
+		void RecordStep(String^ name, const Int64 started)
+		{
+			if (started != 0)
+			{
+				Record(steps->GetOrAdd(name, createHistogram), stepDuration, "step", name, started);
+			}
+		}
+
+		/// <summary>
+		/// Records the time since <paramref name="started"/> for handling an alert. The histogram of each alert type
+		/// is looked up by its type number, so no name is decoded after the first alert of a type.
+		/// </summary>
+		void RecordAlert(const libtorrent::alert* alert, const Int64 started)
+		{
+			if (started == 0)
+			{
+				return;
+			}
+
+			const int type = alert->type();
+			if (type < 0 || type >= alerts->Length)
+			{
+				return;
+			}
+
+			auto histogram = alerts[type];
+			if (histogram == nullptr)
+			{
+				Interlocked::CompareExchange(alerts[type], gcnew LatencyHistogram(gcnew String(alert->what())), nullptr);
+				histogram = alerts[type];
+			}
+			Record(histogram, alertDuration, "alert", histogram->Name, started);
+		}
+
+		/// <summary>
+		/// Creates a snapshot of every histogram recorded so far.
+		/// </summary>
+		LatencyReport^ CreateReport()
+		{
+			auto operationStatistics = gcnew SortedDictionary<String^, LatencyStatistics^>(StringComparer::Ordinal);
+			auto stepStatistics = gcnew SortedDictionary<String^, LatencyStatistics^>(StringComparer::Ordinal);
+			auto alertStatistics = gcnew SortedDictionary<String^, LatencyStatistics^>(StringComparer::Ordinal);
+
+			if (enabled)
+			{
+				for each (auto entry in operations)
+				{
+					operationStatistics[entry.Key] = entry.Value->Snapshot();
+				}
+
+				for each (auto entry in steps)
+				{
+					stepStatistics[entry.Key] = entry.Value->Snapshot();
+				}
+
+				for each (auto histogram in alerts)
+				{
+					if (histogram != nullptr)
+					{
+						alertStatistics[histogram->Name] = histogram->Snapshot();
+					}
+				}
+			}
+
+			return gcnew LatencyReport(operationStatistics, stepStatistics, alertStatistics);
+		}
+
+	private:
+		static LatencyHistogram^ CreateHistogram(String^ name)
+		{
+			return gcnew LatencyHistogram(name);
+		}
+
+		static void Record(LatencyHistogram^ histogram, Histogram<double>^ instrument, String^ tagName, String^ name,
+			const Int64 started)
+		{
+			const auto elapsed = Stopwatch::GetTimestamp() - started;
+			histogram->Record(elapsed);
+
+			if (instrument->Enabled)
+			{
+				instrument->Record(elapsed * 1000.0 / Stopwatch::Frequency, KeyValuePair<String^, Object^>(tagName, name));
+			}
+		}
+	};
+}
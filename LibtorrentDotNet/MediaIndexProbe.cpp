@@ -0,0 +1 @@
+#include "MediaIndexProbe.h"
@@ -0,0 +1,603 @@
+#pragma once
+
+using namespace System;
+using namespace System::Collections::Generic;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents the container format recognized by the media index probe.
+	/// </summary>
+	public enum class MediaContainer
+	{
+		Unknown,
+		Mp4,
+		Matroska
+	};
+
+	/// <summary>
+	/// Represents a range of bytes within a file, from Start inclusive to End exclusive.
+	/// </summary>
+	value struct MediaByteRange
+	{
+		Int64 Start;
+		Int64 End;
+
+		MediaByteRange(Int64 start, Int64 end) : Start(start), End(end) {}
+	};
+
+	/// <summary>
+	/// Holds what the media index probe learned about a file: where its index structures live and, once those
+	/// have been parsed, the byte offsets of its keyframes.
+	/// </summary>
+	ref class MediaIndex sealed
+	{
+	internal:
+		MediaIndex(MediaContainer container) :
+			Container(container),
+			IndexRanges(gcnew List<MediaByteRange>()),
+			KeyframeOffsets(gcnew List<Int64>()),
+			SegmentDataOffset(0),
+			IsComplete(false)
+		{
+		}
+
+		MediaContainer Container;
+		List<MediaByteRange>^ IndexRanges;
+		List<Int64>^ KeyframeOffsets;
+		Int64 SegmentDataOffset;
+		bool IsComplete;
+
+		/// <summary>
+		/// Finds the offset of the last keyframe at or before a position, or -1 if no keyframe is known.
+		/// </summary>
+		Int64 FindKeyframe(Int64 position)
+		{
+			int index = KeyframeOffsets->BinarySearch(position);
+			if (index < 0)
+			{
+				index = ~index - 1;
+			}
+			return index >= 0 ? KeyframeOffsets[index] : -1;
+		}
+	};
+
+	/// <summary>
+	/// Parses just enough of MP4 and Matroska/WebM files to locate their index structures (the moov box and the
+	/// Cues element) and the keyframe offsets those structures describe.
+	/// </summary>
+	ref class MediaIndexProbe abstract sealed
+	{
+		static initonly UInt32 Mp4Ftyp = 0x66747970;
+		static initonly UInt32 Mp4Moov = 0x6D6F6F76;
+		static initonly UInt32 Mp4Trak = 0x7472616B;
+		static initonly UInt32 Mp4Mdia = 0x6D646961;
+		static initonly UInt32 Mp4Minf = 0x6D696E66;
+		static initonly UInt32 Mp4Stbl = 0x7374626C;
+		static initonly UInt32 Mp4Hdlr = 0x68646C72;
+		static initonly UInt32 Mp4Stss = 0x73747373;
+		static initonly UInt32 Mp4Stsz = 0x7374737A;
+		static initonly UInt32 Mp4Stsc = 0x73747363;
+		static initonly UInt32 Mp4Stco = 0x7374636F;
+		static initonly UInt32 Mp4Co64 = 0x636F3634;
+		static initonly UInt32 Mp4Vide = 0x76696465;
+
+		static initonly UInt32 EbmlHeader = 0x1A45DFA3;
+		static initonly UInt32 EbmlSegment = 0x18538067;
+		static initonly UInt32 EbmlSeekHead = 0x114D9B74;
+		static initonly UInt32 EbmlSeek = 0x4DBB;
+		static initonly UInt32 EbmlSeekId = 0x53AB;
+		static initonly UInt32 EbmlSeekPosition = 0x53AC;
+		static initonly UInt32 EbmlCues = 0x1C53BB6B;
+		static initonly UInt32 EbmlCuePoint = 0xBB;
+		static initonly UInt32 EbmlCueTrackPositions = 0xB7;
+		static initonly UInt32 EbmlCueClusterPosition = 0xF1;
+		static initonly UInt32 EbmlCluster = 0x1F43B675;
+		static initonly Int64 EbmlUnknownSize = -1;
+
+	internal:
+		/// <summary>
+		/// Detects the container of a file from its first bytes and locates its index structures.
+		/// </summary>
+		/// <param name="header">The first bytes of the file.</param>
+		/// <param name="headerLength">The number of valid bytes in header.</param>
+		/// <param name="fileLength">The total length of the file.</param>
+		/// <returns>The probed index, with Container set to Unknown if the format was not recognized.</returns>
+		static MediaIndex^ ProbeHeader(array<Byte>^ header, int headerLength, Int64 fileLength)
+		{
+			if (headerLength >= 8 && ReadUInt32(header, 4) == Mp4Ftyp)
+			{
+				return ProbeMp4Header(header, headerLength, fileLength);
+			}
+
+			if (headerLength >= 4 && ReadUInt32(header, 0) == EbmlHeader)
+			{
+				return ProbeMatroskaHeader(header, headerLength, fileLength);
+			}
+
+			return gcnew MediaIndex(MediaContainer::Unknown);
+		}
+
+		/// <summary>
+		/// Parses the index structure that starts at the beginning of data and fills in the keyframe offsets.
+		/// </summary>
+		/// <param name="index">The index returned by ProbeHeader.</param>
+		/// <param name="data">The bytes of the first index range.</param>
+		/// <param name="dataLength">The number of valid bytes in data.</param>
+		static void ParseIndex(MediaIndex^ index, array<Byte>^ data, int dataLength)
+		{
+			if (index->Container == MediaContainer::Mp4)
+			{
+				ParseMp4Index(index, data, dataLength);
+			}
+			else if (index->Container == MediaContainer::Matroska)
+			{
+				ParseMatroskaIndex(index, data, dataLength);
+			}
+
+			index->KeyframeOffsets->Sort();
+			index->IsComplete = true;
+		}
+
+	private:
+		static MediaIndex^ ProbeMp4Header(array<Byte>^ header, int headerLength, Int64 fileLength)
+		{
+			auto index = gcnew MediaIndex(MediaContainer::Mp4);
+			Int64 offset = 0;
+
+			// Walk the top-level boxes. Box sizes let us step past boxes that extend beyond the header, so a moov box
+			// written after the media data is located without reading the media data itself.
+			while (offset + 8 <= headerLength)
+			{
+				Int64 size;
+				int headerSize;
+				if (!ReadMp4BoxHeader(header, static_cast<int>(offset), headerLength, fileLength - offset, size, headerSize))
+				{
+					return index;
+				}
+
+				if (ReadUInt32(header, static_cast<int>(offset) + 4) == Mp4Moov)
+				{
+					index->IndexRanges->Add(MediaByteRange(offset, offset + size));
+					return index;
+				}
+
+				offset += size;
+			}
+
+			// The rest of the top-level boxes lie beyond the header. A trailing moov is among them.
+			if (offset >= headerLength && offset < fileLength)
+			{
+				index->IndexRanges->Add(MediaByteRange(offset, fileLength));
+			}
+
+			return index;
+		}
+
+		static MediaIndex^ ProbeMatroskaHeader(array<Byte>^ header, int headerLength, Int64 fileLength)
+		{
+			auto index = gcnew MediaIndex(MediaContainer::Matroska);
+			int position = 0;
+			UInt32 id;
+			Int64 size;
+
+			// Skip the EBML header element
+			if (!ReadEbmlElement(header, position, headerLength, id, size) || size == EbmlUnknownSize)
+			{
+				return index;
+			}
+			position += static_cast<int>(Math::Min(size, static_cast<Int64>(headerLength)));
+
+			if (!ReadEbmlElement(header, position, headerLength, id, size) || id != EbmlSegment)
+			{
+				return index;
+			}
+
+			const Int64 segmentDataOffset = position;
+			const Int64 segmentEnd = size == EbmlUnknownSize ? fileLength : Math::Min(fileLength, segmentDataOffset + size);
+			index->SegmentDataOffset = segmentDataOffset;
+
+			Int64 cuesOffset = -1;
+			auto elementOffsets = gcnew List<Int64>();
+
+			while (position < headerLength)
+			{
+				const int elementStart = position;
+				if (!ReadEbmlElement(header, position, headerLength, id, size) || size == EbmlUnknownSize)
+				{
+					break;
+				}
+
+				if (id == EbmlCluster)
+				{
+					break;
+				}
+
+				if (id == EbmlCues)
+				{
+					index->IndexRanges->Add(MediaByteRange(elementStart, Math::Min(segmentEnd, position + size)));
+					return index;
+				}
+
+				if (id == EbmlSeekHead && position + size <= headerLength)
+				{
+					ParseSeekHead(header, position, static_cast<int>(position + size), segmentDataOffset, cuesOffset,
+						elementOffsets);
+				}
+
+				position += static_cast<int>(Math::Min(size, static_cast<Int64>(headerLength)));
+			}
+
+			if (cuesOffset >= 0 && cuesOffset < segmentEnd)
+			{
+				// The Cues element ends where the next element listed by the seek head begins
+				Int64 cuesEnd = segmentEnd;
+				for each (Int64 elementOffset in elementOffsets)
+				{
+					if (elementOffset > cuesOffset && elementOffset < cuesEnd)
+					{
+						cuesEnd = elementOffset;
+					}
+				}
+				index->IndexRanges->Add(MediaByteRange(cuesOffset, cuesEnd));
+			}
+
+			return index;
+		}
+
+		static void ParseSeekHead(array<Byte>^ data, int position, int end, Int64 segmentDataOffset,
+			Int64% cuesOffset, List<Int64>^ elementOffsets)
+		{
+			UInt32 id;
+			Int64 size;
+
+			while (position < end && ReadEbmlElement(data, position, end, id, size) && size != EbmlUnknownSize)
+			{
+				const int seekEnd = static_cast<int>(Math::Min(static_cast<Int64>(end), position + size));
+				if (id == EbmlSeek)
+				{
+					UInt32 seekId = 0;
+					Int64 seekPosition = -1;
+					int child = position;
+					UInt32 childId;
+					Int64 childSize;
+
+					while (child < seekEnd && ReadEbmlElement(data, child, seekEnd, childId, childSize) &&
+						childSize != EbmlUnknownSize && child + childSize <= seekEnd)
+					{
+						if (childId == EbmlSeekId)
+						{
+							seekId = static_cast<UInt32>(ReadUnsigned(data, child, static_cast<int>(childSize)));
+						}
+						else if (childId == EbmlSeekPosition)
+						{
+							seekPosition = ReadUnsigned(data, child, static_cast<int>(childSize));
+						}
+						child += static_cast<int>(childSize);
+					}
+
+					if (seekPosition >= 0)
+					{
+						elementOffsets->Add(segmentDataOffset + seekPosition);
+						if (seekId == EbmlCues)
+						{
+							cuesOffset = segmentDataOffset + seekPosition;
+						}
+					}
+				}
+				position = seekEnd;
+			}
+		}
+
+		static void ParseMatroskaIndex(MediaIndex^ index, array<Byte>^ data, int dataLength)
+		{
+			int position = 0;
+			UInt32 id;
+			Int64 size;
+
+			if (!ReadEbmlElement(data, position, dataLength, id, size) || id != EbmlCues)
+			{
+				return;
+			}
+
+			const int cuesEnd = size == EbmlUnknownSize ? dataLength :
+				static_cast<int>(Math::Min(static_cast<Int64>(dataLength), position + size));
+
+			while (position < cuesEnd && ReadEbmlElement(data, position, cuesEnd, id, size) && size != EbmlUnknownSize)
+			{
+				// A truncated read leaves the last cue point incomplete
+				if (position + size > cuesEnd)
+				{
+					break;
+				}
+
+				if (id == EbmlCuePoint)
+				{
+					const int pointEnd = static_cast<int>(position + size);
+					int child = position;
+					UInt32 childId;
+					Int64 childSize;
+
+					while (child < pointEnd && ReadEbmlElement(data, child, pointEnd, childId, childSize) &&
+						childSize != EbmlUnknownSize && child + childSize <= pointEnd)
+					{
+						if (childId == EbmlCueTrackPositions)
+						{
+							const int positionsEnd = static_cast<int>(child + childSize);
+							int field = child;
+							UInt32 fieldId;
+							Int64 fieldSize;
+
+							while (field < positionsEnd && ReadEbmlElement(data, field, positionsEnd, fieldId, fieldSize) &&
+								fieldSize != EbmlUnknownSize && field + fieldSize <= positionsEnd)
+							{
+								if (fieldId == EbmlCueClusterPosition)
+								{
+									index->KeyframeOffsets->Add(index->SegmentDataOffset +
+										ReadUnsigned(data, field, static_cast<int>(fieldSize)));
+								}
+								field += static_cast<int>(fieldSize);
+							}
+						}
+						child += static_cast<int>(childSize);
+					}
+				}
+				position += static_cast<int>(size);
+			}
+		}
+
+		static void ParseMp4Index(MediaIndex^ index, array<Byte>^ data, int dataLength)
+		{
+			// The range may start with other top-level boxes (free, skip, ...) before the moov box
+			int offset = 0;
+			while (offset + 8 <= dataLength)
+			{
+				Int64 size;
+				int headerSize;
+				if (!ReadMp4BoxHeader(data, offset, dataLength, static_cast<Int64>(dataLength) - offset, size, headerSize))
+				{
+					return;
+				}
+
+				if (ReadUInt32(data, offset + 4) == Mp4Moov)
+				{
+					const int moovEnd = static_cast<int>(Math::Min(static_cast<Int64>(dataLength), offset + size));
+					for (int trak = FindMp4Box(data, offset + headerSize, moovEnd, Mp4Trak); trak >= 0;
+						trak = FindMp4Box(data, NextMp4Box(data, trak, moovEnd), moovEnd, Mp4Trak))
+					{
+						ParseMp4Track(index, data, trak, moovEnd);
+					}
+					return;
+				}
+
+				if (offset + size > dataLength)
+				{
+					return;
+				}
+				offset += static_cast<int>(size);
+			}
+		}
+
+		static void ParseMp4Track(MediaIndex^ index, array<Byte>^ data, int trak, int limit)
+		{
+			const int trakEnd = NextMp4Box(data, trak, limit);
+			const int mdia = FindMp4Box(data, trak + 8, trakEnd, Mp4Mdia);
+			if (mdia < 0)
+			{
+				return;
+			}
+
+			const int mdiaEnd = NextMp4Box(data, mdia, trakEnd);
+			const int hdlr = FindMp4Box(data, mdia + 8, mdiaEnd, Mp4Hdlr);
+			if (hdlr < 0 || hdlr + 20 > mdiaEnd || ReadUInt32(data, hdlr + 16) != Mp4Vide)
+			{
+				return;
+			}
+
+			const int minf = FindMp4Box(data, mdia + 8, mdiaEnd, Mp4Minf);
+			const int stbl = minf < 0 ? -1 : FindMp4Box(data, minf + 8, NextMp4Box(data, minf, mdiaEnd), Mp4Stbl);
+			if (stbl < 0)
+			{
+				return;
+			}
+
+			const int stblEnd = NextMp4Box(data, stbl, mdiaEnd);
+			const int stss = FindMp4Box(data, stbl + 8, stblEnd, Mp4Stss);
+			const int stsz = FindMp4Box(data, stbl + 8, stblEnd, Mp4Stsz);
+			const int stsc = FindMp4Box(data, stbl + 8, stblEnd, Mp4Stsc);
+			const int stco = FindMp4Box(data, stbl + 8, stblEnd, Mp4Stco);
+			const int co64 = FindMp4Box(data, stbl + 8, stblEnd, Mp4Co64);
+			const int chunkOffsets = stco >= 0 ? stco : co64;
+			if (stsz < 0 || stsc < 0 || chunkOffsets < 0)
+			{
+				return;
+			}
+
+			// Every box below is a full box: 8 bytes of box header, then 4 bytes of version and flags
+			const int chunkCount = static_cast<int>(ReadUInt32(data, chunkOffsets + 12));
+			const int chunkEntrySize = stco >= 0 ? 4 : 8;
+			const int stscCount = static_cast<int>(ReadUInt32(data, stsc + 12));
+			const UInt32 uniformSampleSize = ReadUInt32(data, stsz + 12);
+			const int sampleCount = static_cast<int>(ReadUInt32(data, stsz + 16));
+			const int syncCount = stss >= 0 ? static_cast<int>(ReadUInt32(data, stss + 12)) : 0;
+
+			if (chunkOffsets + 16 + static_cast<Int64>(chunkCount) * chunkEntrySize > stblEnd ||
+				stsc + 16 + static_cast<Int64>(stscCount) * 12 > stblEnd ||
+				(uniformSampleSize == 0 && stsz + 20 + static_cast<Int64>(sampleCount) * 4 > stblEnd) ||
+				(stss >= 0 && stss + 16 + static_cast<Int64>(syncCount) * 4 > stblEnd))
+			{
+				return;
+			}
+
+			// Without a sync sample box every sample is a keyframe, so chunk starts are close enough
+			if (stss < 0)
+			{
+				for (int chunk = 0; chunk < chunkCount; chunk++)
+				{
+					index->KeyframeOffsets->Add(ReadChunkOffset(data, chunkOffsets, chunkEntrySize, chunk));
+				}
+				return;
+			}
+
+			int sample = 1;
+			int syncIndex = 0;
+			int stscIndex = 0;
+			for (int chunk = 0; chunk < chunkCount && sample <= sampleCount && syncIndex < syncCount; chunk++)
+			{
+				// stsc entries apply from their first chunk (1-based) until the next entry's first chunk
+				while (stscIndex + 1 < stscCount &&
+					static_cast<int>(ReadUInt32(data, stsc + 16 + (stscIndex + 1) * 12)) <= chunk + 1)
+				{
+					stscIndex++;
+				}
+
+				const int samplesInChunk = static_cast<int>(ReadUInt32(data, stsc + 16 + stscIndex * 12 + 4));
+				Int64 sampleOffset = ReadChunkOffset(data, chunkOffsets, chunkEntrySize, chunk);
+
+				for (int i = 0; i < samplesInChunk && sample <= sampleCount && syncIndex < syncCount; i++, sample++)
+				{
+					if (static_cast<int>(ReadUInt32(data, stss + 16 + syncIndex * 4)) == sample)
+					{
+						index->KeyframeOffsets->Add(sampleOffset);
+						syncIndex++;
+					}
+
+					sampleOffset += uniformSampleSize != 0 ? uniformSampleSize : ReadUInt32(data, stsz + 20 + (sample - 1) * 4);
+				}
+			}
+		}
+
+		static Int64 ReadChunkOffset(array<Byte>^ data, int box, int entrySize, int chunk)
+		{
+			const int entry = box + 16 + chunk * entrySize;
+			return entrySize == 4 ? static_cast<Int64>(ReadUInt32(data, entry)) : static_cast<Int64>(ReadUInt64(data, entry));
+		}
+
+		static bool ReadMp4BoxHeader(array<Byte>^ data, int offset, int length, Int64 remaining, Int64% size,
+			int% headerSize)
+		{
+			const UInt32 size32 = ReadUInt32(data, offset);
+			headerSize = 8;
+			if (size32 == 1)
+			{
+				if (offset + 16 > length)
+				{
+					return false;
+				}
+				size = static_cast<Int64>(ReadUInt64(data, offset + 8));
+				headerSize = 16;
+			}
+			else if (size32 == 0)
+			{
+				size = remaining;
+			}
+			else
+			{
+				size = size32;
+			}
+
+			return size >= headerSize;
+		}
+
+		static int FindMp4Box(array<Byte>^ data, int offset, int end, UInt32 type)
+		{
+			while (offset >= 0 && offset + 8 <= end)
+			{
+				if (ReadUInt32(data, offset + 4) == type)
+				{
+					return offset;
+				}
+				offset = NextMp4Box(data, offset, end);
+			}
+			return -1;
+		}
+
+		static int NextMp4Box(array<Byte>^ data, int offset, int end)
+		{
+			const UInt32 size = ReadUInt32(data, offset);
+			if (size < 8 || offset + static_cast<Int64>(size) > end)
+			{
+				return end;
+			}
+			return offset + static_cast<int>(size);
+		}
+
+		static bool ReadEbmlElement(array<Byte>^ data, int% position, int end, UInt32% id, Int64% size)
+		{
+			if (position >= end)
+			{
+				return false;
+			}
+
+			// Element IDs keep their length marker bits, sizes drop them
+			const int idLength = VintLength(data[position]);
+			if (idLength == 0 || idLength > 4 || position + idLength > end)
+			{
+				return false;
+			}
+
+			id = 0;
+			for (int i = 0; i < idLength; i++)
+			{
+				id = (id << 8) | data[position + i];
+			}
+			position += idLength;
+
+			if (position >= end)
+			{
+				return false;
+			}
+
+			const int sizeLength = VintLength(data[position]);
+			if (sizeLength == 0 || position + sizeLength > end)
+			{
+				return false;
+			}
+
+			Int64 value = data[position] & (0xFF >> sizeLength);
+			bool allOnes = value == (0xFF >> sizeLength);
+			for (int i = 1; i < sizeLength; i++)
+			{
+				value = (value << 8) | data[position + i];
+				allOnes &= data[position + i] == 0xFF;
+			}
+			position += sizeLength;
+
+			size = allOnes ? EbmlUnknownSize : value;
+			return true;
+		}
+
+		static int VintLength(Byte first)
+		{
+			for (int length = 1; length <= 8; length++)
+			{
+				if (first & (0x80 >> (length - 1)))
+				{
+					return length;
+				}
+			}
+			return 0;
+		}
+
+		static Int64 ReadUnsigned(array<Byte>^ data, int offset, int length)
+		{
+			Int64 value = 0;
+			for (int i = 0; i < length && i < 8; i++)
+			{
+				value = (value << 8) | data[offset + i];
+			}
+			return value;
+		}
+
+		static UInt32 ReadUInt32(array<Byte>^ data, int offset)
+		{
+			return (static_cast<UInt32>(data[offset]) << 24) | (static_cast<UInt32>(data[offset + 1]) << 16) |
+				(static_cast<UInt32>(data[offset + 2]) << 8) | data[offset + 3];
+		}
+
+		static UInt64 ReadUInt64(array<Byte>^ data, int offset)
+		{
+			return (static_cast<UInt64>(ReadUInt32(data, offset)) << 32) | ReadUInt32(data, offset + 4);
+		}
+	};
+}
@@ -0,0 +1 @@
+#include "MemoryBudgetManager.h"
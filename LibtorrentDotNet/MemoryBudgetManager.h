@@ -0,0 +1,275 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/session.hpp>
+#include <libtorrent/settings_pack.hpp>
+#pragma managed(pop)
+
+#include "MemoryReport.h"
+#include "TorrentSessionConfig.h"
+#include "TorrentStream.h"
+#include "Utilities.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Keeps the session under its memory budget. An estimate of the statuses and infos the session builds for its
+	/// torrents is counted against the budget, and what is left is divided between libtorrent's disk write queue, the
+	/// send buffers of its peers, its alert queue and the buffers of open streams. Only the wrapper's own allocations
+	/// count, not the rest of the process heap. Send buffers are sized for the connection limit rather than the peers that
+	/// happen to be connected, so the budget holds as the swarm grows. The shares are recomputed every tick, and a
+	/// libtorrent setting is only applied when it is off by more than a tenth, so a torrent count that moves a
+	/// little does not reconfigure the session every second.
+	/// </summary>
+	ref class MemoryBudgetManager sealed
+	{
+		static initonly double DiskQueueShare = 0.4;
+		static initonly double SendBufferShare = 0.3;
+		static initonly double StreamBufferShare = 0.2;
+		static initonly double AlertQueueShare = 0.1;
+		static initonly Int64 MinDiskQueueBytes = 256 * 1024;
+		static initonly Int64 MaxDiskQueueBytes = 256 * 1024 * 1024;
+		static initonly Int64 MinSendBufferWatermark = 64 * 1024;
+		static initonly Int64 MaxSendBufferWatermark = 4 * 1024 * 1024;
+		static initonly Int64 MinAlertQueueSize = 1000;
+		static initonly Int64 MaxAlertQueueSize = 100000;
+		static initonly Int64 MinStreamBufferSize = 1024 * 1024;
+		static initonly Int64 MaxStreamBufferSize = 8 * 1024 * 1024;
+
+		/// <summary>
+		/// The bytes an alert takes in the queue on average. Most alerts are a few hundred bytes; state updates and
+		/// piece reads are larger but rare.
+		/// </summary>
+		static initonly Int64 EstimatedAlertBytes = 1024;
+
+		/// <summary>
+		/// The bytes of the managed objects the session builds for a torrent on average: its status on each state
+		/// update, and its info with the file entries of a typical torrent.
+		/// </summary>
+		static initonly Int64 EstimatedTorrentBytes = 4 * 1024;
+
+		Int64 budget;
+		ILogger^ logger;
+		HashSet<TorrentStream^>^ uncoveredStreams;
+		Int64 torrentCount;
+		bool isBudgetTooSmall;
+
+	internal:
+		/// <summary>
+		/// Initializes a new instance of the MemoryBudgetManager class.
+		/// </summary>
+		/// <param name="config">The budget settings, or null to keep the manager disabled.</param>
+		/// <param name="logger">Told about streams the budget is too small for.</param>
+		MemoryBudgetManager(MemoryBudgetConfig^ config, ILogger^ logger) :
+			budget(0), logger(logger), uncoveredStreams(gcnew HashSet<TorrentStream^>()), torrentCount(0),
+			isBudgetTooSmall(false)
+		{
+			if (config != nullptr)
+			{
+				budget = Math::Max(0ll, config->MaxBytes->GetValueOrDefault(0));
+			}
+		}
+
+		/// <summary>
+		/// Gets a value indicating whether a budget is set.
+		/// </summary>
+		property bool IsEnabled { bool get() { return budget > 0; } }
+
+		/// <summary>
+		/// Gets the read-ahead buffer size for a stream that is about to be opened, from the torrent count of the
+		/// last tick.
+		/// </summary>
+		/// <param name="streams">The streams that are already open.</param>
+		Int32 GetStreamBufferSize(array<TorrentStream^>^ streams)
+		{
+			if (!IsEnabled)
+			{
+				return static_cast<Int32>(MaxStreamBufferSize);
+			}
+
+			const Int64 streamShare = GetStreamShare(GetAvailableBytes(), streams->Length + 1);
+			return static_cast<Int32>(GetBufferSizeForShare(streamShare));
+		}
+
+		/// <summary>
+		/// Recomputes every share of the budget, applies the libtorrent settings that drifted from their share and
+		/// resizes the buffers of the open streams.
+		/// </summary>
+		/// <param name="session">The session to configure.</param>
+		/// <param name="streams">The open streams.</param>
+		void Enforce(libtorrent::session* session, array<TorrentStream^>^ streams)
+		{
+			if (!IsEnabled)
+			{
+				return;
+			}
+
+			torrentCount = static_cast<Int64>(session->get_torrents().size());
+			const Int64 available = GetAvailableBytes();
+			const auto& current = session->get_settings();
+			const Int64 connections = Math::Max(1, current.get_int(libtorrent::settings_pack::connections_limit));
+
+			// The settings never go below their minimums, so a budget smaller than those is exceeded whatever the
+			// shares are. Logged once, not on every tick the budget stays too small.
+			const Int64 minimumBytes = GetMinimumBytes(connections);
+			if (minimumBytes > budget && !isBudgetTooSmall)
+			{
+				logger->Log(ILogger::LogLevel::Warning, String::Format(
+					"Memory budget of {0} bytes is below the {1} bytes the session needs at least with {2} torrents and "
+					"{3} connections. The session will use more than its budget.", budget, minimumBytes, torrentCount,
+					connections));
+			}
+			isBudgetTooSmall = minimumBytes > budget;
+
+			const Int64 diskQueueBytes = Math::Clamp(static_cast<Int64>(available * DiskQueueShare),
+				MinDiskQueueBytes, MaxDiskQueueBytes);
+			const Int64 sendBufferWatermark = Math::Clamp(
+				static_cast<Int64>(available * SendBufferShare) / connections,
+				MinSendBufferWatermark, MaxSendBufferWatermark);
+			const Int64 alertQueueSize = Math::Clamp(
+				static_cast<Int64>(available * AlertQueueShare) / EstimatedAlertBytes,
+				MinAlertQueueSize, MaxAlertQueueSize);
+
+			libtorrent::settings_pack changed;
+			int changedCount = 0;
+			changedCount += SetIfDrifted(current, changed, libtorrent::settings_pack::max_queued_disk_bytes,
+				diskQueueBytes);
+			changedCount += SetIfDrifted(current, changed, libtorrent::settings_pack::send_buffer_watermark,
+				sendBufferWatermark);
+			changedCount += SetIfDrifted(current, changed, libtorrent::settings_pack::alert_queue_size, alertQueueSize);
+
+			// The low watermark is where refilling starts, so it has to stay below the high one
+			if (current.get_int(libtorrent::settings_pack::send_buffer_low_watermark) > sendBufferWatermark / 2)
+			{
+				changed.set_int(libtorrent::settings_pack::send_buffer_low_watermark,
+					static_cast<int>(sendBufferWatermark / 2));
+				changedCount++;
+			}
+
+			if (changedCount > 0)
+			{
+				session->apply_settings(std::move(changed));
+			}
+
+			LimitStreams(streams, available);
+		}
+
+		/// <summary>
+		/// Reports what the session has allocated to each of its buffers.
+		/// </summary>
+		/// <param name="session">The session to report on.</param>
+		/// <param name="streams">The open streams.</param>
+		MemoryReport^ CreateReport(libtorrent::session* session, array<TorrentStream^>^ streams)
+		{
+			const auto& settings = session->get_settings();
+			const Int64 connections = settings.get_int(libtorrent::settings_pack::connections_limit);
+			const Int64 torrents = static_cast<Int64>(session->get_torrents().size());
+
+			return gcnew MemoryReport(budget,
+				settings.get_int(libtorrent::settings_pack::max_queued_disk_bytes),
+				settings.get_int(libtorrent::settings_pack::send_buffer_watermark) * connections,
+				settings.get_int(libtorrent::settings_pack::alert_queue_size) * EstimatedAlertBytes,
+				CountStreamBytes(streams),
+				torrents * EstimatedTorrentBytes,
+				IsEnabled ? GetMinimumBytes(Math::Max(1ll, connections), torrents) : 0);
+		}
+
+	private:
+		/// <summary>
+		/// Resizes the buffer and piece cache of every open stream to its share. A fill of the read-ahead buffer
+		/// reads the pieces it spans into the cache before copying them out, so a cache smaller than the buffer plus
+		/// one piece would evict pieces that are still needed. A stream whose share cannot cover that keeps the
+		/// memory it has.
+		/// </summary>
+		void LimitStreams(array<TorrentStream^>^ streams, const Int64 available)
+		{
+			if (streams->Length == 0)
+			{
+				uncoveredStreams->Clear();
+				return;
+			}
+
+			const Int64 streamShare = GetStreamShare(available, streams->Length);
+			const Int64 bufferSize = GetBufferSizeForShare(streamShare);
+			auto stillUncovered = gcnew HashSet<TorrentStream^>();
+			for each (auto stream in streams)
+			{
+				const Int64 minimumCacheBytes = bufferSize + stream->PieceLength;
+				if (streamShare - bufferSize < minimumCacheBytes)
+				{
+					// Logged once, not on every tick the budget stays too small
+					if (!uncoveredStreams->Contains(stream))
+					{
+						logger->Log(ILogger::LogLevel::Warning, String::Format(
+							"Memory budget leaves a stream {0} bytes, less than the {1} bytes it needs to read ahead. "
+							"Its buffers are left as they are.", streamShare, bufferSize + minimumCacheBytes));
+					}
+					stillUncovered->Add(stream);
+					continue;
+				}
+
+				stream->LimitMemory(static_cast<Int32>(bufferSize), streamShare - bufferSize);
+			}
+			uncoveredStreams = stillUncovered;
+		}
+
+		/// <summary>
+		/// Gets what is left of the budget for the buffers it sizes, after the objects built for the torrents.
+		/// </summary>
+		Int64 GetAvailableBytes()
+		{
+			return Math::Max(0ll, budget - torrentCount * EstimatedTorrentBytes);
+		}
+
+		Int64 GetMinimumBytes(const Int64 connections)
+		{
+			return GetMinimumBytes(connections, torrentCount);
+		}
+
+		/// <summary>
+		/// Gets the least the session uses with every setting at its minimum, not counting open streams.
+		/// </summary>
+		static Int64 GetMinimumBytes(const Int64 connections, const Int64 torrents)
+		{
+			return MinDiskQueueBytes + MinSendBufferWatermark * connections + MinAlertQueueSize * EstimatedAlertBytes +
+				torrents * EstimatedTorrentBytes;
+		}
+
+		static Int64 GetStreamShare(const Int64 available, const int streamCount)
+		{
+			return static_cast<Int64>(available * StreamBufferShare) / Math::Max(1, streamCount);
+		}
+
+		static Int64 GetBufferSizeForShare(const Int64 streamShare)
+		{
+			// A quarter of a stream's share goes to its read-ahead buffer and the rest to its piece cache
+			return Math::Clamp(streamShare / 4, MinStreamBufferSize, MaxStreamBufferSize);
+		}
+
+		static Int64 CountStreamBytes(array<TorrentStream^>^ streams)
+		{
+			Int64 bytes = 0;
+			for each (auto stream in streams)
+			{
+				bytes += stream->AllocatedBytes;
+			}
+			return bytes;
+		}
+
+		static int SetIfDrifted(const libtorrent::settings_pack& current, libtorrent::settings_pack& changed,
+			const int name, const Int64 target)
+		{
+			const Int64 value = current.get_int(name);
+			if (Math::Abs(value - target) <= target / 10)
+			{
+				return 0;
+			}
+
+			changed.set_int(name, static_cast<int>(target));
+			return 1;
+		}
+	};
+}
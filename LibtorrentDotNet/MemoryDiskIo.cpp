@@ -0,0 +1 @@
+#include "MemoryDiskIo.h"
@@ -0,0 +1,293 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <boost/asio/post.hpp>
+#include <libtorrent/disk_buffer_holder.hpp>
+#include <libtorrent/disk_interface.hpp>
+#include <libtorrent/file_storage.hpp>
+#include <libtorrent/hasher.hpp>
+#include <libtorrent/io_context.hpp>
+#include <libtorrent/peer_request.hpp>
+#include <libtorrent/performance_counters.hpp>
+#include <libtorrent/settings_pack.hpp>
+#include <libtorrent/storage_defs.hpp>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Holds the pieces of one torrent in memory, each in a buffer of the piece's full size.
+	/// </summary>
+	class MemoryStorage
+	{
+	public:
+		explicit MemoryStorage(const libtorrent::file_storage& files) : files(files)
+		{
+		}
+
+		libtorrent::span<const char> Read(const libtorrent::peer_request& request, libtorrent::storage_error& error) const
+		{
+			const auto piece = pieces.find(request.piece);
+			if (piece == pieces.end() || static_cast<int>(piece->second.size()) <= request.start)
+			{
+				error.operation = libtorrent::operation_t::file_read;
+				error.ec = boost::asio::error::eof;
+				return {};
+			}
+
+			return { piece->second.data() + request.start,
+				std::min(request.length, static_cast<int>(piece->second.size()) - request.start) };
+		}
+
+		void Write(libtorrent::span<const char> buffer, const libtorrent::piece_index_t piece, const int offset)
+		{
+			auto& data = pieces[piece];
+			if (data.empty())
+			{
+				// Allocate the whole piece up front; reallocating would invalidate buffers handed out by Read
+				data.resize(static_cast<std::size_t>(files.piece_size(piece)));
+			}
+
+			std::memcpy(data.data() + offset, buffer.data(), static_cast<std::size_t>(buffer.size()));
+		}
+
+		libtorrent::sha1_hash Hash(const libtorrent::piece_index_t piece, libtorrent::span<libtorrent::sha256_hash> blockHashes,
+			libtorrent::storage_error& error) const
+		{
+			const auto entry = pieces.find(piece);
+			if (entry == pieces.end())
+			{
+				error.operation = libtorrent::operation_t::file_read;
+				error.ec = boost::asio::error::eof;
+				return {};
+			}
+
+			if (!blockHashes.empty())
+			{
+				const int pieceSize = files.piece_size2(piece);
+				const int blockCount = files.blocks_in_piece2(piece);
+				const char* data = entry->second.data();
+				int offset = 0;
+				for (int block = 0; block < blockCount; block++)
+				{
+					const int length = std::min(libtorrent::default_block_size, pieceSize - offset);
+					blockHashes[block] = libtorrent::hasher256(data + offset, length).final();
+					offset += length;
+				}
+			}
+
+			return libtorrent::hasher(entry->second).final();
+		}
+
+		libtorrent::sha256_hash Hash2(const libtorrent::piece_index_t piece, const int offset,
+			libtorrent::storage_error& error) const
+		{
+			const auto entry = pieces.find(piece);
+			if (entry == pieces.end())
+			{
+				error.operation = libtorrent::operation_t::file_read;
+				error.ec = boost::asio::error::eof;
+				return {};
+			}
+
+			const int length = std::min(libtorrent::default_block_size, files.piece_size2(piece) - offset);
+			return libtorrent::hasher256(entry->second.data() + offset, length).final();
+		}
+
+	private:
+		const libtorrent::file_storage& files;
+		std::map<libtorrent::piece_index_t, std::vector<char>> pieces;
+	};
+
+	/// <summary>
+	/// A libtorrent disk backend that keeps every torrent in memory and never touches the file system. Downloaded data
+	/// is lost when the torrent is removed or the session ends. All calls arrive on the network thread.
+	/// </summary>
+	class MemoryDiskIo final : public libtorrent::disk_interface, public libtorrent::buffer_allocator_interface
+	{
+	public:
+		explicit MemoryDiskIo(libtorrent::io_context& ioContext) : ioContext(ioContext)
+		{
+		}
+
+		void settings_updated() override
+		{
+		}
+
+		libtorrent::storage_holder new_torrent(const libtorrent::storage_params& params,
+			const std::shared_ptr<void>&) override
+		{
+			libtorrent::storage_index_t index;
+			if (freeSlots.empty())
+			{
+				index = torrents.end_index();
+				torrents.emplace_back(std::make_unique<MemoryStorage>(params.files));
+			}
+			else
+			{
+				index = freeSlots.back();
+				freeSlots.pop_back();
+				torrents[index] = std::make_unique<MemoryStorage>(params.files);
+			}
+
+			return libtorrent::storage_holder(index, *this);
+		}
+
+		void remove_torrent(const libtorrent::storage_index_t index) override
+		{
+			torrents[index].reset();
+			freeSlots.push_back(index);
+		}
+
+		void abort(bool) override
+		{
+		}
+
+		void async_read(const libtorrent::storage_index_t storage, const libtorrent::peer_request& request,
+			std::function<void(libtorrent::disk_buffer_holder, const libtorrent::storage_error&)> handler,
+			libtorrent::disk_job_flags_t) override
+		{
+			// The buffer belongs to the storage and stays valid while the torrent is in the session
+			libtorrent::storage_error error;
+			const auto buffer = torrents[storage]->Read(request, error);
+
+			boost::asio::post(ioContext, [this, handler, error, buffer]
+				{
+					handler(libtorrent::disk_buffer_holder(*this, const_cast<char*>(buffer.data()),
+						static_cast<int>(buffer.size())), error);
+				});
+		}
+
+		bool async_write(const libtorrent::storage_index_t storage, const libtorrent::peer_request& request,
+			const char* buffer, std::shared_ptr<libtorrent::disk_observer>,
+			std::function<void(const libtorrent::storage_error&)> handler, libtorrent::disk_job_flags_t) override
+		{
+			torrents[storage]->Write({ buffer, request.length }, request.piece, request.start);
+
+			boost::asio::post(ioContext, [handler] { handler(libtorrent::storage_error()); });
+			return false;
+		}
+
+		void async_hash(const libtorrent::storage_index_t storage, const libtorrent::piece_index_t piece,
+			libtorrent::span<libtorrent::sha256_hash> blockHashes, libtorrent::disk_job_flags_t,
+			std::function<void(libtorrent::piece_index_t, const libtorrent::sha1_hash&,
+				const libtorrent::storage_error&)> handler) override
+		{
+			libtorrent::storage_error error;
+			const auto hash = torrents[storage]->Hash(piece, blockHashes, error);
+
+			boost::asio::post(ioContext, [handler, piece, hash, error] { handler(piece, hash, error); });
+		}
+
+		void async_hash2(const libtorrent::storage_index_t storage, const libtorrent::piece_index_t piece,
+			const int offset, libtorrent::disk_job_flags_t,
+			std::function<void(libtorrent::piece_index_t, const libtorrent::sha256_hash&,
+				const libtorrent::storage_error&)> handler) override
+		{
+			libtorrent::storage_error error;
+			const auto hash = torrents[storage]->Hash2(piece, offset, error);
+
+			boost::asio::post(ioContext, [handler, piece, hash, error] { handler(piece, hash, error); });
+		}
+
+		void async_move_storage(libtorrent::storage_index_t, std::string path, libtorrent::move_flags_t,
+			std::function<void(libtorrent::status_t, const std::string&, const libtorrent::storage_error&)> handler) override
+		{
+			boost::asio::post(ioContext, [handler, path]
+				{
+					handler(libtorrent::disk_status::fatal_disk_error, path, libtorrent::storage_error(
+						libtorrent::error_code(boost::system::errc::operation_not_supported, libtorrent::system_category())));
+				});
+		}
+
+		void async_release_files(libtorrent::storage_index_t, std::function<void()> handler) override
+		{
+			if (handler)
+			{
+				boost::asio::post(ioContext, handler);
+			}
+		}
+
+		void async_delete_files(libtorrent::storage_index_t, libtorrent::remove_flags_t,
+			std::function<void(const libtorrent::storage_error&)> handler) override
+		{
+			boost::asio::post(ioContext, [handler] { handler(libtorrent::storage_error()); });
+		}
+
+		void async_check_files(libtorrent::storage_index_t, const libtorrent::add_torrent_params*,
+			libtorrent::aux::vector<std::string, libtorrent::file_index_t>,
+			std::function<void(libtorrent::status_t, const libtorrent::storage_error&)> handler) override
+		{
+			// Nothing survives between sessions, so there is nothing to check
+			boost::asio::post(ioContext, [handler] { handler(libtorrent::status_t{}, libtorrent::storage_error()); });
+		}
+
+		void async_rename_file(libtorrent::storage_index_t, const libtorrent::file_index_t index, const std::string name,
+			std::function<void(const std::string&, libtorrent::file_index_t, const libtorrent::storage_error&)> handler) override
+		{
+			boost::asio::post(ioContext, [handler, name, index] { handler(name, index, libtorrent::storage_error()); });
+		}
+
+		void async_stop_torrent(libtorrent::storage_index_t, std::function<void()> handler) override
+		{
+			boost::asio::post(ioContext, handler);
+		}
+
+		void async_set_file_priority(libtorrent::storage_index_t,
+			libtorrent::aux::vector<libtorrent::download_priority_t, libtorrent::file_index_t> priorities,
+			std::function<void(const libtorrent::storage_error&,
+				libtorrent::aux::vector<libtorrent::download_priority_t, libtorrent::file_index_t>)> handler) override
+		{
+			// File priorities only decide which files are created on disk, which never happens here
+			boost::asio::post(ioContext, [handler, priorities]() mutable
+				{
+					handler(libtorrent::storage_error(), std::move(priorities));
+				});
+		}
+
+		void async_clear_piece(libtorrent::storage_index_t, const libtorrent::piece_index_t piece,
+			std::function<void(libtorrent::piece_index_t)> handler) override
+		{
+			boost::asio::post(ioContext, [handler, piece] { handler(piece); });
+		}
+
+		void free_disk_buffer(char*) override
+		{
+			// Every buffer handed out is owned by a storage
+		}
+
+		void update_stats_counters(libtorrent::counters&) const override
+		{
+		}
+
+		std::vector<libtorrent::open_file_state> get_status(libtorrent::storage_index_t) const override
+		{
+			return {};
+		}
+
+		void submit_jobs() override
+		{
+		}
+
+	private:
+		libtorrent::io_context& ioContext;
+		libtorrent::aux::vector<std::unique_ptr<MemoryStorage>, libtorrent::storage_index_t> torrents;
+		std::vector<libtorrent::storage_index_t> freeSlots;
+	};
+
+	/// <summary>
+	/// Creates the in-memory disk backend; passed to libtorrent as a disk_io_constructor.
+	/// </summary>
+	inline std::unique_ptr<libtorrent::disk_interface> CreateMemoryDiskIo(libtorrent::io_context& ioContext,
+		const libtorrent::settings_interface&, libtorrent::counters&)
+	{
+		return std::make_unique<MemoryDiskIo>(ioContext);
+	}
+}
+#pragma managed(pop)
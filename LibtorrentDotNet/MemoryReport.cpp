@@ -0,0 +1 @@
+#include "MemoryReport.h"
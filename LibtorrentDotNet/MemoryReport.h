@@ -0,0 +1,87 @@
+#pragma once
+
+using namespace System;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents how much memory the session has allocated to each of its buffers, and the budget they are held to.
+	/// </summary>
+	public ref class MemoryReport sealed
+	{
+	public:
+		/// <summary>
+		/// Gets the memory budget of the session in bytes, or 0 if it has none.
+		/// </summary>
+		property Int64 Budget { Int64 get() { return budget; } }
+
+		/// <summary>
+		/// Gets the most bytes libtorrent may queue for writing to disk, its max_queued_disk_bytes setting.
+		/// </summary>
+		property Int64 DiskQueueBytes { Int64 get() { return diskQueueBytes; } }
+
+		/// <summary>
+		/// Gets the most bytes the send buffers of the session's peers may hold: the send buffer watermark of each
+		/// peer times the connection limit.
+		/// </summary>
+		property Int64 SendBufferBytes { Int64 get() { return sendBufferBytes; } }
+
+		/// <summary>
+		/// Gets an estimate of the most bytes libtorrent's alert queue may hold, from its alert_queue_size setting.
+		/// </summary>
+		property Int64 AlertQueueBytes { Int64 get() { return alertQueueBytes; } }
+
+		/// <summary>
+		/// Gets the bytes held by the read-ahead buffers, file buffers and piece caches of the open streams.
+		/// </summary>
+		property Int64 StreamBufferBytes { Int64 get() { return streamBufferBytes; } }
+
+		/// <summary>
+		/// Gets an estimate of the bytes of the torrent statuses and infos the session builds for its torrents. The
+		/// rest of the process heap is not counted.
+		/// </summary>
+		property Int64 TorrentObjectBytes { Int64 get() { return torrentObjectBytes; } }
+
+		/// <summary>
+		/// Gets the sum of all categories.
+		/// </summary>
+		property Int64 TotalBytes
+		{
+			Int64 get() { return diskQueueBytes + sendBufferBytes + alertQueueBytes + streamBufferBytes + torrentObjectBytes; }
+		}
+
+		/// <summary>
+		/// Gets the least the session uses with every buffer at its minimum size, not counting open streams, or 0 if
+		/// it has no budget.
+		/// </summary>
+		property Int64 MinimumBytes { Int64 get() { return minimumBytes; } }
+
+		/// <summary>
+		/// Gets whether the categories add up to more than the budget.
+		/// </summary>
+		property bool IsOverBudget { bool get() { return budget > 0 && TotalBytes > budget; } }
+
+		/// <summary>
+		/// Gets whether the budget is below the minimum sizes of the buffers, so that the session cannot stay under it.
+		/// </summary>
+		property bool IsBudgetTooSmall { bool get() { return budget > 0 && minimumBytes > budget; } }
+
+	internal:
+		MemoryReport(const Int64 budget, const Int64 diskQueueBytes, const Int64 sendBufferBytes,
+			const Int64 alertQueueBytes, const Int64 streamBufferBytes, const Int64 torrentObjectBytes,
+			const Int64 minimumBytes) : budget(budget), diskQueueBytes(diskQueueBytes), sendBufferBytes(sendBufferBytes),
+			alertQueueBytes(alertQueueBytes), streamBufferBytes(streamBufferBytes), torrentObjectBytes(torrentObjectBytes),
+			minimumBytes(minimumBytes)
+		{
+		}
+
+	private:
+		Int64 budget;
+		Int64 diskQueueBytes;
+		Int64 sendBufferBytes;
+		Int64 alertQueueBytes;
+		Int64 streamBufferBytes;
+		Int64 torrentObjectBytes;
+		Int64 minimumBytes;
+	};
+}
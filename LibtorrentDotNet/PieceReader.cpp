@@ -0,0 +1 @@
+#include "PieceReader.h"
@@ -0,0 +1,515 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/alert_types.hpp>
+#include <libtorrent/torrent_handle.hpp>
+#pragma managed(pop)
+
+#include "Optional.h"
+#include "TorrentId.h"
+
+using namespace System;
+using namespace System::Buffers;
+using namespace System::Collections::Generic;
+using namespace System::IO;
+using namespace System::Runtime::InteropServices;
+using namespace System::Threading;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Reads piece data through libtorrent's disk layer with read_piece and keeps the most recently read pieces in
+	/// buffers rented from the shared array pool.
+	/// </summary>
+	ref class PieceReader sealed
+	{
+		static initonly Int32 DefaultMaxCachedBytes = 32 * 1024 * 1024;
+		static initonly Int32 AlertPumpIntervalMs = 5;
+
+		ref class PieceBuffer sealed
+		{
+		public:
+			PieceBuffer() : data(nullptr), length(0), pins(0), error(nullptr),
+				completed(gcnew ManualResetEventSlim(false)), detached(false)
+			{
+			}
+
+			array<Byte>^ data;
+			Int32 length;
+			Int32 pins;
+			String^ error;
+			ManualResetEventSlim^ completed;
+			// No longer in the cache; the event is disposed once the last pinned read is done with it
+			bool detached;
+		};
+
+		const libtorrent::torrent_handle* torrentHandle;
+		TorrentId^ torrentId;
+		Dictionary<int, PieceBuffer^>^ pieces;
+		LinkedList<int>^ recentPieces;
+		Int64 cachedBytes;
+		Int64 requestedMaxCachedBytes;
+		Int64 maxCachedBytes;
+		Action^ alertPump;
+		Action<PieceReader^>^ closedCallback;
+		Object^ syncRoot;
+		bool closed;
+
+	internal:
+		/// <summary>
+		/// Initializes a new instance of the PieceReader class. The torrent handle is borrowed and must outlive the reader.
+		/// </summary>
+		/// <param name="torrentHandle">The handle of the torrent to read pieces from.</param>
+		/// <param name="torrentId">The ID of the torrent, used to route read_piece alerts to this reader.</param>
+		/// <param name="maxCachedBytes">The maximum number of bytes of completed pieces to keep cached.</param>
+		/// <param name="alertPump">Called while waiting for a piece so that its alert is delivered promptly. It must only
+		/// schedule the delivery, since the reader calls it while the stream is locked.</param>
+		/// <param name="closedCallback">Called once when the reader is closed.</param>
+		PieceReader(const libtorrent::torrent_handle* torrentHandle, TorrentId^ torrentId, Optional<int>^ maxCachedBytes,
+			Action^ alertPump, Action<PieceReader^>^ closedCallback) :
+			torrentHandle(torrentHandle),
+			torrentId(torrentId),
+			pieces(gcnew Dictionary<int, PieceBuffer^>()),
+			recentPieces(gcnew LinkedList<int>()),
+			cachedBytes(0),
+			requestedMaxCachedBytes(maxCachedBytes->GetValueOrDefault(DefaultMaxCachedBytes)),
+			maxCachedBytes(requestedMaxCachedBytes),
+			alertPump(alertPump),
+			closedCallback(closedCallback),
+			syncRoot(gcnew Object()),
+			closed(false)
+		{
+		}
+
+		/// <summary>
+		/// Gets the ID of the torrent this reader reads from.
+		/// </summary>
+		property TorrentId^ Id { TorrentId^ get() { return torrentId; } }
+
+		/// <summary>
+		/// Gets the number of bytes of completed pieces held in the cache.
+		/// </summary>
+		property Int64 CachedBytes { Int64 get() { return Interlocked::Read(cachedBytes); } }
+
+		/// <summary>
+		/// Lowers the cache below the size the reader was opened with, evicting pieces right away if it is over.
+		/// </summary>
+		/// <param name="limit">The most bytes the cache may hold. The size the reader was opened with still applies
+		/// if it is lower.</param>
+		void LimitCache(const Int64 limit)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				maxCachedBytes = Math::Min(requestedMaxCachedBytes, limit);
+				EvictPieces();
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Gets how many pieces of the given length fit in the cache, and so how many may be requested ahead of a
+		/// read without evicting each other. Always at least one.
+		/// </summary>
+		int GetPieceCapacity(int pieceLength)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				return static_cast<int>(Math::Max(1ll, maxCachedBytes / Math::Max(1, pieceLength)));
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Asks libtorrent to read a piece without waiting for it. The piece must already be downloaded.
+		/// </summary>
+		void Request(int piece)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				GetOrRequest(piece);
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Copies data from a downloaded piece, waiting for libtorrent to read it if it is not cached yet.
+		/// </summary>
+		/// <returns>The number of bytes copied, or 0 if the piece could not be read within the timeout.</returns>
+		/// <exception cref="IOException">Thrown if libtorrent failed to request or read the piece.</exception>
+		int Read(int piece, int pieceOffset, array<Byte>^ destination, int destinationOffset, int count, TimeSpan timeout)
+		{
+			PieceBuffer^ entry;
+
+			Monitor::Enter(syncRoot);
+			try
+			{
+				// Pinned until the data is copied out, so the alerts of other pieces cannot evict it in between
+				entry = GetOrRequest(piece);
+				entry->pins++;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+
+			DateTime startTime = DateTime::Now;
+			while (!entry->completed->Wait(AlertPumpIntervalMs))
+			{
+				if (DateTime::Now - startTime >= timeout)
+				{
+					Abandon(piece, entry);
+					return 0;
+				}
+
+				if (alertPump != nullptr)
+				{
+					alertPump();
+				}
+			}
+
+			Monitor::Enter(syncRoot);
+			try
+			{
+				if (entry->error != nullptr)
+				{
+					throw gcnew IOException(String::Format("Failed to read piece {0}: {1}", piece, entry->error));
+				}
+
+				if (closed || entry->data == nullptr)
+				{
+					return 0;
+				}
+
+				int toCopy = Math::Min(count, entry->length - pieceOffset);
+				if (toCopy <= 0)
+				{
+					return 0;
+				}
+
+				Buffer::BlockCopy(entry->data, pieceOffset, destination, destinationOffset, toCopy);
+				return toCopy;
+			}
+			finally
+			{
+				Unpin(entry);
+				EvictPieces();
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Completes a pending read with the data carried by a read_piece alert. Alerts for pieces this reader did not
+		/// request are ignored.
+		/// </summary>
+		void OnPieceRead(const libtorrent::read_piece_alert* alert)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				PieceBuffer^ entry;
+				const int piece = static_cast<int>(alert->piece);
+				if (closed || !pieces->TryGetValue(piece, entry) || entry->completed->IsSet)
+				{
+					return;
+				}
+
+				if (alert->error)
+				{
+					// Forget the failed piece so the next read asks libtorrent again
+					entry->error = gcnew String(alert->error.message().c_str());
+					entry->completed->Set();
+					Detach(piece, entry);
+					return;
+				}
+
+				entry->data = ArrayPool<Byte>::Shared->Rent(alert->size);
+				entry->length = alert->size;
+				if (alert->size > 0)
+				{
+					Marshal::Copy(IntPtr(alert->buffer.get()), entry->data, 0, alert->size);
+				}
+
+				cachedBytes += entry->length;
+				recentPieces->AddLast(piece);
+				entry->completed->Set();
+
+				EvictPieces();
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Returns all cached buffers to the pool and wakes up any pending reads.
+		/// </summary>
+		void Close()
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				if (closed)
+				{
+					return;
+				}
+
+				closed = true;
+				for each (auto entry in pieces->Values)
+				{
+					if (entry->data != nullptr)
+					{
+						ArrayPool<Byte>::Shared->Return(entry->data);
+						entry->data = nullptr;
+					}
+					entry->completed->Set();
+					entry->detached = true;
+					if (entry->pins == 0)
+					{
+						entry->completed->Dispose();
+					}
+				}
+
+				pieces->Clear();
+				recentPieces->Clear();
+				cachedBytes = 0;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+
+			if (closedCallback != nullptr)
+			{
+				closedCallback(this);
+			}
+		}
+
+	private:
+		/// <summary>
+		/// Gives up on a read that timed out. A piece still pending is dropped from the cache, so that the next read
+		/// asks libtorrent again instead of waiting on a read_piece alert that may have been lost.
+		/// </summary>
+		void Abandon(int piece, PieceBuffer^ entry)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				Unpin(entry);
+				if (!entry->completed->IsSet)
+				{
+					Detach(piece, entry);
+				}
+				EvictPieces();
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		void Unpin(PieceBuffer^ entry)
+		{
+			entry->pins--;
+			if (entry->detached && entry->pins == 0)
+			{
+				entry->completed->Dispose();
+			}
+		}
+
+		/// <summary>
+		/// Removes an entry from the cache. Its event is disposed right away unless a read still waits on it.
+		/// </summary>
+		void Detach(int piece, PieceBuffer^ entry)
+		{
+			PieceBuffer^ current;
+			if (pieces->TryGetValue(piece, current) && current == entry)
+			{
+				pieces->Remove(piece);
+			}
+
+			entry->detached = true;
+			if (entry->pins == 0)
+			{
+				entry->completed->Dispose();
+			}
+		}
+
+		PieceBuffer^ GetOrRequest(int piece)
+		{
+			if (closed)
+			{
+				throw gcnew ObjectDisposedException("PieceReader");
+			}
+
+			PieceBuffer^ entry;
+			if (pieces->TryGetValue(piece, entry))
+			{
+				if (entry->completed->IsSet && recentPieces->Remove(piece))
+				{
+					recentPieces->AddLast(piece);
+				}
+				return entry;
+			}
+
+			try
+			{
+				torrentHandle->read_piece(libtorrent::piece_index_t(piece));
+			}
+			catch (const std::exception& e)
+			{
+				// The torrent was removed, which the stream treats like any other failed read
+				throw gcnew IOException(String::Format("Failed to request piece {0}: {1}", piece,
+					gcnew String(e.what())));
+			}
+
+			entry = gcnew PieceBuffer();
+			pieces->Add(piece, entry);
+			return entry;
+		}
+
+		void EvictPieces()
+		{
+			// Always keep the most recent piece, even if it alone exceeds the budget. Pieces a read is waiting to
+			// copy out are skipped and evicted once the read is done with them.
+			auto node = recentPieces->First;
+			while (node != nullptr && cachedBytes > maxCachedBytes && recentPieces->Count > 1)
+			{
+				auto next = node->Next;
+				PieceBuffer^ entry;
+				if (pieces->TryGetValue(node->Value, entry) && entry->pins > 0)
+				{
+					node = next;
+					continue;
+				}
+
+				recentPieces->Remove(node);
+				if (entry != nullptr)
+				{
+					cachedBytes -= entry->length;
+					if (entry->data != nullptr)
+					{
+						ArrayPool<Byte>::Shared->Return(entry->data);
+						entry->data = nullptr;
+					}
+					Detach(node->Value, entry);
+				}
+				node = next;
+			}
+		}
+	};
+
+	/// <summary>
+	/// Keeps track of the open piece readers of a session so that read_piece alerts can be routed to them.
+	/// </summary>
+	ref class PieceReaderRegistry sealed
+	{
+		Dictionary<TorrentId^, List<PieceReader^>^>^ readers;
+		Object^ syncRoot;
+		volatile int readerCount;
+
+	internal:
+		PieceReaderRegistry() :
+			readers(gcnew Dictionary<TorrentId^, List<PieceReader^>^>()),
+			syncRoot(gcnew Object()),
+			readerCount(0)
+		{
+		}
+
+		/// <summary>
+		/// Gets a value indicating whether no readers are open, so alert dispatch can be skipped cheaply.
+		/// </summary>
+		property bool IsEmpty { bool get() { return readerCount == 0; } }
+
+		/// <summary>
+		/// Opens a reader for a torrent. The reader unregisters itself when it is closed.
+		/// </summary>
+		PieceReader^ Open(const libtorrent::torrent_handle* torrentHandle, TorrentId^ torrentId,
+			Optional<int>^ maxCachedBytes, Action^ alertPump)
+		{
+			auto reader = gcnew PieceReader(torrentHandle, torrentId, maxCachedBytes, alertPump,
+				gcnew Action<PieceReader^>(this, &PieceReaderRegistry::Unregister));
+
+			Monitor::Enter(syncRoot);
+			try
+			{
+				List<PieceReader^>^ torrentReaders;
+				if (!readers->TryGetValue(torrentId, torrentReaders))
+				{
+					torrentReaders = gcnew List<PieceReader^>();
+					readers->Add(torrentId, torrentReaders);
+				}
+				torrentReaders->Add(reader);
+				readerCount++;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+
+			return reader;
+		}
+
+		/// <summary>
+		/// Routes a read_piece alert to every reader open on the alert's torrent.
+		/// </summary>
+		void Dispatch(TorrentId^ torrentId, const libtorrent::read_piece_alert* alert)
+		{
+			array<PieceReader^>^ targets;
+
+			Monitor::Enter(syncRoot);
+			try
+			{
+				List<PieceReader^>^ torrentReaders;
+				if (!readers->TryGetValue(torrentId, torrentReaders))
+				{
+					return;
+				}
+				targets = torrentReaders->ToArray();
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+
+			for each (auto reader in targets)
+			{
+				reader->OnPieceRead(alert);
+			}
+		}
+
+	private:
+		void Unregister(PieceReader^ reader)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				List<PieceReader^>^ torrentReaders;
+				if (readers->TryGetValue(reader->Id, torrentReaders) && torrentReaders->Remove(reader))
+				{
+					readerCount--;
+					if (torrentReaders->Count == 0)
+					{
+						readers->Remove(reader->Id);
+					}
+				}
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+	};
+}
@@ -0,0 +1 @@
+#include "PieceWindowManager.h"
@@ -0,0 +1,339 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <cstdint>
+#include <libtorrent/download_priority.hpp>
+#include <libtorrent/torrent_handle.hpp>
+#include <utility>
+#include <vector>
+#pragma managed(pop)
+
+#include "TorrentId.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+using namespace System::Threading;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents the priority and optional deadline one owner asks for on a piece.
+	/// </summary>
+	value struct PieceReservation
+	{
+		Int32 Priority;
+		Int32 Deadline;
+		bool HasDeadline;
+	};
+
+	/// <summary>
+	/// Merges the piece windows of every reader of one torrent into a single priority and deadline schedule.
+	/// Each owner replaces its own reservations; a piece keeps the highest priority and the earliest deadline any
+	/// owner asks for, and only goes back to the priority it had before the first reservation once no owner reserves
+	/// it anymore, so priorities the caller set (including pieces it chose not to download) survive the window.
+	/// </summary>
+	ref class PieceWindowManager sealed
+	{
+		const libtorrent::torrent_handle* torrentHandle;
+		TorrentId^ torrentId;
+		Dictionary<Object^, Dictionary<int, PieceReservation>^>^ reservations;
+		Dictionary<int, int>^ appliedPriorities;
+		Dictionary<int, int>^ originalPriorities;
+		Dictionary<int, DateTime>^ submittedDeadlines;
+		Action<PieceWindowManager^>^ detachedCallback;
+		Object^ syncRoot;
+		int readerCount;
+
+	internal:
+		/// <summary>
+		/// Initializes a new instance of the PieceWindowManager class. The manager keeps its own copy of the handle.
+		/// </summary>
+		PieceWindowManager(const libtorrent::torrent_handle& handle, TorrentId^ torrentId,
+			Action<PieceWindowManager^>^ detachedCallback) :
+			torrentHandle(new libtorrent::torrent_handle(handle)),
+			torrentId(torrentId),
+			reservations(gcnew Dictionary<Object^, Dictionary<int, PieceReservation>^>()),
+			appliedPriorities(gcnew Dictionary<int, int>()),
+			originalPriorities(gcnew Dictionary<int, int>()),
+			submittedDeadlines(gcnew Dictionary<int, DateTime>()),
+			detachedCallback(detachedCallback),
+			syncRoot(gcnew Object()),
+			readerCount(0)
+		{
+		}
+
+		~PieceWindowManager()
+		{
+			this->!PieceWindowManager();
+		}
+
+		!PieceWindowManager()
+		{
+			if (torrentHandle != nullptr)
+			{
+				delete torrentHandle;
+				torrentHandle = nullptr;
+			}
+		}
+
+		/// <summary>
+		/// Gets the ID of the torrent whose pieces this manager schedules.
+		/// </summary>
+		property TorrentId^ Id { TorrentId^ get() { return torrentId; } }
+
+		/// <summary>
+		/// Replaces the reservations of an owner and applies the merged result with one prioritize_pieces call.
+		/// </summary>
+		/// <param name="owner">The object the reservations belong to.</param>
+		/// <param name="priorities">The pieces the owner wants and their priorities.</param>
+		/// <param name="deadlines">The deadlines, in milliseconds from now, for the subset of pieces still missing.</param>
+		void Reserve(Object^ owner,
+			const std::vector<std::pair<libtorrent::piece_index_t, libtorrent::download_priority_t>>& priorities,
+			const std::vector<std::pair<libtorrent::piece_index_t, int>>& deadlines)
+		{
+			auto next = gcnew Dictionary<int, PieceReservation>(static_cast<int>(priorities.size()));
+			for (const auto& [piece, priority] : priorities)
+			{
+				PieceReservation reservation;
+				reservation.Priority = static_cast<std::uint8_t>(priority);
+				reservation.Deadline = 0;
+				reservation.HasDeadline = false;
+				next[static_cast<int>(piece)] = reservation;
+			}
+
+			for (const auto& [piece, deadline] : deadlines)
+			{
+				PieceReservation reservation;
+				next->TryGetValue(static_cast<int>(piece), reservation);
+				reservation.Deadline = deadline;
+				reservation.HasDeadline = true;
+				next[static_cast<int>(piece)] = reservation;
+			}
+
+			Monitor::Enter(syncRoot);
+			try
+			{
+				Dictionary<int, PieceReservation>^ previous;
+				reservations->TryGetValue(owner, previous);
+
+				if (next->Count > 0)
+				{
+					reservations[owner] = next;
+				}
+				else
+				{
+					reservations->Remove(owner);
+				}
+
+				auto affectedPieces = gcnew HashSet<int>(next->Keys);
+				if (previous != nullptr)
+				{
+					affectedPieces->UnionWith(previous->Keys);
+				}
+
+				ApplySchedule(affectedPieces);
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Drops every reservation of an owner.
+		/// </summary>
+		void Release(Object^ owner)
+		{
+			Reserve(owner, {}, {});
+		}
+
+		/// <summary>
+		/// Registers one more reader sharing this manager.
+		/// </summary>
+		void Attach()
+		{
+			Interlocked::Increment(readerCount);
+		}
+
+		/// <summary>
+		/// Unregisters a reader. The manager is discarded when the last reader detaches.
+		/// </summary>
+		void Detach()
+		{
+			if (Interlocked::Decrement(readerCount) == 0 && detachedCallback != nullptr)
+			{
+				detachedCallback(this);
+			}
+		}
+
+		/// <summary>
+		/// Gets a value indicating whether no reader is attached.
+		/// </summary>
+		property bool IsUnused { bool get() { return readerCount == 0; } }
+
+	private:
+		void ApplySchedule(HashSet<int>^ affectedPieces)
+		{
+			std::vector<std::pair<libtorrent::piece_index_t, libtorrent::download_priority_t>> priorities;
+			std::vector<std::pair<libtorrent::piece_index_t, int>> deadlines;
+			std::vector<libtorrent::piece_index_t> expiredDeadlines;
+			priorities.reserve(affectedPieces->Count);
+			const auto now = DateTime::Now;
+
+			// Read from libtorrent at most once per schedule, and only when a piece is reserved for the first time
+			std::vector<libtorrent::download_priority_t> currentPriorities;
+
+			for each (int piece in affectedPieces)
+			{
+				int priority = -1;
+				int deadline = Int32::MaxValue;
+				for each (auto ownerReservations in reservations->Values)
+				{
+					PieceReservation reservation;
+					if (ownerReservations->TryGetValue(piece, reservation))
+					{
+						priority = Math::Max(priority, reservation.Priority);
+						if (reservation.HasDeadline)
+						{
+							deadline = Math::Min(deadline, reservation.Deadline);
+						}
+					}
+				}
+
+				const auto nativePiece = libtorrent::piece_index_t(piece);
+				int appliedPriority;
+				const bool wasApplied = appliedPriorities->TryGetValue(piece, appliedPriority);
+
+				if (priority < 0)
+				{
+					// Nobody reserves the piece anymore
+					if (wasApplied)
+					{
+						int originalPriority;
+						if (!originalPriorities->TryGetValue(piece, originalPriority))
+						{
+							originalPriority = static_cast<std::uint8_t>(libtorrent::default_priority);
+						}
+						priorities.emplace_back(nativePiece,
+							static_cast<libtorrent::download_priority_t>(originalPriority));
+						appliedPriorities->Remove(piece);
+						originalPriorities->Remove(piece);
+					}
+				}
+				else if (!wasApplied || appliedPriority != priority)
+				{
+					if (!wasApplied)
+					{
+						if (currentPriorities.empty())
+						{
+							currentPriorities = torrentHandle->get_piece_priorities();
+						}
+						if (piece < static_cast<int>(currentPriorities.size()))
+						{
+							originalPriorities[piece] = static_cast<std::uint8_t>(currentPriorities[piece]);
+						}
+					}
+					priorities.emplace_back(nativePiece, static_cast<libtorrent::download_priority_t>(priority));
+					appliedPriorities[piece] = priority;
+				}
+
+				DateTime submittedDue;
+				const bool hasSubmittedDeadline = submittedDeadlines->TryGetValue(piece, submittedDue);
+				if (deadline == Int32::MaxValue)
+				{
+					if (hasSubmittedDeadline)
+					{
+						expiredDeadlines.emplace_back(nativePiece);
+						submittedDeadlines->Remove(piece);
+					}
+				}
+				else
+				{
+					// Only pull a deadline in; a later one from another reader must not delay the piece
+					const auto due = now.AddMilliseconds(deadline);
+					if (!hasSubmittedDeadline || due < submittedDue)
+					{
+						deadlines.emplace_back(nativePiece, deadline);
+						submittedDeadlines[piece] = due;
+					}
+				}
+			}
+
+			if (!priorities.empty())
+			{
+				torrentHandle->prioritize_pieces(priorities);
+			}
+
+			for (const auto& piece : expiredDeadlines)
+			{
+				torrentHandle->reset_piece_deadline(piece);
+			}
+
+			for (const auto& [piece, deadline] : deadlines)
+			{
+				torrentHandle->set_piece_deadline(piece, deadline);
+			}
+		}
+	};
+
+	/// <summary>
+	/// Hands out one shared piece window manager per torrent to the streams reading from it.
+	/// </summary>
+	ref class PieceWindowRegistry sealed
+	{
+		Dictionary<TorrentId^, PieceWindowManager^>^ managers;
+		Object^ syncRoot;
+
+	internal:
+		PieceWindowRegistry() :
+			managers(gcnew Dictionary<TorrentId^, PieceWindowManager^>()),
+			syncRoot(gcnew Object())
+		{
+		}
+
+		/// <summary>
+		/// Gets the manager of a torrent, creating it if needed, and attaches a reader to it.
+		/// </summary>
+		PieceWindowManager^ Acquire(const libtorrent::torrent_handle& handle, TorrentId^ torrentId)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				PieceWindowManager^ manager;
+				if (!managers->TryGetValue(torrentId, manager))
+				{
+					manager = gcnew PieceWindowManager(handle, torrentId,
+						gcnew Action<PieceWindowManager^>(this, &PieceWindowRegistry::OnDetached));
+					managers->Add(torrentId, manager);
+				}
+
+				manager->Attach();
+				return manager;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+	private:
+		void OnDetached(PieceWindowManager^ manager)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				// A reader may have attached again between the detach and this callback
+				PieceWindowManager^ current;
+				if (manager->IsUnused && managers->TryGetValue(manager->Id, current) && current == manager)
+				{
+					managers->Remove(manager->Id);
+					delete manager;
+				}
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+	};
+}
@@ -0,0 +1 @@
+#include "QueueMove.h"
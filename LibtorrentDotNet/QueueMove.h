@@ -0,0 +1,30 @@
+#pragma once
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents where torrents are moved in the download queue.
+	/// </summary>
+	public enum class QueueMove
+	{
+		/// <summary>
+		/// One position towards the front of the queue.
+		/// </summary>
+		Up,
+
+		/// <summary>
+		/// One position towards the back of the queue.
+		/// </summary>
+		Down,
+
+		/// <summary>
+		/// To the front of the queue.
+		/// </summary>
+		Top,
+
+		/// <summary>
+		/// To the back of the queue.
+		/// </summary>
+		Bottom
+	};
+}
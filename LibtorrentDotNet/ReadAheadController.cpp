@@ -0,0 +1 @@
+#include "ReadAheadController.h"
@@ -0,0 +1,128 @@
+#pragma once
+
+using namespace System;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Sizes a stream's read-ahead window in bytes from how fast the consumer reads, how fast the swarm delivers and
+	/// how long a requested piece takes to arrive, bounded by a memory cap.
+	/// </summary>
+	ref class ReadAheadController sealed
+	{
+		static initonly double RateSmoothing = 0.3;
+		static initonly Int64 MinReadAheadBytes = 4 * 1024 * 1024;
+		static initonly Int32 MinReadAheadPieces = 2;
+
+		Int32 pieceLength;
+		double targetBufferSeconds;
+		Int64 maxReadAheadBytes;
+		double consumerRate;
+		double downloadRate;
+		double pieceLatencySeconds;
+		DateTime lastConsumptionTime;
+
+	internal:
+		/// <summary>
+		/// Initializes a new instance of the ReadAheadController class.
+		/// </summary>
+		/// <param name="pieceLength">The piece length of the torrent, in bytes.</param>
+		/// <param name="targetBufferDuration">How much playback the read-ahead window should cover.</param>
+		/// <param name="maxReadAheadBytes">The most bytes the read-ahead window may span.</param>
+		ReadAheadController(Int32 pieceLength, TimeSpan targetBufferDuration, Int64 maxReadAheadBytes) :
+			pieceLength(pieceLength),
+			targetBufferSeconds(targetBufferDuration.TotalSeconds),
+			maxReadAheadBytes(Math::Max(maxReadAheadBytes, static_cast<Int64>(pieceLength))),
+			consumerRate(0),
+			downloadRate(0),
+			pieceLatencySeconds(0),
+			lastConsumptionTime(DateTime::Now)
+		{
+		}
+
+		/// <summary>
+		/// Gets the smoothed rate at which the consumer reads the stream, in bytes per second.
+		/// </summary>
+		property double ConsumerRate { double get() { return consumerRate; } }
+
+		/// <summary>
+		/// Gets the most recently sampled download rate of the torrent, in bytes per second.
+		/// </summary>
+		property double DownloadRate { double get() { return downloadRate; } }
+
+		/// <summary>
+		/// Gets the smoothed time between a piece entering the window and it being downloaded.
+		/// </summary>
+		property double PieceLatencySeconds { double get() { return pieceLatencySeconds; } }
+
+		/// <summary>
+		/// Records that the consumer read a number of bytes since the previous call.
+		/// </summary>
+		void RecordConsumption(int bytesRead)
+		{
+			auto currentTime = DateTime::Now;
+			auto elapsed = (currentTime - lastConsumptionTime).TotalSeconds;
+			if (elapsed > 0)
+			{
+				consumerRate = Smooth(consumerRate, bytesRead / elapsed);
+				lastConsumptionTime = currentTime;
+			}
+		}
+
+		/// <summary>
+		/// Records the torrent's current download rate, in bytes per second.
+		/// </summary>
+		void RecordDownloadRate(int bytesPerSecond)
+		{
+			downloadRate = bytesPerSecond;
+		}
+
+		/// <summary>
+		/// Records how long a piece took to arrive after it was requested.
+		/// </summary>
+		void RecordPieceArrival(TimeSpan latency)
+		{
+			pieceLatencySeconds = pieceLatencySeconds == 0
+				? latency.TotalSeconds
+				: Smooth(pieceLatencySeconds, latency.TotalSeconds);
+		}
+
+		/// <summary>
+		/// Calculates how many bytes ahead of the read position should be requested.
+		/// </summary>
+		Int64 ReadAheadBytes()
+		{
+			// Cover the target duration at the consumer's rate, plus the time it takes a requested piece to show up
+			double bytes = consumerRate * (targetBufferSeconds + pieceLatencySeconds);
+
+			// Keep enough pieces in flight to use what the swarm can deliver while waiting for them
+			bytes = Math::Max(bytes, downloadRate * pieceLatencySeconds);
+
+			const Int64 minimum = Math::Min(maxReadAheadBytes,
+				Math::Max(MinReadAheadBytes, static_cast<Int64>(MinReadAheadPieces) * pieceLength));
+			return Math::Min(maxReadAheadBytes, Math::Max(minimum, static_cast<Int64>(bytes)));
+		}
+
+		/// <summary>
+		/// Calculates how many pieces ahead of the read position should be requested.
+		/// </summary>
+		Int32 ReadAheadPieces()
+		{
+			return static_cast<Int32>(Math::Max(1LL, (ReadAheadBytes() + pieceLength - 1) / pieceLength));
+		}
+
+		/// <summary>
+		/// Converts a number of buffered bytes into seconds of playback at the consumer's rate.
+		/// </summary>
+		double BufferedSeconds(Int64 bufferedBytes)
+		{
+			return consumerRate > 0 ? bufferedBytes / consumerRate : 0;
+		}
+
+	private:
+		static double Smooth(double average, double sample)
+		{
+			return (average * (1 - RateSmoothing)) + (sample * RateSmoothing);
+		}
+	};
+}
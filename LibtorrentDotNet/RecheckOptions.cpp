@@ -0,0 +1 @@
+#include "RecheckOptions.h"
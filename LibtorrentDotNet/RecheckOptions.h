@@ -0,0 +1,131 @@
+#pragma once
+#include "Optional.h"
+#include "TorrentId.h"
+
+using namespace System;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents how a batch of torrents is rechecked by <see cref="ITorrentSession::RecheckTorrents"/>.
+	/// </summary>
+	public ref class RecheckOptions sealed
+	{
+	public:
+		/// <summary>
+		/// Gets or sets how many torrents are checked at the same time. It replaces the session's active_checking
+		/// limit, which libtorrent defaults to 1, until every torrent of the batch has been checked. By default the
+		/// session's limit is kept.
+		/// </summary>
+		property Optional<int>^ ActiveChecking;
+
+		/// <summary>
+		/// Gets or sets the number of threads that hash the pieces read by the check. It replaces the session's
+		/// hashing_threads setting until every torrent of the batch has been checked. Hashing threads are separate
+		/// from the threads that serve peers. By default the session's setting is kept.
+		/// </summary>
+		property Optional<int>^ HashingThreads;
+
+		/// <summary>
+		/// Gets or sets the highest average rate in bytes per second at which the batch reads from disk, so that
+		/// active transfers keep a share of the disk. The checking torrents are paused whenever they get ahead of the
+		/// rate and resumed once it has caught up, allowing bursts of up to one second's worth. By default the rate
+		/// is not limited.
+		/// </summary>
+		property Optional<Int64>^ MaxReadRate;
+
+		/// <summary>
+		/// Initializes a new instance of the RecheckOptions class with default values.
+		/// </summary>
+		RecheckOptions()
+		{
+			ActiveChecking = Optional<int>::None();
+			HashingThreads = Optional<int>::None();
+			MaxReadRate = Optional<Int64>::None();
+		}
+	};
+
+	/// <summary>
+	/// Represents where a torrent is in a recheck.
+	/// </summary>
+	public enum class RecheckState
+	{
+		/// <summary>
+		/// The torrent is waiting for one of the session's checking slots.
+		/// </summary>
+		Queued,
+
+		/// <summary>
+		/// The torrent's files are being read and hashed.
+		/// </summary>
+		Checking,
+
+		/// <summary>
+		/// The torrent is paused to keep the batch within <see cref="RecheckOptions::MaxReadRate"/>.
+		/// </summary>
+		Throttled,
+
+		/// <summary>
+		/// Every piece has been checked.
+		/// </summary>
+		Completed,
+
+		/// <summary>
+		/// The check stopped on an error, such as a file that could not be read.
+		/// </summary>
+		Failed
+	};
+
+	/// <summary>
+	/// Represents the progress of one torrent in a recheck.
+	/// </summary>
+	public ref class RecheckProgress sealed
+	{
+	public:
+		/// <summary>
+		/// Gets the ID of the torrent.
+		/// </summary>
+		property TorrentId^ Id { TorrentId^ get() { return id; } }
+
+		/// <summary>
+		/// Gets where the torrent is in the recheck.
+		/// </summary>
+		property RecheckState State { RecheckState get() { return state; } }
+
+		/// <summary>
+		/// Gets the number of bytes checked so far.
+		/// </summary>
+		property Int64 CheckedBytes { Int64 get() { return checkedBytes; } }
+
+		/// <summary>
+		/// Gets the total size of the torrent's files.
+		/// </summary>
+		property Int64 TotalBytes { Int64 get() { return totalBytes; } }
+
+		/// <summary>
+		/// Gets the share of the torrent that has been checked, from 0 to 1.
+		/// </summary>
+		property double Progress
+		{
+			double get() { return totalBytes > 0 ? static_cast<double>(checkedBytes) / totalBytes : 1.0; }
+		}
+
+		/// <summary>
+		/// Gets the error the check stopped on, or null if it did not fail.
+		/// </summary>
+		property String^ Error { String^ get() { return error; } }
+
+	internal:
+		RecheckProgress(TorrentId^ id, const RecheckState state, const Int64 checkedBytes, const Int64 totalBytes,
+			String^ error) : id(id), state(state), checkedBytes(checkedBytes), totalBytes(totalBytes), error(error)
+		{
+		}
+
+	private:
+		TorrentId^ id;
+		RecheckState state;
+		Int64 checkedBytes;
+		Int64 totalBytes;
+		String^ error;
+	};
+}
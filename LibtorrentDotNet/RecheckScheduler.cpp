@@ -0,0 +1 @@
+#include "RecheckScheduler.h"
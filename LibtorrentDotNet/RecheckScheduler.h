@@ -0,0 +1,374 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/info_hash.hpp>
+#include <libtorrent/session.hpp>
+#include <libtorrent/settings_pack.hpp>
+#include <libtorrent/torrent_flags.hpp>
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/torrent_status.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// A torrent being rechecked, with the flags it had before the recheck started.
+	/// </summary>
+	struct RecheckingTorrent
+	{
+		int key;
+		std::int64_t totalBytes;
+		std::int64_t checkedBytes;
+		bool throttled;
+		bool wasAutoManaged;
+		bool wasPaused;
+	};
+
+	inline std::vector<libtorrent::torrent_status> GetRecheckingStatuses(const libtorrent::session& session,
+		const std::unordered_map<libtorrent::info_hash_t, RecheckingTorrent>& torrents)
+	{
+		return session.get_torrent_status([&torrents](const libtorrent::torrent_status& status)
+			{
+				return torrents.contains(status.info_hashes);
+			});
+	}
+}
+#pragma managed(pop)
+
+#include "RecheckOptions.h"
+#include "TorrentEvents.h"
+#include "TorrentId.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+using namespace System::Diagnostics;
+using namespace System::Threading;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Runs the force rechecks of many torrents as one batch. libtorrent checks at most active_checking torrents at a
+	/// time, but only queues auto managed ones, so every rechecked torrent is auto managed until its check is done.
+	/// The concurrency and hashing threads of the batch replace the session's settings until the last torrent is
+	/// checked, and an optional read rate is held by pausing the checking torrents whenever they get ahead of it.
+	/// </summary>
+	ref class RecheckScheduler sealed
+	{
+		Object^ syncRoot;
+		std::unordered_map<libtorrent::info_hash_t, RecheckingTorrent>* torrents;
+		Dictionary<int, TorrentId^>^ torrentIds;
+		List<RecheckProgress^>^ finished;
+		int nextKey;
+		int savedActiveChecking;
+		int savedHashingThreads;
+		Int64 maxReadRate;
+		double readBudget;
+		Stopwatch^ clock;
+		TimeSpan lastUpdate;
+
+	internal:
+		RecheckScheduler() :
+			syncRoot(gcnew Object()),
+			torrents(new std::unordered_map<libtorrent::info_hash_t, RecheckingTorrent>()),
+			torrentIds(gcnew Dictionary<int, TorrentId^>()),
+			finished(gcnew List<RecheckProgress^>()),
+			nextKey(0),
+			savedActiveChecking(0),
+			savedHashingThreads(0),
+			maxReadRate(0),
+			readBudget(0.0),
+			clock(Stopwatch::StartNew()),
+			lastUpdate(TimeSpan::Zero)
+		{
+		}
+
+		~RecheckScheduler()
+		{
+			this->!RecheckScheduler();
+		}
+
+		!RecheckScheduler()
+		{
+			if (torrents != nullptr)
+			{
+				delete torrents;
+				torrents = nullptr;
+			}
+		}
+
+		/// <summary>
+		/// Starts rechecking torrents, joining the batch that is already running if there is one. The options of
+		/// the latest call apply to the whole batch.
+		/// </summary>
+		/// <param name="session">The session owning the torrents.</param>
+		/// <param name="handles">The torrents to recheck.</param>
+		/// <param name="ids">The IDs of the torrents, in the same order as the handles.</param>
+		/// <param name="options">The concurrency and read rate of the batch.</param>
+		/// <returns>The number of torrents whose recheck was started. Torrents without metadata are skipped.</returns>
+		int Start(libtorrent::session* session, const std::vector<libtorrent::torrent_handle>& handles,
+			IReadOnlyList<TorrentId^>^ ids, RecheckOptions^ options)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				if (torrents->empty())
+				{
+					const auto& settings = session->get_settings();
+					savedActiveChecking = settings.get_int(libtorrent::settings_pack::active_checking);
+					savedHashingThreads = settings.get_int(libtorrent::settings_pack::hashing_threads);
+					readBudget = 0.0;
+					lastUpdate = clock->Elapsed;
+				}
+
+				libtorrent::settings_pack settings;
+				if (options->ActiveChecking->HasValue)
+				{
+					settings.set_int(libtorrent::settings_pack::active_checking, options->ActiveChecking->Value);
+				}
+				if (options->HashingThreads->HasValue)
+				{
+					settings.set_int(libtorrent::settings_pack::hashing_threads, options->HashingThreads->Value);
+				}
+				session->apply_settings(std::move(settings));
+				maxReadRate = options->MaxReadRate->GetValueOrDefault(0);
+
+				int started = 0;
+				for (size_t i = 0; i < handles.size(); i++)
+				{
+					const auto& handle = handles[i];
+					const auto torrentFile = handle.torrent_file();
+					if (!torrentFile)
+					{
+						continue;
+					}
+
+					const auto flags = handle.flags();
+					const auto [entry, inserted] = torrents->try_emplace(handle.info_hashes());
+					if (inserted)
+					{
+						entry->second.key = nextKey++;
+						entry->second.totalBytes = torrentFile->total_size();
+						entry->second.wasAutoManaged = static_cast<bool>(flags & libtorrent::torrent_flags::auto_managed);
+						entry->second.wasPaused = static_cast<bool>(flags & libtorrent::torrent_flags::paused);
+						torrentIds->Add(entry->second.key, ids[static_cast<int>(i)]);
+					}
+					entry->second.checkedBytes = 0;
+					entry->second.throttled = false;
+
+					// Torrents that are not auto managed skip the checking queue and would all be checked at once
+					handle.set_flags(libtorrent::torrent_flags::auto_managed);
+					handle.force_recheck();
+					started++;
+				}
+
+				if (torrents->empty())
+				{
+					RestoreSettings(session);
+				}
+				return started;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Completes the recheck of a torrent once libtorrent reports it checked, giving it back the flags it had.
+		/// </summary>
+		/// <param name="session">The session owning the torrent.</param>
+		/// <param name="handle">The checked torrent.</param>
+		void OnTorrentChecked(libtorrent::session* session, const libtorrent::torrent_handle& handle)
+		{
+			Finish(session, handle, RecheckState::Completed, nullptr);
+		}
+
+		/// <summary>
+		/// Fails the recheck of a torrent that stopped on an error, giving it back the flags it had.
+		/// </summary>
+		/// <param name="session">The session owning the torrent.</param>
+		/// <param name="handle">The failed torrent.</param>
+		/// <param name="error">The error the check stopped on.</param>
+		void OnTorrentError(libtorrent::session* session, const libtorrent::torrent_handle& handle, String^ error)
+		{
+			Finish(session, handle, RecheckState::Failed, error);
+		}
+
+		/// <summary>
+		/// Samples the progress of the batch and pauses or resumes its checking torrents to hold the read rate.
+		/// </summary>
+		/// <param name="session">The session owning the torrents.</param>
+		/// <returns>The progress of the batch, or null if no recheck ran since the last update.</returns>
+		RecheckProgressEventArgs^ Update(libtorrent::session* session)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				if (torrents->empty() && finished->Count == 0)
+				{
+					return nullptr;
+				}
+
+				const auto now = clock->Elapsed;
+				const double seconds = (now - lastUpdate).TotalSeconds;
+				lastUpdate = now;
+
+				auto progress = gcnew List<RecheckProgress^>(finished);
+				finished->Clear();
+
+				auto statuses = torrents->empty()
+					? std::vector<libtorrent::torrent_status>()
+					: GetRecheckingStatuses(*session, *torrents);
+				ForgetRemovedTorrents(session, statuses);
+
+				Int64 readBytes = 0;
+				for (const auto& status : statuses)
+				{
+					auto& entry = torrents->at(status.info_hashes);
+					if (status.state == libtorrent::torrent_status::checking_files)
+					{
+						// progress_ppm, since a float progress loses whole megabytes on large torrents
+						const auto checkedBytes = entry.totalBytes * status.progress_ppm / 1000000;
+						readBytes += Math::Max(0ll, checkedBytes - entry.checkedBytes);
+						entry.checkedBytes = checkedBytes;
+					}
+				}
+
+				const bool throttle = UpdateReadBudget(readBytes, seconds);
+				for (const auto& status : statuses)
+				{
+					auto& entry = torrents->at(status.info_hashes);
+					const bool waiting = static_cast<bool>(status.flags & libtorrent::torrent_flags::paused);
+					if (throttle && !entry.throttled && !waiting)
+					{
+						status.handle.unset_flags(libtorrent::torrent_flags::auto_managed);
+						status.handle.pause();
+						entry.throttled = true;
+					}
+					else if (!throttle && entry.throttled)
+					{
+						status.handle.set_flags(libtorrent::torrent_flags::auto_managed);
+						status.handle.resume();
+						entry.throttled = false;
+					}
+
+					const auto state = entry.throttled ? RecheckState::Throttled
+						: waiting ? RecheckState::Queued
+						: RecheckState::Checking;
+					progress->Add(gcnew RecheckProgress(torrentIds[entry.key], state, entry.checkedBytes,
+						entry.totalBytes, nullptr));
+				}
+
+				const auto readRate = seconds > 0.0 ? static_cast<Int64>(readBytes / seconds) : 0;
+				return gcnew RecheckProgressEventArgs(progress, readRate);
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+	private:
+		void Finish(libtorrent::session* session, const libtorrent::torrent_handle& handle, const RecheckState state,
+			String^ error)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				const auto entry = torrents->find(handle.info_hashes());
+				if (entry == torrents->end())
+				{
+					return;
+				}
+
+				const auto& torrent = entry->second;
+				if (!torrent.wasAutoManaged)
+				{
+					handle.unset_flags(libtorrent::torrent_flags::auto_managed);
+					if (torrent.wasPaused)
+					{
+						handle.pause();
+					}
+					else
+					{
+						handle.resume();
+					}
+				}
+				else if (torrent.throttled)
+				{
+					handle.set_flags(libtorrent::torrent_flags::auto_managed);
+				}
+
+				const auto checkedBytes = state == RecheckState::Completed ? torrent.totalBytes : torrent.checkedBytes;
+				finished->Add(gcnew RecheckProgress(torrentIds[torrent.key], state, checkedBytes, torrent.totalBytes,
+					error));
+				torrentIds->Remove(torrent.key);
+				torrents->erase(entry);
+
+				if (torrents->empty())
+				{
+					RestoreSettings(session);
+				}
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		void ForgetRemovedTorrents(libtorrent::session* session, const std::vector<libtorrent::torrent_status>& statuses)
+		{
+			if (statuses.size() == torrents->size())
+			{
+				return;
+			}
+
+			std::unordered_map<libtorrent::info_hash_t, RecheckingTorrent> present;
+			for (const auto& status : statuses)
+			{
+				present.emplace(status.info_hashes, torrents->at(status.info_hashes));
+			}
+			for (const auto& [infoHash, torrent] : *torrents)
+			{
+				if (!present.contains(infoHash))
+				{
+					torrentIds->Remove(torrent.key);
+				}
+			}
+			torrents->swap(present);
+
+			if (torrents->empty())
+			{
+				RestoreSettings(session);
+			}
+		}
+
+		/// <summary>
+		/// Adds the reads allowed since the last update to the budget and takes out those that were made.
+		/// </summary>
+		/// <returns>True if the checking torrents have to pause until the budget recovers.</returns>
+		bool UpdateReadBudget(const Int64 readBytes, const double seconds)
+		{
+			if (maxReadRate <= 0)
+			{
+				return false;
+			}
+
+			// Unused budget is capped at one second's worth, so an idle moment cannot buy a long burst
+			readBudget = Math::Min(readBudget + maxReadRate * seconds - readBytes, static_cast<double>(maxReadRate));
+			return readBudget < 0.0;
+		}
+
+		void RestoreSettings(libtorrent::session* session)
+		{
+			libtorrent::settings_pack settings;
+			settings.set_int(libtorrent::settings_pack::active_checking, savedActiveChecking);
+			settings.set_int(libtorrent::settings_pack::hashing_threads, savedHashingThreads);
+			session->apply_settings(std::move(settings));
+			maxReadRate = 0;
+		}
+	};
+}
@@ -0,0 +1 @@
+#include "SeedModeVerifier.h"
@@ -0,0 +1,220 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/file_storage.hpp>
+#include <libtorrent/torrent_info.hpp>
+#include <string>
+#include <vector>
+#pragma managed(pop)
+
+#include "AddTorrentOptions.h"
+#include "TorrentId.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+using namespace System::Diagnostics;
+using namespace System::IO;
+using namespace System::Security::Cryptography;
+using namespace System::Threading::Tasks;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents the part of a sampled piece that lies in one file.
+	/// </summary>
+	value struct SampledSlice
+	{
+		String^ Path;
+		Int64 Offset;
+		int Length;
+		bool IsPadding;
+	};
+
+	/// <summary>
+	/// Represents a piece picked for verification, with its expected SHA-1 hash and where its data lies on disk.
+	/// </summary>
+	ref class SampledPiece sealed
+	{
+	internal:
+		int Index;
+		array<Byte>^ Hash;
+		array<SampledSlice>^ Slices;
+	};
+
+	/// <summary>
+	/// Hashes a random sample of the pieces of a torrent added in seed mode, reading the files directly rather than
+	/// through libtorrent so the session's disk threads are left to serve peers. The sample is planned from the
+	/// torrent's metadata when the torrent is added and read on the thread pool.
+	/// </summary>
+	ref class SeedModeVerifier sealed
+	{
+		TorrentId^ id;
+		int totalPieces;
+		int pieceLength;
+		array<SampledPiece^>^ pieces;
+		SeedVerificationPolicy^ policy;
+		List<int>^ failedPieces;
+		TimeSpan elapsed;
+		Action<SeedModeVerifier^>^ completed;
+
+		SeedModeVerifier(TorrentId^ id, const int totalPieces, const int pieceLength, array<SampledPiece^>^ pieces,
+			SeedVerificationPolicy^ policy) : id(id), totalPieces(totalPieces), pieceLength(pieceLength),
+			pieces(pieces), policy(policy), failedPieces(gcnew List<int>()), elapsed(TimeSpan::Zero)
+		{
+		}
+
+	internal:
+		property TorrentId^ Id { TorrentId^ get() { return id; } }
+		property int TotalPieces { int get() { return totalPieces; } }
+		property int SampledPieces { int get() { return pieces->Length; } }
+		property IReadOnlyList<int>^ FailedPieces { IReadOnlyList<int>^ get() { return failedPieces; } }
+		property TimeSpan Elapsed { TimeSpan get() { return elapsed; } }
+		property SeedVerificationPolicy^ Policy { SeedVerificationPolicy^ get() { return policy; } }
+
+		/// <summary>
+		/// Picks the pieces to verify and maps them to their files.
+		/// </summary>
+		/// <param name="id">The ID of the torrent.</param>
+		/// <param name="torrentInfo">The metadata of the torrent.</param>
+		/// <param name="savePath">The directory the files of the torrent are in.</param>
+		/// <param name="policy">How many pieces to pick.</param>
+		/// <returns>The verifier, or null if the torrent has no v1 piece hashes to check against.</returns>
+		static SeedModeVerifier^ Create(TorrentId^ id, const libtorrent::torrent_info& torrentInfo,
+			const std::string& savePath, SeedVerificationPolicy^ policy)
+		{
+			if (!torrentInfo.info_hashes().has_v1())
+			{
+				return nullptr;
+			}
+
+			const int totalPieces = torrentInfo.num_pieces();
+			const int sampleSize = Math::Clamp(policy->SampleSize, 0, totalPieces);
+			auto random = policy->RandomSeed->HasValue ? gcnew Random(policy->RandomSeed->Value) : gcnew Random();
+
+			// Sorted so that the sample is read front to back
+			auto indices = gcnew SortedSet<int>();
+			while (indices->Count < sampleSize)
+			{
+				indices->Add(random->Next(totalPieces));
+			}
+
+			const auto& files = torrentInfo.files();
+			auto pieces = gcnew array<SampledPiece^>(sampleSize);
+			int position = 0;
+			for each (int index in indices)
+			{
+				const libtorrent::piece_index_t pieceIndex(index);
+				const auto& hash = torrentInfo.hash_for_piece(pieceIndex);
+				const std::vector<libtorrent::file_slice> fileSlices =
+					torrentInfo.map_block(pieceIndex, 0, torrentInfo.piece_size(pieceIndex));
+
+				auto piece = gcnew SampledPiece();
+				piece->Index = index;
+				piece->Hash = gcnew array<Byte>(static_cast<int>(hash.size()));
+				Runtime::InteropServices::Marshal::Copy(IntPtr(const_cast<char*>(hash.data())), piece->Hash, 0,
+					piece->Hash->Length);
+				piece->Slices = gcnew array<SampledSlice>(static_cast<int>(fileSlices.size()));
+				for (int i = 0; i < piece->Slices->Length; i++)
+				{
+					const auto& fileSlice = fileSlices[i];
+					piece->Slices[i].Path = gcnew String(files.file_path(fileSlice.file_index, savePath).c_str());
+					piece->Slices[i].Offset = fileSlice.offset;
+					piece->Slices[i].Length = static_cast<int>(fileSlice.size);
+					piece->Slices[i].IsPadding = files.pad_file_at(fileSlice.file_index);
+				}
+				pieces[position++] = piece;
+			}
+
+			return gcnew SeedModeVerifier(id, totalPieces, torrentInfo.piece_length(), pieces, policy);
+		}
+
+		/// <summary>
+		/// Starts hashing the sample on the thread pool.
+		/// </summary>
+		/// <param name="onCompleted">Called from the thread pool once every sampled piece has been hashed.</param>
+		void Start(Action<SeedModeVerifier^>^ onCompleted)
+		{
+			completed = onCompleted;
+			Task::Run(gcnew Action(this, &SeedModeVerifier::Run));
+		}
+
+	private:
+		void Run()
+		{
+			auto stopwatch = Stopwatch::StartNew();
+			auto buffer = gcnew array<Byte>(pieceLength);
+			auto sha1 = SHA1::Create();
+			try
+			{
+				for each (auto piece in pieces)
+				{
+					if (!VerifyPiece(piece, buffer, sha1))
+					{
+						failedPieces->Add(piece->Index);
+					}
+				}
+			}
+			finally
+			{
+				delete sha1;
+			}
+
+			elapsed = stopwatch->Elapsed;
+			completed(this);
+		}
+
+		static bool VerifyPiece(SampledPiece^ piece, array<Byte>^ buffer, HashAlgorithm^ sha1)
+		{
+			int position = 0;
+			try
+			{
+				for each (auto slice in piece->Slices)
+				{
+					if (slice.IsPadding)
+					{
+						Array::Clear(buffer, position, slice.Length);
+					}
+					else
+					{
+						// Unbuffered, since each slice is read once in a single call
+						auto stream = gcnew FileStream(slice.Path, FileMode::Open, FileAccess::Read,
+							FileShare::ReadWrite, 1, FileOptions::RandomAccess);
+						try
+						{
+							if (stream->Length < slice.Offset + slice.Length)
+							{
+								return false;
+							}
+							stream->Position = slice.Offset;
+							stream->ReadExactly(buffer, position, slice.Length);
+						}
+						finally
+						{
+							delete stream;
+						}
+					}
+					position += slice.Length;
+				}
+			}
+			catch (IOException^)
+			{
+				// Missing and truncated files count as a bad piece
+				return false;
+			}
+			catch (UnauthorizedAccessException^)
+			{
+				return false;
+			}
+
+			const auto hash = sha1->ComputeHash(buffer, 0, position);
+			for (int i = 0; i < hash->Length; i++)
+			{
+				if (hash[i] != piece->Hash[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+}
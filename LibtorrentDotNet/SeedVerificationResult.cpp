@@ -0,0 +1 @@
+#include "SeedVerificationResult.h"
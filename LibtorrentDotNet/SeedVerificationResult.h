@@ -0,0 +1,97 @@
+#pragma once
+#include "TorrentId.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents the outcome of hashing a random sample of pieces of a torrent added in seed mode.
+	/// </summary>
+	public ref class SeedVerificationResult sealed
+	{
+	public:
+		/// <summary>
+		/// Gets the ID of the torrent.
+		/// </summary>
+		property TorrentId^ Id { TorrentId^ get() { return id; } }
+
+		/// <summary>
+		/// Gets the number of pieces in the torrent.
+		/// </summary>
+		property int TotalPieces { int get() { return totalPieces; } }
+
+		/// <summary>
+		/// Gets the number of pieces that were hashed.
+		/// </summary>
+		property int SampledPieces { int get() { return sampledPieces; } }
+
+		/// <summary>
+		/// Gets the indices of the sampled pieces that were missing or did not match their hash.
+		/// </summary>
+		property IReadOnlyList<int>^ FailedPieces { IReadOnlyList<int>^ get() { return failedPieces; } }
+
+		/// <summary>
+		/// Gets whether every sampled piece matched its hash.
+		/// </summary>
+		property bool Passed { bool get() { return failedPieces->Count == 0; } }
+
+		/// <summary>
+		/// Gets whether the torrent left seed mode to check all of its files because a sampled piece failed.
+		/// </summary>
+		property bool RecheckStarted { bool get() { return recheckStarted; } }
+
+		/// <summary>
+		/// Gets the time it took to read and hash the sample.
+		/// </summary>
+		property TimeSpan Elapsed { TimeSpan get() { return elapsed; } }
+
+		/// <summary>
+		/// Gets the probability that a sample of this size finds at least one bad piece, if the given share of the
+		/// torrent's pieces is corrupt.
+		/// </summary>
+		/// <param name="corruptFraction">The share of corrupt pieces, from 0 to 1.</param>
+		/// <returns>The probability, from 0 to 1.</returns>
+		/// <exception cref="ArgumentOutOfRangeException">Thrown if corruptFraction is not between 0 and 1.</exception>
+		double GetDetectionProbability(const double corruptFraction)
+		{
+			if (!(corruptFraction >= 0.0 && corruptFraction <= 1.0))
+			{
+				throw gcnew ArgumentOutOfRangeException("corruptFraction", corruptFraction,
+					"The corrupt fraction must be between 0 and 1.");
+			}
+
+			const int corruptPieces = static_cast<int>(Math::Ceiling(corruptFraction * totalPieces));
+			if (corruptPieces == 0)
+			{
+				return 0.0;
+			}
+
+			// The pieces are drawn without replacement, so every clean draw shrinks the pool of clean pieces
+			double missProbability = 1.0;
+			for (int i = 0; i < sampledPieces && missProbability > 0.0; i++)
+			{
+				missProbability *= Math::Max(0.0,
+					static_cast<double>(totalPieces - corruptPieces - i) / (totalPieces - i));
+			}
+			return 1.0 - missProbability;
+		}
+
+	internal:
+		SeedVerificationResult(TorrentId^ id, const int totalPieces, const int sampledPieces,
+			IReadOnlyList<int>^ failedPieces, const bool recheckStarted, const TimeSpan elapsed) : id(id),
+			totalPieces(totalPieces), sampledPieces(sampledPieces), failedPieces(failedPieces),
+			recheckStarted(recheckStarted), elapsed(elapsed)
+		{
+		}
+
+	private:
+		TorrentId^ id;
+		int totalPieces;
+		int sampledPieces;
+		IReadOnlyList<int>^ failedPieces;
+		bool recheckStarted;
+		TimeSpan elapsed;
+	};
+}
@@ -0,0 +1 @@
+#include "SessionSettings.h"
@@ -0,0 +1,320 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/session.hpp>
+#include <libtorrent/settings_pack.hpp>
+#include <string>
+#pragma managed(pop)
+
+#include <msclr/marshal_cppstd.h>
+#include "Optional.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+using namespace msclr::interop;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents the set of libtorrent defaults a <see cref="SessionSettings"/> starts from.
+	/// </summary>
+	public enum class SessionSettingsPreset
+	{
+		/// <summary>
+		/// libtorrent's default settings.
+		/// </summary>
+		Default,
+
+		/// <summary>
+		/// libtorrent's high_performance_seed() settings, tuned for seeding to many peers on a fast connection
+		/// at the cost of memory.
+		/// </summary>
+		HighPerformanceSeed,
+
+		/// <summary>
+		/// libtorrent's min_memory_usage() settings, which trade throughput for a small memory footprint.
+		/// </summary>
+		MinMemoryUsage
+	};
+
+	/// <summary>
+	/// Represents how bandwidth is shared between TCP and uTP peers.
+	/// </summary>
+	public enum class MixedModeAlgorithm
+	{
+		/// <summary>
+		/// TCP peers are preferred and uTP peers are throttled whenever TCP peers are connected.
+		/// </summary>
+		PreferTcp = libtorrent::settings_pack::prefer_tcp,
+
+		/// <summary>
+		/// Bandwidth is shared in proportion to the number of TCP and uTP peers.
+		/// </summary>
+		PeerProportional = libtorrent::settings_pack::peer_proportional
+	};
+
+	/// <summary>
+	/// Represents the performance tuning settings of a session, on top of a preset. Only the knobs that matter for
+	/// throughput are typed properties; the rest of libtorrent's settings list is set by name with <see cref="Set"/>,
+	/// which checks the name and type against libtorrent, and listed by <see cref="GetSettingNames"/>. The list is
+	/// deliberately not mirrored as properties: libtorrent adds and deprecates settings between minor releases, and
+	/// a property for each would tie the public API of this library to one libtorrent version.
+	/// </summary>
+	public ref class SessionSettings sealed
+	{
+	public:
+		/// <summary>
+		/// Gets or sets the preset the settings start from. The default is <see cref="SessionSettingsPreset::Default"/>.
+		/// </summary>
+		property SessionSettingsPreset Preset;
+
+		/// <summary>
+		/// Gets or sets the number of bytes queued in a peer's send buffer before more data is read from disk.
+		/// </summary>
+		property Optional<int>^ SendBufferWatermark;
+
+		/// <summary>
+		/// Gets or sets the maximum number of bytes waiting to be written to disk before peers stop being read from.
+		/// </summary>
+		property Optional<int>^ MaxQueuedDiskBytes;
+
+		/// <summary>
+		/// Gets or sets the number of threads performing disk reads and writes.
+		/// </summary>
+		property Optional<int>^ AioThreads;
+
+		/// <summary>
+		/// Gets or sets the number of threads hashing pieces.
+		/// </summary>
+		property Optional<int>^ HashingThreads;
+
+		/// <summary>
+		/// Gets or sets the number of outgoing connection attempts made per second.
+		/// </summary>
+		property Optional<int>^ ConnectionSpeed;
+
+		/// <summary>
+		/// Gets or sets the maximum number of peers unchoked at the same time. Use -1 for unlimited.
+		/// </summary>
+		property Optional<int>^ UnchokeSlotsLimit;
+
+		/// <summary>
+		/// Gets or sets how bandwidth is shared between TCP and uTP peers.
+		/// </summary>
+		property Optional<MixedModeAlgorithm>^ MixedMode;
+
+		/// <summary>
+		/// Initializes a new instance of the SessionSettings class with default values.
+		/// </summary>
+		SessionSettings()
+		{
+			Preset = SessionSettingsPreset::Default;
+			SendBufferWatermark = Optional<int>::None();
+			MaxQueuedDiskBytes = Optional<int>::None();
+			AioThreads = Optional<int>::None();
+			HashingThreads = Optional<int>::None();
+			ConnectionSpeed = Optional<int>::None();
+			UnchokeSlotsLimit = Optional<int>::None();
+			MixedMode = Optional<MixedModeAlgorithm>::None();
+			overrides = gcnew Dictionary<String^, Object^>();
+		}
+
+		/// <summary>
+		/// Creates settings starting from libtorrent's high performance seed preset.
+		/// </summary>
+		static SessionSettings^ HighPerformanceSeed()
+		{
+			auto settings = gcnew SessionSettings();
+			settings->Preset = SessionSettingsPreset::HighPerformanceSeed;
+			return settings;
+		}
+
+		/// <summary>
+		/// Creates settings starting from libtorrent's minimal memory usage preset.
+		/// </summary>
+		static SessionSettings^ MinMemoryUsage()
+		{
+			auto settings = gcnew SessionSettings();
+			settings->Preset = SessionSettingsPreset::MinMemoryUsage;
+			return settings;
+		}
+
+		/// <summary>
+		/// Gets the names of every setting libtorrent knows, as accepted by <see cref="Set"/>.
+		/// </summary>
+		static IReadOnlyList<String^>^ GetSettingNames()
+		{
+			auto names = gcnew List<String^>();
+			AddSettingNames(names, libtorrent::settings_pack::string_type_base,
+				libtorrent::settings_pack::max_string_setting_internal);
+			AddSettingNames(names, libtorrent::settings_pack::int_type_base,
+				libtorrent::settings_pack::max_int_setting_internal);
+			AddSettingNames(names, libtorrent::settings_pack::bool_type_base,
+				libtorrent::settings_pack::max_bool_setting_internal);
+			return names->AsReadOnly();
+		}
+
+		/// <summary>
+		/// Sets an integer setting by its libtorrent name, such as "send_buffer_watermark".
+		/// </summary>
+		/// <exception cref="ArgumentException">The setting does not exist or is not an integer setting.</exception>
+		void Set(String^ name, int value)
+		{
+			FindSetting(name, libtorrent::settings_pack::int_type_base);
+			overrides[name] = value;
+		}
+
+		/// <summary>
+		/// Sets a boolean setting by its libtorrent name, such as "enable_outgoing_utp".
+		/// </summary>
+		/// <exception cref="ArgumentException">The setting does not exist or is not a boolean setting.</exception>
+		void Set(String^ name, bool value)
+		{
+			FindSetting(name, libtorrent::settings_pack::bool_type_base);
+			overrides[name] = value;
+		}
+
+		/// <summary>
+		/// Sets a string setting by its libtorrent name, such as "user_agent".
+		/// </summary>
+		/// <exception cref="ArgumentException">The setting does not exist or is not a string setting.</exception>
+		void Set(String^ name, String^ value)
+		{
+			ArgumentNullException::ThrowIfNull(value, "value");
+			FindSetting(name, libtorrent::settings_pack::string_type_base);
+			overrides[name] = value;
+		}
+
+		/// <summary>
+		/// Removes a setting previously set by name, so that it falls back to the preset.
+		/// </summary>
+		/// <returns>true if the setting had been set.</returns>
+		bool Unset(String^ name)
+		{
+			ArgumentNullException::ThrowIfNull(name, "name");
+			return overrides->Remove(name);
+		}
+
+		/// <summary>
+		/// Checks that every setting is within its valid range.
+		/// </summary>
+		/// <exception cref="ArgumentOutOfRangeException">A setting is out of range.</exception>
+		void Validate()
+		{
+			ValidateAtLeast(SendBufferWatermark, 1, "SendBufferWatermark");
+			ValidateAtLeast(MaxQueuedDiskBytes, 1, "MaxQueuedDiskBytes");
+			ValidateAtLeast(AioThreads, 1, "AioThreads");
+			ValidateAtLeast(HashingThreads, 1, "HashingThreads");
+			ValidateAtLeast(ConnectionSpeed, 0, "ConnectionSpeed");
+			ValidateAtLeast(UnchokeSlotsLimit, -1, "UnchokeSlotsLimit");
+
+			if (MixedMode->HasValue && !Enum::IsDefined(MixedModeAlgorithm::typeid, MixedMode->Value))
+			{
+				throw gcnew ArgumentOutOfRangeException("MixedMode", MixedMode->Value, "Unknown mixed mode algorithm.");
+			}
+		}
+
+	internal:
+		/// <summary>
+		/// Validates the settings and converts them to a settings pack: the preset, overridden by the typed
+		/// properties, overridden by the settings set by name.
+		/// </summary>
+		libtorrent::settings_pack ToSettingsPack()
+		{
+			Validate();
+
+			libtorrent::settings_pack settings;
+			switch (Preset)
+			{
+			case SessionSettingsPreset::HighPerformanceSeed:
+				settings = libtorrent::high_performance_seed();
+				break;
+			case SessionSettingsPreset::MinMemoryUsage:
+				settings = libtorrent::min_memory_usage();
+				break;
+			default:
+				break;
+			}
+
+			SetIfPresent(settings, libtorrent::settings_pack::send_buffer_watermark, SendBufferWatermark);
+			SetIfPresent(settings, libtorrent::settings_pack::max_queued_disk_bytes, MaxQueuedDiskBytes);
+			SetIfPresent(settings, libtorrent::settings_pack::aio_threads, AioThreads);
+			SetIfPresent(settings, libtorrent::settings_pack::hashing_threads, HashingThreads);
+			SetIfPresent(settings, libtorrent::settings_pack::connection_speed, ConnectionSpeed);
+			SetIfPresent(settings, libtorrent::settings_pack::unchoke_slots_limit, UnchokeSlotsLimit);
+			if (MixedMode->HasValue)
+			{
+				settings.set_int(libtorrent::settings_pack::mixed_mode_algorithm, static_cast<int>(MixedMode->Value));
+			}
+
+			marshal_context context;
+			for each (auto entry in overrides)
+			{
+				const int setting = libtorrent::setting_by_name(context.marshal_as<std::string>(entry.Key));
+				switch (setting & libtorrent::settings_pack::type_mask)
+				{
+				case libtorrent::settings_pack::string_type_base:
+					settings.set_str(setting, context.marshal_as<std::string>(safe_cast<String^>(entry.Value)));
+					break;
+				case libtorrent::settings_pack::int_type_base:
+					settings.set_int(setting, safe_cast<int>(entry.Value));
+					break;
+				case libtorrent::settings_pack::bool_type_base:
+					settings.set_bool(setting, safe_cast<bool>(entry.Value));
+					break;
+				}
+			}
+
+			return settings;
+		}
+
+	private:
+		Dictionary<String^, Object^>^ overrides;
+
+		static int FindSetting(String^ name, const int expectedType)
+		{
+			ArgumentNullException::ThrowIfNull(name, "name");
+
+			marshal_context context;
+			const int setting = libtorrent::setting_by_name(context.marshal_as<std::string>(name));
+			if (setting < 0)
+			{
+				throw gcnew ArgumentException(String::Format("Unknown setting '{0}'.", name), "name");
+			}
+			if ((setting & libtorrent::settings_pack::type_mask) != expectedType)
+			{
+				throw gcnew ArgumentException(String::Format("Setting '{0}' has a different type.", name), "name");
+			}
+			return setting;
+		}
+
+		static void AddSettingNames(List<String^>^ names, const int first, const int end)
+		{
+			for (int setting = first; setting < end; setting++)
+			{
+				// Removed settings keep their slot but have no name
+				if (const char* name = libtorrent::name_for_setting(setting); name != nullptr && *name != '\0')
+				{
+					names->Add(gcnew String(name));
+				}
+			}
+		}
+
+		static void ValidateAtLeast(Optional<int>^ value, const int minimum, String^ name)
+		{
+			if (value->HasValue && value->Value < minimum)
+			{
+				throw gcnew ArgumentOutOfRangeException(name, value->Value,
+					String::Format("Must be at least {0}.", minimum));
+			}
+		}
+
+		static void SetIfPresent(libtorrent::settings_pack& settings, const int setting, Optional<int>^ value)
+		{
+			if (value->HasValue)
+			{
+				settings.set_int(setting, value->Value);
+			}
+		}
+	};
+}
@@ -0,0 +1 @@
+#include "SessionStatistics.h"
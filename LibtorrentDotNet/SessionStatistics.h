@@ -0,0 +1,227 @@
+#pragma once
+
+using namespace System;
+using namespace System::Collections::Generic;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents how the value of a session metric behaves over time.
+	/// </summary>
+	public enum class SessionMetricKind
+	{
+		/// <summary>
+		/// A total that only grows, such as the number of bytes sent.
+		/// </summary>
+		Counter,
+
+		/// <summary>
+		/// A current level that goes up and down, such as the number of queued disk jobs.
+		/// </summary>
+		Gauge
+	};
+
+	/// <summary>
+	/// Represents the value of one session metric in a <see cref="SessionStatistics"/> snapshot.
+	/// </summary>
+	public value struct SessionMetric
+	{
+	public:
+		SessionMetric(String^ name, const SessionMetricKind kind, const Int64 value) : name(name), kind(kind), value(value)
+		{
+		}
+
+		/// <summary>
+		/// Gets libtorrent's name of the metric, such as "net.sent_bytes".
+		/// </summary>
+		property String^ Name { String^ get() { return name; } }
+
+		/// <summary>
+		/// Gets whether the metric is a counter or a gauge.
+		/// </summary>
+		property SessionMetricKind Kind { SessionMetricKind get() { return kind; } }
+
+		/// <summary>
+		/// Gets the value of the metric.
+		/// </summary>
+		property Int64 Value { Int64 get() { return value; } }
+
+	private:
+		String^ name;
+		SessionMetricKind kind;
+		Int64 value;
+	};
+
+	/// <summary>
+	/// Holds the names and kinds of libtorrent's session metrics, read once and shared by every snapshot.
+	/// </summary>
+	ref class SessionMetricSchema sealed
+	{
+	internal:
+		SessionMetricSchema(array<String^>^ names, array<SessionMetricKind>^ kinds) : names(names), kinds(kinds),
+			indices(gcnew Dictionary<String^, int>(names->Length, StringComparer::Ordinal))
+		{
+			for (int i = 0; i < names->Length; i++)
+			{
+				if (names[i] != nullptr)
+				{
+					indices[names[i]] = i;
+				}
+			}
+
+			sentBytes = IndexOf("net.sent_bytes");
+			receivedBytes = IndexOf("net.recv_bytes");
+			connectedPeers = IndexOf("peer.num_peers_connected");
+			halfOpenConnections = IndexOf("peer.num_peers_half_open");
+			disconnectedPeers = IndexOf("peer.disconnected_peers");
+			queuedDiskJobs = IndexOf("disk.queued_disk_jobs");
+			queuedWriteBytes = IndexOf("disk.queued_write_bytes");
+			dhtNodes = IndexOf("dht.dht_nodes");
+			piecePicks = IndexOf("picker.piece_picks");
+		}
+
+		array<String^>^ names;
+		array<SessionMetricKind>^ kinds;
+		Dictionary<String^, int>^ indices;
+
+		// Indices of the metrics behind the typed properties of SessionStatistics
+		int sentBytes;
+		int receivedBytes;
+		int connectedPeers;
+		int halfOpenConnections;
+		int disconnectedPeers;
+		int queuedDiskJobs;
+		int queuedWriteBytes;
+		int dhtNodes;
+		int piecePicks;
+
+		int IndexOf(String^ name)
+		{
+			int index;
+			return indices->TryGetValue(name, index) ? index : -1;
+		}
+	};
+
+	/// <summary>
+	/// Represents a snapshot of libtorrent's session performance counters and gauges.
+	/// </summary>
+	public ref class SessionStatistics sealed
+	{
+	public:
+		/// <summary>
+		/// Gets the time the snapshot was taken.
+		/// </summary>
+		property DateTime Timestamp { DateTime get() { return timestamp; } }
+
+		/// <summary>
+		/// Gets every metric in the snapshot.
+		/// </summary>
+		property IReadOnlyList<SessionMetric>^ Metrics
+		{
+			IReadOnlyList<SessionMetric>^ get()
+			{
+				auto metrics = gcnew List<SessionMetric>(values->Length);
+				for (int i = 0; i < values->Length; i++)
+				{
+					if (schema->names[i] != nullptr)
+					{
+						metrics->Add(SessionMetric(schema->names[i], schema->kinds[i], values[i]));
+					}
+				}
+				return metrics->AsReadOnly();
+			}
+		}
+
+		/// <summary>
+		/// Gets the value of a metric by its libtorrent name, such as "disk.queued_disk_jobs".
+		/// </summary>
+		/// <exception cref="KeyNotFoundException">Thrown if the session has no metric with that name.</exception>
+		property Int64 default[String^]
+		{
+			Int64 get(String^ name)
+			{
+				Int64 value;
+				if (!TryGetValue(name, value))
+				{
+					throw gcnew KeyNotFoundException(String::Format("Unknown session metric '{0}'.", name));
+				}
+				return value;
+			}
+		}
+
+		/// <summary>
+		/// Gets the value of a metric by its libtorrent name.
+		/// </summary>
+		/// <returns>true if the session has a metric with that name.</returns>
+		bool TryGetValue(String^ name, [Runtime::InteropServices::Out] Int64% value)
+		{
+			ArgumentNullException::ThrowIfNull(name, "name");
+			const int index = schema->IndexOf(name);
+			value = GetValueOrZero(index);
+			return index >= 0;
+		}
+
+		/// <summary>
+		/// Gets the total number of bytes sent, including protocol overhead.
+		/// </summary>
+		property Int64 SentBytes { Int64 get() { return GetValueOrZero(schema->sentBytes); } }
+
+		/// <summary>
+		/// Gets the total number of bytes received, including protocol overhead.
+		/// </summary>
+		property Int64 ReceivedBytes { Int64 get() { return GetValueOrZero(schema->receivedBytes); } }
+
+		/// <summary>
+		/// Gets the number of connected peers.
+		/// </summary>
+		property Int64 ConnectedPeers { Int64 get() { return GetValueOrZero(schema->connectedPeers); } }
+
+		/// <summary>
+		/// Gets the number of outgoing connections that are still being established.
+		/// </summary>
+		property Int64 HalfOpenConnections { Int64 get() { return GetValueOrZero(schema->halfOpenConnections); } }
+
+		/// <summary>
+		/// Gets the total number of peers that were disconnected.
+		/// </summary>
+		property Int64 DisconnectedPeers { Int64 get() { return GetValueOrZero(schema->disconnectedPeers); } }
+
+		/// <summary>
+		/// Gets the number of disk jobs waiting to be run.
+		/// </summary>
+		property Int64 QueuedDiskJobs { Int64 get() { return GetValueOrZero(schema->queuedDiskJobs); } }
+
+		/// <summary>
+		/// Gets the number of bytes waiting to be written to disk.
+		/// </summary>
+		property Int64 QueuedWriteBytes { Int64 get() { return GetValueOrZero(schema->queuedWriteBytes); } }
+
+		/// <summary>
+		/// Gets the number of nodes in the DHT routing table.
+		/// </summary>
+		property Int64 DhtNodes { Int64 get() { return GetValueOrZero(schema->dhtNodes); } }
+
+		/// <summary>
+		/// Gets the total number of pieces the piece picker picked.
+		/// </summary>
+		property Int64 PiecePicks { Int64 get() { return GetValueOrZero(schema->piecePicks); } }
+
+	internal:
+		SessionStatistics(SessionMetricSchema^ schema, array<Int64>^ values, const DateTime timestamp) :
+			schema(schema),
+			values(values),
+			timestamp(timestamp)
+		{
+		}
+
+	private:
+		SessionMetricSchema^ schema;
+		array<Int64>^ values;
+		DateTime timestamp;
+
+		Int64 GetValueOrZero(const int index)
+		{
+			return index >= 0 && index < values->Length ? values[index] : 0;
+		}
+	};
+}
@@ -0,0 +1 @@
+#include "SessionStatsCollector.h"
@@ -0,0 +1,177 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/alert_types.hpp>
+#include <libtorrent/session_stats.hpp>
+#pragma managed(pop)
+
+#include "SessionStatistics.h"
+#include "TorrentSessionConfig.h"
+
+using namespace System;
+using namespace System::Diagnostics::Metrics;
+using namespace System::Threading;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Turns session_stats_alert into <see cref="SessionStatistics"/> snapshots and publishes the latest one as
+	/// System.Diagnostics.Metrics instruments. The metric names are decoded once; a sample only copies the values.
+	/// </summary>
+	ref class SessionStatsCollector sealed
+	{
+		static initonly TimeSpan DefaultSamplingInterval = TimeSpan::FromSeconds(5);
+
+		ref class MetricReader sealed
+		{
+			SessionStatsCollector^ collector;
+			int index;
+
+		public:
+			MetricReader(SessionStatsCollector^ collector, const int index) : collector(collector), index(index)
+			{
+			}
+
+			Int64 Read()
+			{
+				auto latest = collector->latestValues;
+				return latest != nullptr && index < latest->Length ? latest[index] : 0;
+			}
+		};
+
+		bool enabled;
+		TimeSpan samplingInterval;
+		DateTime lastPosted;
+		SessionMetricSchema^ schema;
+		SessionStatistics^ latest;
+		array<Int64>^ latestValues;
+		Meter^ meter;
+
+	internal:
+		/// <summary>
+		/// The name of the meter the instruments are published on.
+		/// </summary>
+		static initonly String^ MeterName = "LibtorrentDotNet.Session";
+
+		/// <summary>
+		/// Initializes a new instance of the SessionStatsCollector class.
+		/// </summary>
+		/// <param name="config">The sampling settings, or null to keep sampling disabled.</param>
+		SessionStatsCollector(SessionStatsConfig^ config) :
+			enabled(false),
+			samplingInterval(DefaultSamplingInterval),
+			lastPosted(DateTime::MinValue)
+		{
+			if (config != nullptr)
+			{
+				enabled = config->Enabled->GetValueOrDefault(false);
+				samplingInterval = config->SamplingInterval->GetValueOrDefault(DefaultSamplingInterval);
+			}
+
+			if (!enabled)
+			{
+				return;
+			}
+
+			const auto& metrics = libtorrent::session_stats_metrics();
+			int size = 0;
+			for (const auto& metric : metrics)
+			{
+				size = Math::Max(size, metric.value_index + 1);
+			}
+
+			auto names = gcnew array<String^>(size);
+			auto kinds = gcnew array<SessionMetricKind>(size);
+			for (const auto& metric : metrics)
+			{
+				names[metric.value_index] = gcnew String(metric.name);
+				kinds[metric.value_index] = metric.type == libtorrent::metric_type_t::gauge
+					? SessionMetricKind::Gauge
+					: SessionMetricKind::Counter;
+			}
+			schema = gcnew SessionMetricSchema(names, kinds);
+
+			meter = gcnew Meter(MeterName);
+			for (int i = 0; i < size; i++)
+			{
+				if (names[i] == nullptr)
+				{
+					continue;
+				}
+
+				auto read = gcnew Func<Int64>(gcnew MetricReader(this, i), &MetricReader::Read);
+				auto instrumentName = String::Concat("libtorrent.", names[i]);
+				if (kinds[i] == SessionMetricKind::Gauge)
+				{
+					meter->CreateObservableGauge<Int64>(instrumentName, read, nullptr, nullptr);
+				}
+				else
+				{
+					meter->CreateObservableCounter<Int64>(instrumentName, read, nullptr, nullptr);
+				}
+			}
+		}
+
+		~SessionStatsCollector()
+		{
+			if (meter != nullptr)
+			{
+				delete meter;
+				meter = nullptr;
+			}
+		}
+
+		/// <summary>
+		/// Gets a value indicating whether sampling is enabled.
+		/// </summary>
+		property bool IsEnabled { bool get() { return enabled; } }
+
+		/// <summary>
+		/// Gets the most recent snapshot, or null if no sample was taken yet.
+		/// </summary>
+		property SessionStatistics^ Latest { SessionStatistics^ get() { return latest; } }
+
+		/// <summary>
+		/// Returns true, and starts a new sampling period, if a sample is due.
+		/// </summary>
+		bool IsSampleDue()
+		{
+			if (!enabled)
+			{
+				return false;
+			}
+
+			const auto now = DateTime::UtcNow;
+			if (now - lastPosted < samplingInterval)
+			{
+				return false;
+			}
+
+			lastPosted = now;
+			return true;
+		}
+
+		/// <summary>
+		/// Copies the values of a session_stats_alert into a new snapshot.
+		/// </summary>
+		SessionStatistics^ OnSessionStats(const libtorrent::session_stats_alert* alert)
+		{
+			if (!enabled)
+			{
+				return nullptr;
+			}
+
+			const auto counters = alert->counters();
+			auto values = gcnew array<Int64>(static_cast<int>(counters.size()));
+			for (int i = 0; i < values->Length; i++)
+			{
+				values[i] = counters[i];
+			}
+
+			auto snapshot = gcnew SessionStatistics(schema, values, DateTime::Now);
+			latestValues = values;
+			latest = snapshot;
+			return snapshot;
+		}
+	};
+}
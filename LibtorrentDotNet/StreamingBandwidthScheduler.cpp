@@ -0,0 +1 @@
+#include "StreamingBandwidthScheduler.h"
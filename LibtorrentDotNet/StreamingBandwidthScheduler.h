@@ -0,0 +1,317 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/info_hash.hpp>
+#include <libtorrent/session.hpp>
+#include <libtorrent/torrent_flags.hpp>
+#include <libtorrent/torrent_handle.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#pragma managed(pop)
+
+#include "TorrentSessionConfig.h"
+#include "TorrentStreamMetrics.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+using namespace System::Threading;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// The limits a torrent had before the scheduler throttled it.
+	/// </summary>
+	struct ThrottledTorrent
+	{
+		int downloadLimit;
+		int maxConnections;
+		bool pausedByScheduler;
+		bool wasAutoManaged;
+	};
+
+	/// <summary>
+	/// Throttles or pauses the torrents that have no open stream while any stream is running low on data, and restores
+	/// them once every stream has a healthy buffer again. Without this, deadlines only order pieces within the streamed
+	/// torrent, while all other torrents keep competing for the session's bandwidth and connection slots.
+	/// </summary>
+	ref class StreamingBandwidthScheduler sealed
+	{
+		static initonly Int32 DefaultBackgroundDownloadRateLimit = 32 * 1024;
+		static initonly Int32 DefaultBackgroundMaxConnections = 4;
+		static initonly Int32 DefaultLowBufferSeconds = 5;
+		static initonly Int32 DefaultHealthyBufferSeconds = 20;
+
+		bool enabled;
+		bool pauseBackgroundTorrents;
+		int backgroundDownloadRateLimit;
+		int backgroundMaxConnections;
+		double lowBufferSeconds;
+		double healthyBufferSeconds;
+		bool throttling;
+		Object^ syncRoot;
+		std::unordered_map<libtorrent::info_hash_t, ThrottledTorrent>* throttledTorrents;
+
+	internal:
+		/// <summary>
+		/// Initializes a new instance of the StreamingBandwidthScheduler class.
+		/// </summary>
+		/// <param name="config">The scheduler settings, or null to keep the scheduler disabled.</param>
+		StreamingBandwidthScheduler(StreamingSchedulerConfig^ config) :
+			enabled(false),
+			pauseBackgroundTorrents(false),
+			backgroundDownloadRateLimit(DefaultBackgroundDownloadRateLimit),
+			backgroundMaxConnections(DefaultBackgroundMaxConnections),
+			lowBufferSeconds(DefaultLowBufferSeconds),
+			healthyBufferSeconds(DefaultHealthyBufferSeconds),
+			throttling(false),
+			syncRoot(gcnew Object()),
+			throttledTorrents(new std::unordered_map<libtorrent::info_hash_t, ThrottledTorrent>())
+		{
+			if (config != nullptr)
+			{
+				enabled = config->Enabled->GetValueOrDefault(false);
+				pauseBackgroundTorrents = config->PauseBackgroundTorrents->GetValueOrDefault(false);
+				backgroundDownloadRateLimit = config->BackgroundDownloadRateLimit->GetValueOrDefault(
+					DefaultBackgroundDownloadRateLimit);
+				backgroundMaxConnections = config->BackgroundMaxConnections->GetValueOrDefault(
+					DefaultBackgroundMaxConnections);
+				lowBufferSeconds = config->LowBufferThreshold->GetValueOrDefault(
+					TimeSpan::FromSeconds(DefaultLowBufferSeconds)).TotalSeconds;
+				healthyBufferSeconds = Math::Max(lowBufferSeconds, config->HealthyBufferThreshold->GetValueOrDefault(
+					TimeSpan::FromSeconds(DefaultHealthyBufferSeconds)).TotalSeconds);
+			}
+		}
+
+		~StreamingBandwidthScheduler()
+		{
+			this->!StreamingBandwidthScheduler();
+		}
+
+		!StreamingBandwidthScheduler()
+		{
+			if (throttledTorrents != nullptr)
+			{
+				delete throttledTorrents;
+				throttledTorrents = nullptr;
+			}
+		}
+
+		/// <summary>
+		/// Gets a value indicating whether the scheduler is enabled.
+		/// </summary>
+		property bool IsEnabled { bool get() { return enabled; } }
+
+		/// <summary>
+		/// Throttles or restores the background torrents based on the current metrics of the open streams.
+		/// </summary>
+		/// <param name="session">The session owning the torrents.</param>
+		/// <param name="metrics">The metrics of every open stream.</param>
+		/// <param name="streamingTorrents">The torrents that have at least one open stream.</param>
+		void Update(libtorrent::session* session, IReadOnlyList<TorrentStreamMetrics^>^ metrics,
+			const std::unordered_set<libtorrent::info_hash_t>& streamingTorrents)
+		{
+			if (!enabled)
+			{
+				return;
+			}
+
+			bool starved = false;
+			bool healthy = true;
+			for each (auto stream in metrics)
+			{
+				// A stream that has everything up to its end cannot be starved by other torrents
+				if (stream->BufferedBytes >= stream->Length - stream->Position)
+				{
+					continue;
+				}
+
+				if (stream->IsStalled || stream->BufferedSeconds < lowBufferSeconds)
+				{
+					starved = true;
+				}
+
+				if (stream->BufferedSeconds < healthyBufferSeconds)
+				{
+					healthy = false;
+				}
+			}
+
+			Monitor::Enter(syncRoot);
+			try
+			{
+				if (!throttling && starved)
+				{
+					throttling = true;
+				}
+				else if (throttling && healthy)
+				{
+					throttling = false;
+					RestoreAll(session);
+					return;
+				}
+
+				if (throttling)
+				{
+					ThrottleBackground(session, streamingTorrents);
+				}
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Gets a value indicating whether a torrent is currently throttled or paused by the scheduler.
+		/// </summary>
+		bool IsThrottled(const libtorrent::info_hash_t& infoHash)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				return throttledTorrents->contains(infoHash);
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Replaces the download limit a throttled torrent returns to once it is restored.
+		/// </summary>
+		/// <returns>true if the torrent is currently throttled and the new limit was deferred.</returns>
+		bool DeferDownloadLimit(const libtorrent::info_hash_t& infoHash, int downloadLimit)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				const auto entry = throttledTorrents->find(infoHash);
+				if (entry == throttledTorrents->end())
+				{
+					return false;
+				}
+
+				entry->second.downloadLimit = downloadLimit;
+				return true;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Records that a torrent was paused explicitly, so that restoring it does not resume it.
+		/// </summary>
+		/// <returns>true if the scheduler paused the torrent and took it out of the queue, which resuming it explicitly
+		/// has to undo.</returns>
+		bool OnTorrentPaused(const libtorrent::info_hash_t& infoHash)
+		{
+			Monitor::Enter(syncRoot);
+			try
+			{
+				const auto entry = throttledTorrents->find(infoHash);
+				if (entry == throttledTorrents->end())
+				{
+					return false;
+				}
+
+				const bool wasAutoManaged = entry->second.wasAutoManaged;
+				entry->second.pausedByScheduler = false;
+				entry->second.wasAutoManaged = false;
+				return wasAutoManaged;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+	private:
+		void ThrottleBackground(libtorrent::session* session,
+			const std::unordered_set<libtorrent::info_hash_t>& streamingTorrents)
+		{
+			for (const auto& handle : session->get_torrents())
+			{
+				const auto& infoHash = handle.info_hashes();
+				const auto entry = throttledTorrents->find(infoHash);
+
+				if (streamingTorrents.contains(infoHash))
+				{
+					// A stream was opened on a throttled torrent
+					if (entry != throttledTorrents->end())
+					{
+						Restore(handle, entry->second);
+						throttledTorrents->erase(entry);
+					}
+					continue;
+				}
+
+				if (entry != throttledTorrents->end())
+				{
+					continue;
+				}
+
+				ThrottledTorrent previous{};
+				previous.downloadLimit = handle.download_limit();
+				previous.maxConnections = handle.max_connections();
+
+				if (pauseBackgroundTorrents)
+				{
+					const auto flags = handle.flags();
+					if (!(flags & libtorrent::torrent_flags::paused))
+					{
+						// The queue would resume an auto managed torrent right away
+						previous.wasAutoManaged = static_cast<bool>(flags & libtorrent::torrent_flags::auto_managed);
+						previous.pausedByScheduler = true;
+						handle.unset_flags(libtorrent::torrent_flags::auto_managed);
+						handle.pause();
+					}
+				}
+				else
+				{
+					handle.set_download_limit(backgroundDownloadRateLimit);
+					handle.set_max_connections(backgroundMaxConnections);
+				}
+
+				throttledTorrents->emplace(infoHash, previous);
+			}
+		}
+
+		void RestoreAll(libtorrent::session* session)
+		{
+			for (const auto& [infoHash, previous] : *throttledTorrents)
+			{
+				// A torrent removed while throttled took its limits with it, so there is nothing to give back
+				if (const auto& handle = session->find_torrent(infoHash.get_best()); handle.is_valid())
+				{
+					Restore(handle, previous);
+				}
+			}
+
+			throttledTorrents->clear();
+		}
+
+		void Restore(const libtorrent::torrent_handle& handle, const ThrottledTorrent& previous)
+		{
+			if (pauseBackgroundTorrents)
+			{
+				if (previous.pausedByScheduler)
+				{
+					handle.resume();
+				}
+
+				if (previous.wasAutoManaged)
+				{
+					handle.set_flags(libtorrent::torrent_flags::auto_managed);
+				}
+			}
+			else
+			{
+				handle.set_download_limit(previous.downloadLimit);
+				handle.set_max_connections(previous.maxConnections);
+			}
+		}
+	};
+}
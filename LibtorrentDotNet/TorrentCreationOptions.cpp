@@ -0,0 +1 @@
+#include "TorrentCreationOptions.h"
@@ -0,0 +1,112 @@
+#pragma once
+#include "Optional.h"
+
+using namespace System;
+using namespace System::Collections::Generic;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents the BitTorrent protocol versions a created torrent supports.
+	/// </summary>
+	public enum class TorrentVersion
+	{
+		/// <summary>
+		/// The torrent has both v1 and v2 metadata, so it can be shared with clients that support either.
+		/// </summary>
+		Hybrid,
+
+		/// <summary>
+		/// The torrent only has v1 metadata, with SHA-1 piece hashes.
+		/// </summary>
+		V1Only,
+
+		/// <summary>
+		/// The torrent only has v2 metadata, with SHA-256 merkle trees per file.
+		/// </summary>
+		V2Only
+	};
+
+	/// <summary>
+	/// Represents the options for creating a torrent from files on disk.
+	/// </summary>
+	public ref class TorrentCreationOptions sealed
+	{
+	public:
+		/// <summary>
+		/// Gets the file or directory the torrent is created from.
+		/// </summary>
+		property String^ SourcePath
+		{
+			String^ get() { return sourcePath; }
+		}
+
+		/// <summary>
+		/// Gets or sets the protocol versions the torrent supports. The default is <see cref="TorrentVersion::Hybrid"/>.
+		/// </summary>
+		property TorrentVersion Version;
+
+		/// <summary>
+		/// Gets or sets the piece size in bytes. It must be a power of two of at least 16 KiB. The default picks a
+		/// size from the total size of the files.
+		/// </summary>
+		property Optional<int>^ PieceSize;
+
+		/// <summary>
+		/// Gets or sets the number of threads that hash pieces in parallel. The default is the number of processors.
+		/// </summary>
+		property Optional<int>^ HashingThreads;
+
+		/// <summary>
+		/// Gets or sets the tracker URLs of the torrent, each in its own tier.
+		/// </summary>
+		property IReadOnlyList<String^>^ Trackers;
+
+		/// <summary>
+		/// Gets or sets the web seed URLs of the torrent.
+		/// </summary>
+		property IReadOnlyList<String^>^ WebSeeds;
+
+		/// <summary>
+		/// Gets or sets the comment stored in the torrent.
+		/// </summary>
+		property String^ Comment;
+
+		/// <summary>
+		/// Gets or sets the name of the program that created the torrent. The default is "LibtorrentDotNet".
+		/// </summary>
+		property String^ Creator;
+
+		/// <summary>
+		/// Gets or sets whether the torrent is private, which limits peer discovery to its trackers.
+		/// </summary>
+		property bool IsPrivate;
+
+		/// <summary>
+		/// Initializes a new instance of the TorrentCreationOptions class with default values.
+		/// </summary>
+		/// <param name="sourcePath">The file or directory to create the torrent from.</param>
+		/// <exception cref="ArgumentException">Thrown when sourcePath is null, empty, or does not exist.</exception>
+		TorrentCreationOptions(String^ sourcePath)
+		{
+			if (String::IsNullOrWhiteSpace(sourcePath))
+				throw gcnew ArgumentException("Source path cannot be null or empty.", "sourcePath");
+
+			if (!IO::File::Exists(sourcePath) && !IO::Directory::Exists(sourcePath))
+				throw gcnew ArgumentException("Source path does not exist.", "sourcePath");
+
+			this->sourcePath = sourcePath;
+			Version = TorrentVersion::Hybrid;
+			PieceSize = Optional<int>::None();
+			HashingThreads = Optional<int>::None();
+			Trackers = nullptr;
+			WebSeeds = nullptr;
+			Comment = nullptr;
+			Creator = "LibtorrentDotNet";
+			IsPrivate = false;
+		}
+
+	private:
+		String^ sourcePath;
+	};
+}
@@ -0,0 +1 @@
+#include "TorrentCreator.h"
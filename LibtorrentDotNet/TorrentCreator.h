@@ -0,0 +1,307 @@
+#pragma once
+
+#pragma managed(push, off)
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/create_torrent.hpp>
+#include <libtorrent/error_code.hpp>
+#include <libtorrent/settings_pack.hpp>
+#include <libtorrent/torrent_info.hpp>
+#include <iterator>
+#include <string>
+#include <vector>
+#pragma managed(pop)
+
+#include <msclr/marshal_cppstd.h>
+#include <vcclr.h>
+#include "AddTorrentRequest.h"
+#include "TorrentCreationOptions.h"
+#include "TorrentId.h"
+#include "Utilities.h"
+
+using namespace System;
+using namespace System::Threading;
+using namespace msclr::interop;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents how far the hashing of a torrent being created has come.
+	/// </summary>
+	public value struct TorrentCreationProgress
+	{
+	public:
+		TorrentCreationProgress(const int piecesHashed, const int totalPieces) :
+			piecesHashed(piecesHashed), totalPieces(totalPieces)
+		{
+		}
+
+		/// <summary>
+		/// Gets the number of pieces hashed so far.
+		/// </summary>
+		property int PiecesHashed { int get() { return piecesHashed; } }
+
+		/// <summary>
+		/// Gets the number of pieces in the torrent.
+		/// </summary>
+		property int TotalPieces { int get() { return totalPieces; } }
+
+	private:
+		int piecesHashed;
+		int totalPieces;
+	};
+
+	/// <summary>
+	/// Represents a torrent created by <see cref="TorrentCreator"/>.
+	/// </summary>
+	public ref class CreatedTorrent sealed
+	{
+	public:
+		/// <summary>
+		/// Gets the ID of the torrent, the same one the session reports once the torrent is added.
+		/// </summary>
+		property TorrentId^ Id { TorrentId^ get() { return id; } }
+
+		/// <summary>
+		/// Gets the bencoded .torrent file.
+		/// </summary>
+		property array<Byte>^ TorrentData { array<Byte>^ get() { return torrentData; } }
+
+		/// <summary>
+		/// Gets the directory that contains the source file or directory, which is the save path to seed it from.
+		/// </summary>
+		property String^ SavePath { String^ get() { return savePath; } }
+
+		/// <summary>
+		/// Gets the number of pieces in the torrent.
+		/// </summary>
+		property int PieceCount { int get() { return pieceCount; } }
+
+		/// <summary>
+		/// Gets the piece size in bytes.
+		/// </summary>
+		property int PieceSize { int get() { return pieceSize; } }
+
+		/// <summary>
+		/// Creates a request that adds the torrent to a session, seeding from the directory its data was hashed
+		/// from. The torrent is added in seed mode, since its files were just hashed and need no checking.
+		/// </summary>
+		AddTorrentFromByteArrayRequest^ ToAddRequest()
+		{
+			auto options = gcnew AddTorrentOptions();
+			options->SeedMode = true;
+			return gcnew AddTorrentFromByteArrayRequest(torrentData, savePath, options);
+		}
+
+	internal:
+		CreatedTorrent(TorrentId^ id, array<Byte>^ torrentData, String^ savePath, const int pieceCount,
+			const int pieceSize) : id(id), torrentData(torrentData), savePath(savePath), pieceCount(pieceCount),
+			pieceSize(pieceSize)
+		{
+		}
+
+	private:
+		TorrentId^ id;
+		array<Byte>^ torrentData;
+		String^ savePath;
+		int pieceCount;
+		int pieceSize;
+	};
+
+	/// <summary>
+	/// Counts hashed pieces for <see cref="TorrentCreator"/>, reports progress and checks for cancellation.
+	/// </summary>
+	ref class PieceHashReporter sealed
+	{
+		IProgress<TorrentCreationProgress>^ progress;
+		CancellationToken cancellationToken;
+		int totalPieces;
+		int piecesHashed;
+		bool canceled;
+
+	internal:
+		PieceHashReporter(IProgress<TorrentCreationProgress>^ progress, const CancellationToken cancellationToken,
+			const int totalPieces) : progress(progress), cancellationToken(cancellationToken), totalPieces(totalPieces),
+			piecesHashed(0), canceled(false)
+		{
+		}
+
+		/// <summary>
+		/// Gets a value indicating whether creation was canceled while the pieces were hashed.
+		/// </summary>
+		property bool IsCanceled { bool get() { return canceled; } }
+
+		/// <summary>
+		/// Records a hashed piece. Once creation is canceled, the pieces still hashed are no longer reported.
+		/// </summary>
+		void OnPieceHashed()
+		{
+			canceled = canceled || cancellationToken.IsCancellationRequested;
+			if (canceled)
+			{
+				return;
+			}
+
+			piecesHashed++;
+			if (progress != nullptr)
+			{
+				progress->Report(TorrentCreationProgress(piecesHashed, totalPieces));
+			}
+		}
+	};
+
+	/// <summary>
+	/// The piece callback of set_piece_hashes, forwarding to a <see cref="PieceHashReporter"/>. It must not throw:
+	/// it runs inside libtorrent's completion handler while hash jobs for other pieces are still in flight.
+	/// </summary>
+	struct PieceHashedCallback
+	{
+		gcroot<PieceHashReporter^> reporter;
+
+		void operator()(libtorrent::piece_index_t) const
+		{
+			reporter->OnPieceHashed();
+		}
+	};
+
+	/// <summary>
+	/// Creates torrents from files on disk.
+	/// </summary>
+	public ref class TorrentCreator abstract sealed
+	{
+	public:
+		/// <summary>
+		/// Creates a torrent from a file or directory. The pieces are hashed on several threads by libtorrent's
+		/// disk subsystem, which reads the files through memory maps so the reads are large and sequential.
+		/// </summary>
+		/// <param name="options">What to create the torrent from and how.</param>
+		/// <param name="progress">Receives the hashing progress, or null. It is called on the calling thread, which
+		/// runs the completion handlers of libtorrent's hash jobs until every piece is hashed.</param>
+		/// <param name="cancellationToken">Cancels the creation. libtorrent cannot stop hashing part way, so a
+		/// cancellation during hashing stops the progress reports and throws once the hash jobs have drained.</param>
+		/// <returns>The created torrent.</returns>
+		/// <exception cref="ArgumentOutOfRangeException">Thrown if the piece size or thread count is invalid.</exception>
+		/// <exception cref="OperationCanceledException">Thrown if the creation was canceled.</exception>
+		/// <exception cref="TorrentException">Thrown if the files could not be read.</exception>
+		static CreatedTorrent^ CreateTorrent(TorrentCreationOptions^ options,
+			IProgress<TorrentCreationProgress>^ progress, CancellationToken cancellationToken)
+		{
+			ArgumentNullException::ThrowIfNull(options, "options");
+
+			const int pieceSize = options->PieceSize->GetValueOrDefault(0);
+			if (options->PieceSize->HasValue && (pieceSize < 16 * 1024 || (pieceSize & (pieceSize - 1)) != 0))
+			{
+				throw gcnew ArgumentOutOfRangeException("options",
+					"Piece size must be a power of two of at least 16 KiB.");
+			}
+
+			const int hashingThreads = options->HashingThreads->GetValueOrDefault(Environment::ProcessorCount);
+			if (hashingThreads < 1)
+			{
+				throw gcnew ArgumentOutOfRangeException("options", "Hashing threads must be at least 1.");
+			}
+
+			cancellationToken.ThrowIfCancellationRequested();
+
+			auto sourcePath = IO::Path::TrimEndingDirectorySeparator(IO::Path::GetFullPath(options->SourcePath));
+			auto savePath = IO::Path::GetDirectoryName(sourcePath);
+			if (savePath == nullptr)
+			{
+				throw gcnew ArgumentException("A torrent cannot be created from a root directory.", "options");
+			}
+
+			try
+			{
+				marshal_context context;
+				libtorrent::file_storage files;
+				libtorrent::add_files(files, context.marshal_as<std::string>(sourcePath));
+				if (files.num_files() == 0)
+				{
+					throw gcnew ArgumentException("The source path contains no files.", "options");
+				}
+
+				libtorrent::create_torrent creator(files, pieceSize, ToCreateFlags(options->Version));
+				if (options->Trackers != nullptr)
+				{
+					int tier = 0;
+					for each (auto tracker in options->Trackers)
+					{
+						creator.add_tracker(context.marshal_as<std::string>(tracker), tier++);
+					}
+				}
+				if (options->WebSeeds != nullptr)
+				{
+					for each (auto webSeed in options->WebSeeds)
+					{
+						creator.add_url_seed(context.marshal_as<std::string>(webSeed));
+					}
+				}
+				if (!String::IsNullOrEmpty(options->Comment))
+				{
+					creator.set_comment(context.marshal_as<std::string>(options->Comment).c_str());
+				}
+				if (!String::IsNullOrEmpty(options->Creator))
+				{
+					creator.set_creator(context.marshal_as<std::string>(options->Creator).c_str());
+				}
+				creator.set_priv(options->IsPrivate);
+
+				libtorrent::settings_pack settings;
+				settings.set_int(libtorrent::settings_pack::hashing_threads, hashingThreads);
+				settings.set_int(libtorrent::settings_pack::aio_threads, hashingThreads);
+
+				auto reporter = gcnew PieceHashReporter(progress, cancellationToken, creator.num_pieces());
+				const PieceHashedCallback callback{ reporter };
+				libtorrent::error_code ec;
+				libtorrent::set_piece_hashes(creator, context.marshal_as<std::string>(savePath), settings, callback, ec);
+				if (reporter->IsCanceled)
+				{
+					throw gcnew OperationCanceledException(cancellationToken);
+				}
+				if (ec)
+				{
+					throw gcnew TorrentException(
+						String::Format("Failed to hash the files of the torrent: {0}", gcnew String(ec.message().c_str())));
+				}
+
+				std::vector<char> buffer;
+				libtorrent::bencode(std::back_inserter(buffer), creator.generate());
+
+				const libtorrent::torrent_info torrentInfo(buffer, libtorrent::from_span);
+				auto torrentData = gcnew array<Byte>(static_cast<int>(buffer.size()));
+				Runtime::InteropServices::Marshal::Copy(IntPtr(buffer.data()), torrentData, 0, torrentData->Length);
+
+				return gcnew CreatedTorrent(TorrentId::FromInfoHash(torrentInfo.info_hashes()), torrentData, savePath,
+					creator.num_pieces(), creator.piece_length());
+			}
+			catch (const std::exception& e)
+			{
+				throw gcnew TorrentException(String::Format("Failed to create torrent: {0}", gcnew String(e.what())));
+			}
+		}
+
+		/// <summary>
+		/// Creates a torrent from a file or directory.
+		/// </summary>
+		/// <param name="options">What to create the torrent from and how.</param>
+		/// <returns>The created torrent.</returns>
+		static CreatedTorrent^ CreateTorrent(TorrentCreationOptions^ options)
+		{
+			return CreateTorrent(options, nullptr, CancellationToken::None);
+		}
+
+	private:
+		static libtorrent::create_flags_t ToCreateFlags(const TorrentVersion version)
+		{
+			switch (version)
+			{
+			case TorrentVersion::V1Only:
+				return libtorrent::create_torrent::v1_only;
+			case TorrentVersion::V2Only:
+				return libtorrent::create_torrent::v2_only;
+			default:
+				return {};
+			}
+		}
+
+	};
+}
@@ -4,6 +4,10 @@
 #include "TorrentId.h"
 #include "TorrentInfo.h"
 #include "TorrentStatus.h"
+#include "TorrentStreamMetrics.h"
+#include "SessionStatistics.h"
+#include "SeedVerificationResult.h"
+#include "RecheckOptions.h"
 
 using namespace System;
 using namespace System::Collections::Generic;
@@ -93,4 +97,82 @@ namespace LibtorrentDotNet
     private:
         TorrentInfo^ torrentInfo;
     };
-}
+
+    /// <summary>
+    /// Represents the arguments for a stream metrics event.
+    /// </summary>
+    public ref class TorrentStreamMetricsEventArgs sealed : EventArgs
+    {
+    public:
+        TorrentStreamMetricsEventArgs(IReadOnlyList<TorrentStreamMetrics^>^ streams)
+            : streams(streams) {}
+
+        /// <summary>
+        /// Gets the metrics of every open stream of the session.
+        /// </summary>
+        property IReadOnlyList<TorrentStreamMetrics^>^ Streams { IReadOnlyList<TorrentStreamMetrics^>^ get() { return streams; } }
+
+    private:
+        IReadOnlyList<TorrentStreamMetrics^>^ streams;
+    };
+
+    /// <summary>
+    /// Represents the arguments for a session statistics event.
+    /// </summary>
+    public ref class SessionStatisticsEventArgs sealed : EventArgs
+    {
+    public:
+        SessionStatisticsEventArgs(SessionStatistics^ statistics)
+            : statistics(statistics) {}
+
+        /// <summary>
+        /// Gets the newly sampled performance counters of the session.
+        /// </summary>
+        property SessionStatistics^ Statistics { SessionStatistics^ get() { return statistics; } }
+
+    private:
+        SessionStatistics^ statistics;
+    };
+
+    /// <summary>
+    /// Represents the arguments for a seed verification event.
+    /// </summary>
+    public ref class SeedVerificationEventArgs sealed : EventArgs
+    {
+    public:
+        SeedVerificationEventArgs(SeedVerificationResult^ result)
+            : result(result) {}
+
+        /// <summary>
+        /// Gets the outcome of hashing the sampled pieces.
+        /// </summary>
+        property SeedVerificationResult^ Result { SeedVerificationResult^ get() { return result; } }
+
+    private:
+        SeedVerificationResult^ result;
+    };
+
+    /// <summary>
+    /// Represents the arguments for a recheck progress event.
+    /// </summary>
+    public ref class RecheckProgressEventArgs sealed : EventArgs
+    {
+    public:
+        RecheckProgressEventArgs(IReadOnlyList<RecheckProgress^>^ torrents, const Int64 readRate)
+            : torrents(torrents), readRate(readRate) {}
+
+        /// <summary>
+        /// Gets the progress of every torrent being rechecked, and of those that completed or failed since the last event.
+        /// </summary>
+        property IReadOnlyList<RecheckProgress^>^ Torrents { IReadOnlyList<RecheckProgress^>^ get() { return torrents; } }
+
+        /// <summary>
+        /// Gets the rate in bytes per second at which the rechecked torrents read from disk since the last event.
+        /// </summary>
+        property Int64 ReadRate { Int64 get() { return readRate; } }
+
+    private:
+        IReadOnlyList<RecheckProgress^>^ torrents;
+        Int64 readRate;
+    };
+}
\ No newline at end of file
@@ -0,0 +1 @@
+#include "TorrentHttpServer.h"
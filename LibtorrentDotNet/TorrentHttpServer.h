@@ -0,0 +1,616 @@
+#pragma once
+
+#include "TorrentHttpServerOptions.h"
+#include "TorrentSession.h"
+
+using namespace System;
+using namespace System::Buffers;
+using namespace System::Collections::Generic;
+using namespace System::IO;
+using namespace System::Net;
+using namespace System::Net::Sockets;
+using namespace System::Text;
+using namespace System::Threading;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Serves the files of a session's torrents over HTTP/1.1 on the loopback interface, so that media players can
+	/// open them by URL while they are being downloaded.
+	/// </summary>
+	/// <remarks>
+	/// Files are addressed as <c>/{torrentId}/{fileIndex}</c>; any further path segment, such as the file name, is
+	/// ignored so players can still detect the format from the URL. GET and HEAD requests are supported, with single
+	/// byte ranges and keep-alive connections. Each connection is served on its own thread from its own
+	/// <see cref="TorrentStream"/>, which is kept open across requests for the same file.
+	/// </remarks>
+	public ref class TorrentHttpServer sealed : IDisposable
+	{
+	private:
+		static initonly Int32 SendBufferSize = 256 * 1024;
+		static initonly Int32 MaxRequestHeaders = 100;
+		static initonly Int32 DefaultReadTimeoutSeconds = 30;
+		static initonly Int32 DefaultIdleTimeoutSeconds = 120;
+
+		enum class RangeResult
+		{
+			Full,
+			Partial,
+			Unsatisfiable
+		};
+
+		ref class HttpRequest sealed
+		{
+		public:
+			HttpRequest() : headers(gcnew Dictionary<String^, String^>(StringComparer::OrdinalIgnoreCase))
+			{
+			}
+
+			String^ method;
+			String^ target;
+			String^ version;
+			Dictionary<String^, String^>^ headers;
+
+			String^ GetHeader(String^ name)
+			{
+				String^ value;
+				return headers->TryGetValue(name, value) ? value : nullptr;
+			}
+
+			bool KeepAlive()
+			{
+				auto connection = GetHeader("Connection");
+				if (version == "HTTP/1.0")
+				{
+					return connection != nullptr && connection->Equals("keep-alive", StringComparison::OrdinalIgnoreCase);
+				}
+				return connection == nullptr || !connection->Equals("close", StringComparison::OrdinalIgnoreCase);
+			}
+		};
+
+		ITorrentSession^ session;
+		TcpListener^ listener;
+		Thread^ acceptThread;
+		HashSet<TcpClient^>^ connections;
+		TimeSpan readTimeout;
+		TimeSpan idleTimeout;
+		TorrentStreamOptions^ streamOptions;
+		Object^ syncRoot;
+		volatile bool disposed;
+
+		TorrentHttpServer(ITorrentSession^ session, TorrentHttpServerOptions^ options) :
+			session(session),
+			listener(gcnew TcpListener(IPAddress::Loopback, options->Port->GetValueOrDefault(0))),
+			acceptThread(nullptr),
+			connections(gcnew HashSet<TcpClient^>()),
+			readTimeout(options->ReadTimeout->GetValueOrDefault(TimeSpan::FromSeconds(DefaultReadTimeoutSeconds))),
+			idleTimeout(options->IdleTimeout->GetValueOrDefault(TimeSpan::FromSeconds(DefaultIdleTimeoutSeconds))),
+			streamOptions(options->StreamOptions != nullptr ? options->StreamOptions : gcnew TorrentStreamOptions()),
+			syncRoot(gcnew Object()),
+			disposed(false)
+		{
+		}
+
+	public:
+		/// <summary>
+		/// Starts a server for a session on a free loopback port.
+		/// </summary>
+		/// <param name="session">The session whose torrents are served.</param>
+		/// <returns>The running server.</returns>
+		static TorrentHttpServer^ Start(ITorrentSession^ session)
+		{
+			return Start(session, gcnew TorrentHttpServerOptions());
+		}
+
+		/// <summary>
+		/// Starts a server for a session with the specified options.
+		/// </summary>
+		/// <param name="session">The session whose torrents are served.</param>
+		/// <param name="options">The options of the server.</param>
+		/// <returns>The running server.</returns>
+		/// <exception cref="SocketException">Thrown if the port is already in use.</exception>
+		static TorrentHttpServer^ Start(ITorrentSession^ session, TorrentHttpServerOptions^ options)
+		{
+			ArgumentNullException::ThrowIfNull(session, "session");
+			ArgumentNullException::ThrowIfNull(options, "options");
+
+			auto server = gcnew TorrentHttpServer(session, options);
+			server->listener->Start();
+
+			server->acceptThread = gcnew Thread(gcnew ThreadStart(server, &TorrentHttpServer::AcceptConnections));
+			server->acceptThread->IsBackground = true;
+			server->acceptThread->Name = "TorrentHttpServer";
+			server->acceptThread->Start();
+
+			return server;
+		}
+
+		~TorrentHttpServer()
+		{
+			if (disposed)
+			{
+				return;
+			}
+
+			disposed = true;
+			listener->Stop();
+
+			Monitor::Enter(syncRoot);
+			try
+			{
+				// Closing the sockets unblocks the connection threads, which then dispose their streams
+				for each (auto client in connections)
+				{
+					client->Close();
+				}
+				connections->Clear();
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Gets the loopback port the server listens on.
+		/// </summary>
+		property int Port
+		{
+			int get() { return safe_cast<IPEndPoint^>(listener->LocalEndpoint)->Port; }
+		}
+
+		/// <summary>
+		/// Gets the base address of the server, e.g. <c>http://127.0.0.1:50123/</c>.
+		/// </summary>
+		property Uri^ BaseAddress
+		{
+			Uri^ get() { return gcnew Uri(String::Format("http://127.0.0.1:{0}/", Port)); }
+		}
+
+		/// <summary>
+		/// Gets the URL a file of a torrent is served at.
+		/// </summary>
+		/// <param name="torrentId">The ID of the torrent containing the file.</param>
+		/// <param name="fileIndex">The index of the file within the torrent.</param>
+		/// <returns>The URL of the file.</returns>
+		Uri^ GetFileUri(TorrentId^ torrentId, int fileIndex)
+		{
+			ArgumentNullException::ThrowIfNull(torrentId, "torrentId");
+			return gcnew Uri(BaseAddress, String::Format("{0}/{1}", torrentId, fileIndex));
+		}
+
+	private:
+		void AcceptConnections()
+		{
+			while (!disposed)
+			{
+				TcpClient^ client;
+				try
+				{
+					client = listener->AcceptTcpClient();
+				}
+				catch (SocketException^)
+				{
+					if (disposed)
+					{
+						return;
+					}
+					continue;
+				}
+				catch (ObjectDisposedException^)
+				{
+					return;
+				}
+
+				Monitor::Enter(syncRoot);
+				try
+				{
+					if (disposed)
+					{
+						client->Close();
+						return;
+					}
+					connections->Add(client);
+				}
+				finally
+				{
+					Monitor::Exit(syncRoot);
+				}
+
+				// Reads block until the swarm delivers, so every connection gets its own thread instead of a pool worker
+				auto connectionThread = gcnew Thread(gcnew ParameterizedThreadStart(this, &TorrentHttpServer::ServeConnection));
+				connectionThread->IsBackground = true;
+				connectionThread->Start(client);
+			}
+		}
+
+		void ServeConnection(Object^ state)
+		{
+			auto client = safe_cast<TcpClient^>(state);
+			auto sendBuffer = ArrayPool<Byte>::Shared->Rent(SendBufferSize);
+			TorrentStream^ stream = nullptr;
+			TorrentId^ streamTorrentId = nullptr;
+			int streamFileIndex = -1;
+			String^ contentType = nullptr;
+
+			try
+			{
+				client->NoDelay = true;
+				auto network = client->GetStream();
+				network->ReadTimeout = static_cast<int>(idleTimeout.TotalMilliseconds);
+				auto reader = gcnew StreamReader(network, Encoding::ASCII, false, 4096, true);
+
+				bool keepAlive = true;
+				while (keepAlive && !disposed)
+				{
+					auto request = ReadRequest(reader);
+					if (request == nullptr)
+					{
+						break;
+					}
+
+					if (request->method == nullptr)
+					{
+						WriteEmptyResponse(network, 400, nullptr, false);
+						break;
+					}
+
+					keepAlive = request->KeepAlive();
+
+					if (request->method != "GET" && request->method != "HEAD")
+					{
+						WriteEmptyResponse(network, 405, "Allow: GET, HEAD\r\n", keepAlive);
+						continue;
+					}
+
+					TorrentId^ torrentId;
+					int fileIndex;
+					if (!TryParseTarget(request->target, torrentId, fileIndex))
+					{
+						WriteEmptyResponse(network, 404, nullptr, keepAlive);
+						continue;
+					}
+
+					if (stream == nullptr || streamTorrentId != torrentId || streamFileIndex != fileIndex)
+					{
+						if (stream != nullptr)
+						{
+							delete stream;
+							stream = nullptr;
+						}
+
+						try
+						{
+							stream = session->StreamFile(torrentId, fileIndex, readTimeout, streamOptions);
+						}
+						catch (ArgumentException^)
+						{
+							WriteEmptyResponse(network, 404, nullptr, keepAlive);
+							continue;
+						}
+						catch (FileNotFoundException^)
+						{
+							WriteEmptyResponse(network, 404, nullptr, keepAlive);
+							continue;
+						}
+						catch (InvalidOperationException^)
+						{
+							// Typically the metadata of a magnet link has not arrived yet
+							WriteEmptyResponse(network, 503, "Retry-After: 1\r\n", keepAlive);
+							continue;
+						}
+
+						streamTorrentId = torrentId;
+						streamFileIndex = fileIndex;
+						contentType = GetContentType(torrentId, fileIndex);
+					}
+
+					keepAlive = ServeFile(network, request, stream, contentType, sendBuffer) && keepAlive;
+				}
+			}
+			catch (IOException^)
+			{
+				// The client went away or the connection idled out
+			}
+			catch (ObjectDisposedException^)
+			{
+				// The server was disposed
+			}
+			catch (Exception^ ex)
+			{
+				Diagnostics::Trace::WriteLine(String::Format("Exception in TorrentHttpServer connection: {0}", ex->Message));
+			}
+			finally
+			{
+				if (stream != nullptr)
+				{
+					delete stream;
+				}
+
+				ArrayPool<Byte>::Shared->Return(sendBuffer);
+
+				Monitor::Enter(syncRoot);
+				try
+				{
+					connections->Remove(client);
+				}
+				finally
+				{
+					Monitor::Exit(syncRoot);
+				}
+
+				client->Close();
+			}
+		}
+
+		/// <summary>
+		/// Writes the response to a file request.
+		/// </summary>
+		/// <returns>false if the body could not be completed and the connection has to be closed.</returns>
+		bool ServeFile(Stream^ network, HttpRequest^ request, TorrentStream^ stream, String^ contentType,
+			array<Byte>^ sendBuffer)
+		{
+			const Int64 length = stream->Length;
+			Int64 start;
+			Int64 end;
+
+			const auto range = ParseRange(request->GetHeader("Range"), length, start, end);
+			if (range == RangeResult::Unsatisfiable)
+			{
+				WriteEmptyResponse(network, 416, String::Format("Content-Range: bytes */{0}\r\n", length), request->KeepAlive());
+				return true;
+			}
+
+			auto headers = gcnew StringBuilder();
+			headers->AppendFormat("Content-Type: {0}\r\n", contentType);
+			headers->Append("Accept-Ranges: bytes\r\n");
+			headers->AppendFormat("Content-Length: {0}\r\n", end - start + 1);
+			if (range == RangeResult::Partial)
+			{
+				headers->AppendFormat("Content-Range: bytes {0}-{1}/{2}\r\n", start, end, length);
+			}
+
+			WriteResponseHead(network, range == RangeResult::Partial ? 206 : 200, headers->ToString(), request->KeepAlive());
+
+			if (request->method == "HEAD")
+			{
+				return true;
+			}
+
+			stream->Position = start;
+			Int64 remaining = end - start + 1;
+			while (remaining > 0)
+			{
+				const int toRead = static_cast<int>(Math::Min(static_cast<Int64>(sendBuffer->Length), remaining));
+				const int bytesRead = stream->Read(sendBuffer, 0, toRead);
+				if (bytesRead <= 0)
+				{
+					// The pieces did not arrive in time; the promised length can no longer be honoured
+					return false;
+				}
+
+				network->Write(sendBuffer, 0, bytesRead);
+				remaining -= bytesRead;
+			}
+
+			return true;
+		}
+
+		/// <summary>
+		/// Reads the next request of a connection.
+		/// </summary>
+		/// <returns>The request, null if the client closed the connection, or a request without a method if it was malformed.</returns>
+		static HttpRequest^ ReadRequest(StreamReader^ reader)
+		{
+			String^ requestLine;
+			do
+			{
+				requestLine = reader->ReadLine();
+				if (requestLine == nullptr)
+				{
+					return nullptr;
+				}
+			} while (requestLine->Length == 0);
+
+			auto request = gcnew HttpRequest();
+			auto parts = requestLine->Split(' ');
+
+			for (int headerCount = 0;; headerCount++)
+			{
+				auto line = reader->ReadLine();
+				if (line == nullptr)
+				{
+					return nullptr;
+				}
+
+				if (line->Length == 0)
+				{
+					break;
+				}
+
+				const int separator = line->IndexOf(':');
+				if (separator <= 0 || headerCount >= MaxRequestHeaders)
+				{
+					return request;
+				}
+
+				request->headers[line->Substring(0, separator)->Trim()] = line->Substring(separator + 1)->Trim();
+			}
+
+			if (parts->Length != 3 || !parts[2]->StartsWith("HTTP/1."))
+			{
+				return request;
+			}
+
+			request->method = parts[0];
+			request->target = parts[1];
+			request->version = parts[2];
+			return request;
+		}
+
+		static bool TryParseTarget(String^ target, TorrentId^% torrentId, int% fileIndex)
+		{
+			torrentId = nullptr;
+			fileIndex = -1;
+
+			const int query = target->IndexOf('?');
+			if (query >= 0)
+			{
+				target = target->Substring(0, query);
+			}
+
+			auto segments = target->Split(gcnew array<wchar_t>{ '/' }, StringSplitOptions::RemoveEmptyEntries);
+			if (segments->Length < 2 || !Int32::TryParse(segments[1], fileIndex) || fileIndex < 0)
+			{
+				return false;
+			}
+
+			try
+			{
+				torrentId = gcnew TorrentId(segments[0]->ToLowerInvariant());
+				return true;
+			}
+			catch (ArgumentException^)
+			{
+				return false;
+			}
+		}
+
+		/// <summary>
+		/// Parses a Range header. Only single byte ranges are honoured; anything else is answered with the whole file,
+		/// which HTTP allows in place of a multipart response.
+		/// </summary>
+		static RangeResult ParseRange(String^ header, Int64 length, Int64% start, Int64% end)
+		{
+			start = 0;
+			end = length - 1;
+
+			if (String::IsNullOrEmpty(header) || !header->StartsWith("bytes=", StringComparison::OrdinalIgnoreCase))
+			{
+				return RangeResult::Full;
+			}
+
+			auto spec = header->Substring(6)->Trim();
+			const int dash = spec->IndexOf('-');
+			if (dash < 0 || spec->Contains(","))
+			{
+				return RangeResult::Full;
+			}
+
+			auto first = spec->Substring(0, dash)->Trim();
+			auto last = spec->Substring(dash + 1)->Trim();
+			Int64 firstValue = 0;
+			Int64 lastValue = 0;
+
+			if (first->Length == 0)
+			{
+				// Suffix range: the last N bytes of the file
+				if (!Int64::TryParse(last, lastValue) || lastValue < 0)
+				{
+					return RangeResult::Full;
+				}
+
+				if (lastValue == 0 || length == 0)
+				{
+					return RangeResult::Unsatisfiable;
+				}
+
+				start = Math::Max(0LL, length - lastValue);
+				return RangeResult::Partial;
+			}
+
+			if (!Int64::TryParse(first, firstValue) || firstValue < 0)
+			{
+				return RangeResult::Full;
+			}
+
+			if (last->Length > 0 && (!Int64::TryParse(last, lastValue) || lastValue < firstValue))
+			{
+				return RangeResult::Full;
+			}
+
+			if (firstValue >= length)
+			{
+				return RangeResult::Unsatisfiable;
+			}
+
+			start = firstValue;
+			if (last->Length > 0)
+			{
+				end = Math::Min(lastValue, length - 1);
+			}
+
+			return RangeResult::Partial;
+		}
+
+		String^ GetContentType(TorrentId^ torrentId, int fileIndex)
+		{
+			try
+			{
+				for each (auto entry in session->GetTorrentInfo(torrentId)->TorrentFileEntries)
+				{
+					if (entry->FileIndex == fileIndex)
+					{
+						return GetContentType(Path::GetExtension(entry->Name));
+					}
+				}
+			}
+			catch (InvalidOperationException^)
+			{
+				// The torrent was removed in the meantime
+			}
+
+			return GetContentType(String::Empty);
+		}
+
+		static String^ GetContentType(String^ extension)
+		{
+			auto normalized = extension->ToLowerInvariant();
+			if (normalized == ".mp4" || normalized == ".m4v") return "video/mp4";
+			if (normalized == ".mkv") return "video/x-matroska";
+			if (normalized == ".webm") return "video/webm";
+			if (normalized == ".avi") return "video/x-msvideo";
+			if (normalized == ".mov") return "video/quicktime";
+			if (normalized == ".ts") return "video/mp2t";
+			if (normalized == ".mp3") return "audio/mpeg";
+			if (normalized == ".m4a") return "audio/mp4";
+			if (normalized == ".flac") return "audio/flac";
+			if (normalized == ".ogg") return "audio/ogg";
+			if (normalized == ".srt") return "application/x-subrip";
+			if (normalized == ".vtt") return "text/vtt";
+			return "application/octet-stream";
+		}
+
+		static void WriteEmptyResponse(Stream^ network, int statusCode, String^ headers, bool keepAlive)
+		{
+			WriteResponseHead(network, statusCode, String::Concat(headers, "Content-Length: 0\r\n"), keepAlive);
+		}
+
+		static void WriteResponseHead(Stream^ network, int statusCode, String^ headers, bool keepAlive)
+		{
+			auto builder = gcnew StringBuilder();
+			builder->AppendFormat("HTTP/1.1 {0} {1}\r\n", statusCode, GetReasonPhrase(statusCode));
+			builder->Append(headers);
+			builder->Append(keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+			builder->Append("\r\n");
+
+			auto bytes = Encoding::ASCII->GetBytes(builder->ToString());
+			network->Write(bytes, 0, bytes->Length);
+		}
+
+		static String^ GetReasonPhrase(int statusCode)
+		{
+			switch (statusCode)
+			{
+			case 200: return "OK";
+			case 206: return "Partial Content";
+			case 400: return "Bad Request";
+			case 404: return "Not Found";
+			case 405: return "Method Not Allowed";
+			case 416: return "Range Not Satisfiable";
+			case 503: return "Service Unavailable";
+			default: return "Unknown";
+			}
+		}
+	};
+}
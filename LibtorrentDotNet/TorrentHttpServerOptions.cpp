@@ -0,0 +1 @@
+#include "TorrentHttpServerOptions.h"
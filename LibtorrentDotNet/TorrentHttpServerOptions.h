@@ -0,0 +1,47 @@
+#pragma once
+#include "Optional.h"
+#include "TorrentStreamOptions.h"
+
+using namespace System;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents the options used when starting a <see cref="TorrentHttpServer"/>.
+	/// </summary>
+	public ref class TorrentHttpServerOptions sealed
+	{
+	public:
+		/// <summary>
+		/// Gets or sets the loopback port the server listens on. The default lets the operating system pick a free port.
+		/// </summary>
+		property Optional<int>^ Port;
+
+		/// <summary>
+		/// Gets or sets how long a response waits for missing pieces before the connection is closed.
+		/// The default is 30 seconds.
+		/// </summary>
+		property Optional<TimeSpan>^ ReadTimeout;
+
+		/// <summary>
+		/// Gets or sets how long an idle keep-alive connection stays open. The default is 2 minutes.
+		/// </summary>
+		property Optional<TimeSpan>^ IdleTimeout;
+
+		/// <summary>
+		/// Gets or sets the options of the streams opened to serve requests.
+		/// </summary>
+		property TorrentStreamOptions^ StreamOptions;
+
+		/// <summary>
+		/// Initializes a new instance of the TorrentHttpServerOptions class with default values.
+		/// </summary>
+		TorrentHttpServerOptions()
+		{
+			Port = Optional<int>::None();
+			ReadTimeout = Optional<TimeSpan>::None();
+			IdleTimeout = Optional<TimeSpan>::None();
+			StreamOptions = gcnew TorrentStreamOptions();
+		}
+	};
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#pragma managed(push, off)
+#include <libtorrent/info_hash.hpp>
+#pragma managed(pop)
+
 using namespace System;
 
 namespace LibtorrentDotNet
@@ -88,6 +92,28 @@ namespace LibtorrentDotNet
 			return cachedHashCode;
 		}
 
+	internal:
+		/// <summary>
+		/// Creates the ID of a torrent from its info hashes. Torrents with v2 metadata are identified by their full
+		/// SHA-256 hash, the others by their SHA-1 hash.
+		/// </summary>
+		static TorrentId^ FromInfoHash(const libtorrent::info_hash_t& infoHash)
+		{
+			static const wchar_t hexDigits[] = L"0123456789ABCDEF";
+
+			const char* hash = infoHash.has_v2() ? infoHash.v2.data() : infoHash.v1.data();
+			const int hashSize = infoHash.has_v2() ? 32 : 20;
+			wchar_t hexString[64];
+			for (int i = 0; i < hashSize; i++)
+			{
+				const auto value = static_cast<unsigned char>(hash[i]);
+				hexString[i * 2] = hexDigits[value >> 4];
+				hexString[i * 2 + 1] = hexDigits[value & 0x0F];
+			}
+
+			return gcnew TorrentId(gcnew String(hexString, 0, hashSize * 2));
+		}
+
 	private:
 		initonly String^ infoHash;
 		initonly int cachedHashCode;
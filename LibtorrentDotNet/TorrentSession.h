@@ -1,13 +1,18 @@
 #pragma once
 
 #pragma managed(push, off)
+#include <algorithm>
 #include <cstring>
 #include <exception>
 #include <libtorrent/add_torrent_params.hpp>
 #include <libtorrent/alert_types.hpp>
 #include <libtorrent/info_hash.hpp>
 #include <libtorrent/magnet_uri.hpp>
+#include <libtorrent/mmap_disk_io.hpp>
+#include <libtorrent/posix_disk_io.hpp>
 #include <libtorrent/session.hpp>
+#include <libtorrent/session_params.hpp>
+#include <libtorrent/socket.hpp>
 #include <libtorrent/torrent_handle.hpp>
 #include <libtorrent/torrent_info.hpp>
 #include <libtorrent/torrent_status.hpp>
@@ -20,6 +25,7 @@
 #include <msclr/marshal_cppstd.h>
 #include "TorrentOperationEvent.h"
 #include "TorrentState.h"
+#include "QueueMove.h"
 #include "Optional.h"
 #include "Utilities.h"
 #include "TorrentId.h"
@@ -29,11 +35,24 @@
 #include "TorrentSessionConfig.h"
 #include "AddTorrentRequest.h"
 #include "TorrentEvents.h"
+#include "TorrentStreamOptions.h"
+#include "MemoryDiskIo.h"
+#include "PieceReader.h"
+#include "PieceWindowManager.h"
 #include "TorrentStream.h"
+#include "StreamingBandwidthScheduler.h"
+#include "BandwidthGroupManager.h"
+#include "SessionStatsCollector.h"
+#include "LatencyTracker.h"
+#include "AlertTrace.h"
+#include "SeedModeVerifier.h"
+#include "RecheckScheduler.h"
+#include "MemoryBudgetManager.h"
 
 using namespace System;
 using namespace msclr::interop;
 using namespace System::Collections::Generic;
+using namespace System::Net;
 using namespace System::Text::RegularExpressions;
 using namespace System::Timers;
 
@@ -64,6 +83,29 @@ namespace LibtorrentDotNet
 		/// </summary>
 		event EventHandler<TorrentMetadataEventArgs^>^ TorrentMetadataReceived;
 
+		/// <summary>
+		/// Event that is raised with the metrics of all open streams, at the same interval as state updates.
+		/// </summary>
+		event EventHandler<TorrentStreamMetricsEventArgs^>^ StreamMetricsUpdated;
+
+		/// <summary>
+		/// Event that is raised with each new sample of the session's performance counters, if sampling is enabled
+		/// in <see cref="TorrentSessionConfig::StatsSettings"/>.
+		/// </summary>
+		event EventHandler<SessionStatisticsEventArgs^>^ SessionStatisticsUpdated;
+
+		/// <summary>
+		/// Event that is raised when the sampled pieces of a torrent added in seed mode have been hashed, as set by
+		/// <see cref="AddTorrentOptions::SeedVerification"/>. It is raised from a thread pool thread.
+		/// </summary>
+		event EventHandler<SeedVerificationEventArgs^>^ SeedVerificationCompleted;
+
+		/// <summary>
+		/// Event that is raised on each tick while torrents are being rechecked by RecheckTorrents, with the progress
+		/// of every torrent in the recheck.
+		/// </summary>
+		event EventHandler<RecheckProgressEventArgs^>^ RecheckProgressUpdated;
+
 		/// <summary>
 		/// Adds a torrent to the session using a magnet link.
 		/// </summary>
@@ -86,7 +128,7 @@ namespace LibtorrentDotNet
 		virtual bool AddTorrent(AddTorrentFromByteArrayRequest^ request) = 0;
 
 		/// <summary>
-		/// Pauses a specific torrent.
+		/// Pauses a specific torrent. A queued torrent is taken out of the queue so that it stays paused.
 		/// </summary>
 		/// <param name="torrentId">The ID of the torrent to pause.</param>
 		/// <returns>True if the torrent was paused, false if it wasn't found or couldn't be paused.</returns>
@@ -100,7 +142,7 @@ namespace LibtorrentDotNet
 		virtual bool PauseTorrents(IReadOnlyList<TorrentId^>^ torrentIds) = 0;
 
 		/// <summary>
-		/// Resumes a specific torrent.
+		/// Resumes a specific torrent. A torrent that was queued when it was paused goes back into the queue.
 		/// </summary>
 		/// <param name="torrentId">The ID of the torrent to resume.</param>
 		/// <returns>True if the torrent was resumed, false if it wasn't found or couldn't be resumed.</returns>
@@ -162,6 +204,82 @@ namespace LibtorrentDotNet
 		/// </remarks>
 		virtual TorrentStream^ StreamFile(TorrentId^ torrentId, int fileIndex, TimeSpan timeout) = 0;
 
+		/// <summary>
+		/// Streams a specific file from a torrent identified by its ID, using the specified stream options.
+		/// </summary>
+		/// <param name="torrentId">The unique identifier of the torrent containing the file to stream.</param>
+		/// <param name="fileIndex">The index of the file within the torrent to stream.</param>
+		/// <param name="timeout">
+		/// The timeframe which a read operation of the stream must complete within before the stream's read method 
+		/// returns 0 and a read timeout event is raised.
+		/// </param>
+		/// <param name="options">The options controlling how the stream reads and buffers data.</param>
+		/// <returns>
+		/// <see cref="TorrentStream"/> object that allows reading the specified file as a stream.
+		/// </returns>
+		/// <exception cref="ArgumentException">
+		/// Thrown if the specified torrent ID is invalid or the file name is not found in the torrent metadata.
+		/// </exception>
+		/// <exception cref="InvalidOperationException">
+		/// Thrown if the torrent's metadata is not yet available or the torrent is in an invalid state.
+		/// </exception>
+		/// <exception cref="FileNotFoundException">
+		/// Thrown if the <param name="fileIndex"/> does not match any file in the torrent.
+		/// </exception>
+		virtual TorrentStream^ StreamFile(TorrentId^ torrentId, int fileIndex, TimeSpan timeout,
+			TorrentStreamOptions^ options) = 0;
+
+		/// <summary>
+		/// Streams several files of a torrent back to back as one continuous stream, e.g. the parts of a split archive
+		/// or of a multi-part video.
+		/// </summary>
+		/// <param name="torrentId">The unique identifier of the torrent containing the files to stream.</param>
+		/// <param name="fileIndices">The indices of the files to stream, in the order they appear in the stream.</param>
+		/// <param name="timeout">
+		/// The timeframe which a read operation of the stream must complete within before the stream's read method 
+		/// returns 0 and a read timeout event is raised.
+		/// </param>
+		/// <param name="options">
+		/// The options controlling how the stream reads and buffers data. The read backend must be
+		/// <see cref="TorrentStreamReadBackend::Libtorrent"/> when more than one file is streamed.
+		/// </param>
+		/// <returns>
+		/// <see cref="TorrentStream"/> object that allows reading the specified files as one stream.
+		/// </returns>
+		/// <exception cref="ArgumentException">
+		/// Thrown if the specified torrent ID is invalid, no file indices are given, several files are given with
+		/// <see cref="TorrentStreamOptions::ProbeMediaIndex"/> set, or the read-ahead options are not positive.
+		/// </exception>
+		/// <exception cref="InvalidOperationException">
+		/// Thrown if the torrent's metadata is not yet available or the torrent is in an invalid state.
+		/// </exception>
+		/// <exception cref="FileNotFoundException">
+		/// Thrown if one of the <param name="fileIndices"/> does not match any file in the torrent.
+		/// </exception>
+		virtual TorrentStream^ StreamFiles(TorrentId^ torrentId, IReadOnlyList<int>^ fileIndices, TimeSpan timeout,
+			TorrentStreamOptions^ options) = 0;
+
+		/// <summary>
+		/// Streams the whole payload of a torrent, all files in torrent order without padding, as one continuous stream.
+		/// </summary>
+		/// <param name="torrentId">The unique identifier of the torrent to stream.</param>
+		/// <param name="timeout">
+		/// The timeframe which a read operation of the stream must complete within before the stream's read method 
+		/// returns 0 and a read timeout event is raised.
+		/// </param>
+		/// <param name="options">
+		/// The options controlling how the stream reads and buffers data. The read backend must be
+		/// <see cref="TorrentStreamReadBackend::Libtorrent"/> when the torrent has more than one file.
+		/// </param>
+		/// <returns>
+		/// <see cref="TorrentStream"/> object that allows reading the torrent's payload as one stream.
+		/// </returns>
+		/// <exception cref="ArgumentException">Thrown if the specified torrent ID is invalid.</exception>
+		/// <exception cref="InvalidOperationException">
+		/// Thrown if the torrent's metadata is not yet available or the torrent is in an invalid state.
+		/// </exception>
+		virtual TorrentStream^ StreamTorrent(TorrentId^ torrentId, TimeSpan timeout, TorrentStreamOptions^ options) = 0;
+
 		/// <summary>
 		/// Sets the download rate limit for a specific torrent.
 		/// </summary>
@@ -178,6 +296,99 @@ namespace LibtorrentDotNet
 		/// <returns>True if the rate limit was set successfully, false if the torrent wasn't found.</returns>
 		virtual bool SetTorrentUploadRateLimit(TorrentId^ torrentId, int uploadRateLimit) = 0;
 
+		/// <summary>
+		/// Applies a configuration to the running session. Only the settings whose values differ from the session's
+		/// current settings are applied, so connected peers are kept and frequent calls are cheap.
+		/// </summary>
+		/// <param name="config">The configuration to apply. Settings without a value are left unchanged.</param>
+		/// <returns>The number of settings that were changed.</returns>
+		/// <exception cref="ArgumentException">Thrown if the advanced settings of the configuration are invalid.</exception>
+		/// <remarks>The streaming settings are only read when the session is created.</remarks>
+		virtual int UpdateSettings(TorrentSessionConfig^ config) = 0;
+
+		/// <summary>
+		/// Creates a bandwidth group, or updates the limits and weight of the group with the same name.
+		/// </summary>
+		/// <param name="group">The group to create or update.</param>
+		/// <exception cref="ArgumentOutOfRangeException">Thrown if the weight of the group is less than 1.</exception>
+		/// <remarks>
+		/// The torrents of a group share its rate limits, and while the session-wide rate limit is reached, groups
+		/// share it by weight. Grouped torrents have their own rate limits managed by the group; limits set with
+		/// <see cref="SetTorrentDownloadRateLimit"/> or <see cref="SetTorrentUploadRateLimit"/> take effect once the
+		/// torrent leaves its group.
+		/// </remarks>
+		virtual void SetBandwidthGroup(BandwidthGroup^ group) = 0;
+
+		/// <summary>
+		/// Removes a bandwidth group. Its torrents get back the rate limits they had before joining it.
+		/// </summary>
+		/// <param name="groupName">The name of the group to remove.</param>
+		/// <returns>True if the group was removed, false if it didn't exist.</returns>
+		virtual bool RemoveBandwidthGroup(String^ groupName) = 0;
+
+		/// <summary>
+		/// Moves torrents into a bandwidth group, or out of their group if no group name is given.
+		/// </summary>
+		/// <param name="torrentIds">The IDs of the torrents to move.</param>
+		/// <param name="groupName">The name of the group to move the torrents to, or null to take them out of their group.</param>
+		/// <returns>The number of torrents that were found and moved.</returns>
+		/// <exception cref="ArgumentException">Thrown if no group with the given name exists.</exception>
+		virtual int AssignBandwidthGroup(IReadOnlyList<TorrentId^>^ torrentIds, String^ groupName) = 0;
+
+		/// <summary>
+		/// Moves torrents in the download queue, which decides which auto managed torrents are active.
+		/// </summary>
+		/// <param name="torrentIds">The IDs of the torrents to move. Their order relative to each other is kept.</param>
+		/// <param name="move">Where to move the torrents.</param>
+		/// <returns>True if all torrents were found, false otherwise.</returns>
+		/// <remarks>Torrents that are not queued, such as seeding torrents, are left where they are.</remarks>
+		virtual bool MoveInQueue(IReadOnlyList<TorrentId^>^ torrentIds, QueueMove move) = 0;
+
+		/// <summary>
+		/// Moves a torrent to a specific position in the download queue.
+		/// </summary>
+		/// <param name="torrentId">The ID of the torrent to move.</param>
+		/// <param name="position">The new position, where 0 is the front of the queue.</param>
+		/// <returns>True if the torrent was moved, false if it wasn't found.</returns>
+		virtual bool SetQueuePosition(TorrentId^ torrentId, int position) = 0;
+
+		/// <summary>
+		/// Connects a torrent directly to a peer, without going through trackers, DHT or local service discovery.
+		/// This is how sessions on the same machine, such as a seeder and leechers listening on 127.0.0.1, are
+		/// made to find each other.
+		/// </summary>
+		/// <param name="torrentId">The ID of the torrent to connect.</param>
+		/// <param name="endPoint">The address and port the peer listens on.</param>
+		/// <returns>True if the connection attempt was started, false if the torrent wasn't found.</returns>
+		virtual bool ConnectPeer(TorrentId^ torrentId, IPEndPoint^ endPoint) = 0;
+
+		/// <summary>
+		/// Gets the port the session accepts incoming connections on.
+		/// </summary>
+		/// <returns>The listen port, or 0 if the session isn't listening.</returns>
+		virtual int GetListenPort() = 0;
+
+		/// <summary>
+		/// Checks the files of torrents against their piece hashes again, e.g. after their disk was replaced. The
+		/// torrents wait for the session's checking slots, as auto managed torrents that get back their own flags
+		/// once checked. Progress is reported with RecheckProgressUpdated.
+		/// </summary>
+		/// <param name="torrentIds">The IDs of the torrents to recheck.</param>
+		/// <returns>The number of torrents whose recheck was started. Torrents without metadata are skipped.</returns>
+		virtual int RecheckTorrents(IReadOnlyList<TorrentId^>^ torrentIds) = 0;
+
+		/// <summary>
+		/// Checks the files of torrents against their piece hashes again, e.g. after their disk was replaced. The
+		/// torrents wait for the checking slots set by the options, as auto managed torrents that get back their own
+		/// flags once checked. Progress is reported with RecheckProgressUpdated.
+		/// </summary>
+		/// <param name="torrentIds">The IDs of the torrents to recheck.</param>
+		/// <param name="options">How many torrents are checked at once, with how many hashing threads, and how fast
+		/// they may read from disk.</param>
+		/// <exception cref="ArgumentOutOfRangeException">Thrown if an option is out of range.</exception>
+		/// <returns>The number of torrents whose recheck was started. Torrents without metadata are skipped.</returns>
+		virtual int RecheckTorrents(IReadOnlyList<TorrentId^>^ torrentIds, RecheckOptions^ options) = 0;
+
 		/// <summary>
 		/// Changes the interval at which events are raised. The default interval is once every second.
 		/// Adjusting this interval can increase or decrease the frequency of event invocations, which may impact performance.
@@ -211,6 +422,54 @@ namespace LibtorrentDotNet
 		/// <param name="torrentId">The ID of the torrent to get the torrent info of.</param>
 		/// <returns>The torrent info of the specified torrent.</returns>
 		virtual TorrentInfo^ GetTorrentInfo(TorrentId^ torrentId) = 0;
+
+		/// <summary>
+		/// Gets the most recent sample of the session's performance counters. The counters are also published as
+		/// System.Diagnostics.Metrics instruments on the "LibtorrentDotNet.Session" meter.
+		/// </summary>
+		/// <returns>The latest sample, or null if sampling is disabled or no sample was taken yet.</returns>
+		virtual SessionStatistics^ GetSessionStatistics() = 0;
+
+		/// <summary>
+		/// Gets how much time the session has spent in its public methods, in the steps inside them and in alert
+		/// handlers. The durations are also published as System.Diagnostics.Metrics histograms on the
+		/// "LibtorrentDotNet.Latency" meter.
+		/// </summary>
+		/// <returns>The latency histograms, which are empty unless latency tracking is enabled.</returns>
+		virtual LatencyReport^ GetLatencyReport() = 0;
+
+		/// <summary>
+		/// Gets how much memory the session has allocated to its disk queue, send buffers, alert queue, stream
+		/// buffers and managed heap, and the budget they are held to.
+		/// </summary>
+		/// <returns>The allocations of the session.</returns>
+		virtual MemoryReport^ GetMemoryReport() = 0;
+
+		/// <summary>
+		/// Starts writing every alert the session pops to a compact binary trace, with its type, its time and the
+		/// payload the session raised an event with. The trace can be replayed with ReplayAlertTrace to profile the
+		/// alert handling and the event subscribers offline.
+		/// </summary>
+		/// <param name="output">The stream to write the trace to. It is not closed by the session.</param>
+		/// <exception cref="InvalidOperationException">Thrown if a trace is already being recorded.</exception>
+		virtual void StartAlertTrace(Stream^ output) = 0;
+
+		/// <summary>
+		/// Stops recording the alert trace started with StartAlertTrace and flushes it to its stream.
+		/// </summary>
+		/// <returns>True if a trace was being recorded, false otherwise.</returns>
+		virtual bool StopAlertTrace() = 0;
+
+		/// <summary>
+		/// Raises the events of a recorded alert trace again, through the same events as live alerts. Alerts the
+		/// session handles internally, such as read_piece_alert, are read but not dispatched. Replaying into a session
+		/// without torrents keeps the replayed events apart from live ones.
+		/// </summary>
+		/// <param name="input">The stream to read the trace from. It is not closed by the session.</param>
+		/// <param name="speed">Whether to keep the recorded spacing between alerts or replay them back to back.</param>
+		/// <returns>The number of alerts replayed and how long it took.</returns>
+		/// <exception cref="InvalidDataException">Thrown if the stream is not a valid alert trace.</exception>
+		virtual AlertReplayResult^ ReplayAlertTrace(Stream^ input, AlertReplaySpeed speed) = 0;
 	};
 
 	/// <summary>
@@ -223,6 +482,20 @@ namespace LibtorrentDotNet
 		ElapsedEventHandler^ elapsedEventHandler;
 		Timers::Timer^ alertTimer;
 		bool isListeningToAlerts;
+		Object^ alertPumpSync;
+		bool isPumpingAlerts;
+		int isAlertPumpQueued;
+		PieceReaderRegistry^ pieceReaders;
+		PieceWindowRegistry^ pieceWindows;
+		List<TorrentStream^>^ openStreams;
+		HashSet<TorrentId^>^ pausedAutoManagedTorrents;
+		StreamingBandwidthScheduler^ streamingScheduler;
+		BandwidthGroupManager^ bandwidthGroups;
+		RecheckScheduler^ recheckScheduler;
+		MemoryBudgetManager^ memoryBudget;
+		SessionStatsCollector^ statsCollector;
+		LatencyTracker^ latency;
+		AlertTraceWriter^ alertTrace;
 		ILogger^ logger;
 
 		ref class NullLogger sealed : ILogger
@@ -259,6 +532,29 @@ namespace LibtorrentDotNet
 		/// </summary>
 		virtual event EventHandler<TorrentMetadataEventArgs^>^ TorrentMetadataReceived;
 
+		/// <summary>
+		/// Event that is raised with the metrics of all open streams, at the same interval as state updates.
+		/// </summary>
+		virtual event EventHandler<TorrentStreamMetricsEventArgs^>^ StreamMetricsUpdated;
+
+		/// <summary>
+		/// Event that is raised with each new sample of the session's performance counters, if sampling is enabled
+		/// in <see cref="TorrentSessionConfig::StatsSettings"/>.
+		/// </summary>
+		virtual event EventHandler<SessionStatisticsEventArgs^>^ SessionStatisticsUpdated;
+
+		/// <summary>
+		/// Event that is raised when the sampled pieces of a torrent added in seed mode have been hashed, as set by
+		/// <see cref="AddTorrentOptions::SeedVerification"/>. It is raised from a thread pool thread.
+		/// </summary>
+		virtual event EventHandler<SeedVerificationEventArgs^>^ SeedVerificationCompleted;
+
+		/// <summary>
+		/// Event that is raised on each tick while torrents are being rechecked by RecheckTorrents, with the progress
+		/// of every torrent in the recheck.
+		/// </summary>
+		virtual event EventHandler<RecheckProgressEventArgs^>^ RecheckProgressUpdated;
+
 		/// <summary>
 		/// Creates a new TorrentSession with default configuration.
 		/// </summary>
@@ -332,6 +628,36 @@ namespace LibtorrentDotNet
 					alertTimer = nullptr;
 				}
 
+				if (streamingScheduler != nullptr)
+				{
+					delete streamingScheduler;
+					streamingScheduler = nullptr;
+				}
+
+				if (bandwidthGroups != nullptr)
+				{
+					delete bandwidthGroups;
+					bandwidthGroups = nullptr;
+				}
+
+				if (recheckScheduler != nullptr)
+				{
+					delete recheckScheduler;
+					recheckScheduler = nullptr;
+				}
+
+				if (statsCollector != nullptr)
+				{
+					delete statsCollector;
+					statsCollector = nullptr;
+				}
+
+				if (latency != nullptr)
+				{
+					delete latency;
+					latency = nullptr;
+				}
+
 				if (nativeSession != nullptr)
 				{
 					delete nativeSession;
@@ -365,9 +691,11 @@ namespace LibtorrentDotNet
 			ArgumentNullException::ThrowIfNull(request, "request");
 			logger->Log(ILogger::LogLevel::Info, "Adding torrent from magnet link");
 
-			lock->EnterReadLock();
+			const auto started = latency->Start();
+			EnterReadLock();
 
 			libtorrent::add_torrent_params params;
+			bool parsed = false;
 			try
 			{
 				libtorrent::error_code ec;
@@ -382,20 +710,28 @@ namespace LibtorrentDotNet
 						String::Format("Failed to parse magnet link: {0}", gcnew String(ec.message().c_str())));
 				}
 				params.save_path = savePath;
+				ApplyAddTorrentOptions(request->Options, params);
 
-				if (const libtorrent::sha1_hash infoHash = params.info_hashes.get_best(); nativeSession->
-					find_torrent(infoHash).is_valid())
+				if (const libtorrent::sha1_hash infoHash = params.info_hashes.get_best();
+					FindTorrent(infoHash).is_valid())
 				{
 					logger->Log(ILogger::LogLevel::Info, "Torrent already exists, skipping addition");
 					return false;
 				}
+				parsed = true;
 			}
 			finally
 			{
 				lock->ExitReadLock();
+
+				// A magnet link that fails to parse or names a known torrent ends the call here
+				if (!parsed)
+				{
+					latency->RecordOperation("AddTorrent", started);
+				}
 			}
 
-			lock->EnterWriteLock();
+			EnterWriteLock();
 
 			try
 			{
@@ -411,6 +747,7 @@ namespace LibtorrentDotNet
 			finally
 			{
 				lock->ExitWriteLock();
+				latency->RecordOperation("AddTorrent", started);
 			}
 		}
 
@@ -423,7 +760,8 @@ namespace LibtorrentDotNet
 		{
 			ArgumentNullException::ThrowIfNull(request, "request");
 			logger->Log(ILogger::LogLevel::Info, "Adding torrent from torrent file");
-			lock->EnterWriteLock();
+			const auto started = latency->Start();
+			EnterWriteLock();
 			try
 			{
 				marshal_context context;
@@ -431,7 +769,7 @@ namespace LibtorrentDotNet
 				const auto& savePath = context.marshal_as<std::string>(request->SavePath);
 				libtorrent::torrent_info torrentInfo(torrentFilePath);
 
-				if (nativeSession->find_torrent(torrentInfo.info_hashes().get_best()).is_valid())
+				if (FindTorrent(torrentInfo.info_hashes().get_best()).is_valid())
 				{
 					logger->Log(ILogger::LogLevel::Info, "Torrent already exists, skipping addition");
 					return false;
@@ -440,7 +778,9 @@ namespace LibtorrentDotNet
 				libtorrent::add_torrent_params addTorrentParams;
 				addTorrentParams.ti = std::make_shared<libtorrent::torrent_info>(torrentInfo);
 				addTorrentParams.save_path = savePath;
+				ApplyAddTorrentOptions(request->Options, addTorrentParams);
 				nativeSession->async_add_torrent(addTorrentParams);
+				StartSeedVerification(request->Options, torrentInfo, savePath);
 				return true;
 			}
 			catch (const std::exception& e)
@@ -452,6 +792,7 @@ namespace LibtorrentDotNet
 			finally
 			{
 				lock->ExitWriteLock();
+				latency->RecordOperation("AddTorrent", started);
 			}
 		}
 
@@ -464,7 +805,8 @@ namespace LibtorrentDotNet
 		{
 			ArgumentNullException::ThrowIfNull(request, "request");
 			logger->Log(ILogger::LogLevel::Info, "Adding torrent from byte array");
-			lock->EnterWriteLock();
+			const auto started = latency->Start();
+			EnterWriteLock();
 			const int length = request->TorrentData->Length;
 			const auto nativeArray = std::make_unique<char[]>(length);
 			try
@@ -475,10 +817,11 @@ namespace LibtorrentDotNet
 				{
 					const pin_ptr<Byte> pinnedArray = &request->TorrentData[0];
 					std::memcpy(nativeArray.get(), pinnedArray, length);
-					libtorrent::torrent_info torrentInfo(nativeArray.get());
+					libtorrent::torrent_info torrentInfo(libtorrent::span<const char>(nativeArray.get(), length),
+						libtorrent::from_span);
 
 					// Check if the torrent already exists
-					if (nativeSession->find_torrent(torrentInfo.info_hashes().get_best()).is_valid())
+					if (FindTorrent(torrentInfo.info_hashes().get_best()).is_valid())
 					{
 						logger->Log(ILogger::LogLevel::Info, "Torrent already exists, skipping addition");
 						return false;
@@ -487,7 +830,9 @@ namespace LibtorrentDotNet
 					libtorrent::add_torrent_params addTorrentParams;
 					addTorrentParams.ti = std::make_shared<libtorrent::torrent_info>(torrentInfo);
 					addTorrentParams.save_path = savePath;
+					ApplyAddTorrentOptions(request->Options, addTorrentParams);
 					nativeSession->async_add_torrent(addTorrentParams);
+					StartSeedVerification(request->Options, torrentInfo, savePath);
 					return true;
 				}
 				return false;
@@ -501,6 +846,7 @@ namespace LibtorrentDotNet
 			finally
 			{
 				lock->ExitWriteLock();
+				latency->RecordOperation("AddTorrent", started);
 			}
 		}
 
@@ -617,29 +963,117 @@ namespace LibtorrentDotNet
 		/// </remarks>
 		virtual TorrentStream^ StreamFile(TorrentId^ torrentId, int fileIndex, TimeSpan timeout)
 		{
-			const auto& infoHash = ParseInfoHash(torrentId);
-			const auto& handle = nativeSession->find_torrent(infoHash.get_best());
+			return StreamFile(torrentId, fileIndex, timeout, gcnew TorrentStreamOptions());
+		}
 
-			if (!handle.is_valid())
+		/// <summary>
+		/// Streams a specific file from a torrent identified by its ID, using the specified stream options.
+		/// </summary>
+		/// <param name="torrentId">The unique identifier of the torrent containing the file to stream.</param>
+		/// <param name="fileIndex">The index of the file within the torrent to stream.</param>
+		/// <param name="timeout">
+		/// The timeframe which a read operation of the stream must complete within before the stream's read method 
+		/// returns 0 and a read timeout event is raised.
+		/// </param>
+		/// <param name="options">The options controlling how the stream reads and buffers data.</param>
+		/// <returns>
+		/// <see cref="TorrentStream"/> object that allows reading the specified file as a stream.
+		/// </returns>
+		/// <exception cref="ArgumentException">
+		/// Thrown if the specified torrent ID is invalid or the file name is not found in the torrent metadata.
+		/// </exception>
+		/// <exception cref="InvalidOperationException">
+		/// Thrown if the torrent's metadata is not yet available or the torrent is in an invalid state.
+		/// </exception>
+		/// <exception cref="FileNotFoundException">
+		/// Thrown if the <param name="fileIndex"/> does not match any file in the torrent.
+		/// </exception>
+		virtual TorrentStream^ StreamFile(TorrentId^ torrentId, int fileIndex, TimeSpan timeout,
+			TorrentStreamOptions^ options)
+		{
+			return StreamFiles(torrentId, Array::AsReadOnly(gcnew array<int>{ fileIndex }), timeout, options);
+		}
+
+		/// <summary>
+		/// Streams several files of a torrent back to back as one continuous stream.
+		/// </summary>
+		/// <param name="torrentId">The unique identifier of the torrent containing the files to stream.</param>
+		/// <param name="fileIndices">The indices of the files to stream, in the order they appear in the stream.</param>
+		/// <param name="timeout">
+		/// The timeframe which a read operation of the stream must complete within before the stream's read method 
+		/// returns 0 and a read timeout event is raised.
+		/// </param>
+		/// <param name="options">The options controlling how the stream reads and buffers data.</param>
+		/// <returns>
+		/// <see cref="TorrentStream"/> object that allows reading the specified files as one stream.
+		/// </returns>
+		virtual TorrentStream^ StreamFiles(TorrentId^ torrentId, IReadOnlyList<int>^ fileIndices, TimeSpan timeout,
+			TorrentStreamOptions^ options)
+		{
+			ArgumentNullException::ThrowIfNull(fileIndices, "fileIndices");
+			ArgumentNullException::ThrowIfNull(options, "options");
+
+			if (fileIndices->Count == 0)
 			{
-				throw gcnew ArgumentException("Invalid TorrentId");
+				throw gcnew ArgumentException("At least one file index is required", "fileIndices");
 			}
 
+			const auto started = latency->Start();
+			const auto& handle = FindStreamableTorrent(torrentId);
 			const auto& torrentInfo = handle.torrent_file();
-			if (!torrentInfo)
+			const auto& files = torrentInfo->files();
+
+			std::vector<libtorrent::file_index_t> nativeFileIndices;
+			nativeFileIndices.reserve(fileIndices->Count);
+			for each (int fileIndex in fileIndices)
 			{
-				throw gcnew InvalidOperationException("Torrent metadata not available yet");
+				if (!(fileIndex >= 0 && fileIndex < files.num_files()))
+				{
+					throw gcnew FileNotFoundException("Found no file with index " + fileIndex);
+				}
+				nativeFileIndices.emplace_back(fileIndex);
 			}
 
+			auto stream = OpenStream(handle, nativeFileIndices, timeout, options);
+			latency->RecordOperation("StreamFiles", started);
+			return stream;
+		}
+
+		/// <summary>
+		/// Streams the whole payload of a torrent, all files in torrent order without padding, as one continuous stream.
+		/// </summary>
+		/// <param name="torrentId">The unique identifier of the torrent to stream.</param>
+		/// <param name="timeout">
+		/// The timeframe which a read operation of the stream must complete within before the stream's read method 
+		/// returns 0 and a read timeout event is raised.
+		/// </param>
+		/// <param name="options">The options controlling how the stream reads and buffers data.</param>
+		/// <returns>
+		/// <see cref="TorrentStream"/> object that allows reading the torrent's payload as one stream.
+		/// </returns>
+		virtual TorrentStream^ StreamTorrent(TorrentId^ torrentId, TimeSpan timeout, TorrentStreamOptions^ options)
+		{
+			ArgumentNullException::ThrowIfNull(options, "options");
+
+			const auto started = latency->Start();
+			const auto& handle = FindStreamableTorrent(torrentId);
+			const auto& torrentInfo = handle.torrent_file();
 			const auto& files = torrentInfo->files();
-			const auto nativeFileIndex = libtorrent::file_index_t{ fileIndex };
 
-			if (!(fileIndex >= 0 && fileIndex < files.num_files()))
+			std::vector<libtorrent::file_index_t> nativeFileIndices;
+			nativeFileIndices.reserve(files.num_files());
+			for (const auto fileIndex : files.file_range())
 			{
-				throw gcnew FileNotFoundException("Found no file with index " + fileIndex);
+				// Pad files only align the real files to piece boundaries
+				if (!files.pad_file_at(fileIndex))
+				{
+					nativeFileIndices.push_back(fileIndex);
+				}
 			}
 
-			return TorrentStream::Create(new libtorrent::torrent_handle(handle), nativeFileIndex, timeout);
+			auto stream = OpenStream(handle, nativeFileIndices, timeout, options);
+			latency->RecordOperation("StreamTorrent", started);
+			return stream;
 		}
 
 		/// <summary>
@@ -652,14 +1086,20 @@ namespace LibtorrentDotNet
 		{
 			ArgumentNullException::ThrowIfNull(torrentId, "torrentId");
 
-			lock->EnterReadLock();
+			const auto started = latency->Start();
+			EnterReadLock();
 			try
 			{
 				const auto& hash = ParseInfoHash(torrentId);
 
-				if (const auto& handle = nativeSession->find_torrent(hash.get_best()); handle.is_valid())
+				if (const auto& handle = FindTorrent(hash.get_best()); handle.is_valid())
 				{
-					handle.set_download_limit(downloadRateLimit);
+					// A grouped or throttled torrent gets the new limit once it leaves its group or is restored
+					if (!bandwidthGroups->DeferDownloadLimit(handle.info_hashes(), downloadRateLimit) &&
+						!streamingScheduler->DeferDownloadLimit(handle.info_hashes(), downloadRateLimit))
+					{
+						handle.set_download_limit(downloadRateLimit);
+					}
 					return true;
 				}
 				return false;
@@ -667,6 +1107,7 @@ namespace LibtorrentDotNet
 			finally
 			{
 				lock->ExitReadLock();
+				latency->RecordOperation("SetTorrentDownloadRateLimit", started);
 			}
 		}
 
@@ -680,14 +1121,19 @@ namespace LibtorrentDotNet
 		{
 			ArgumentNullException::ThrowIfNull(torrentId, "torrentId");
 
-			lock->EnterReadLock();
+			const auto started = latency->Start();
+			EnterReadLock();
 			try
 			{
 				const auto& hash = ParseInfoHash(torrentId);
 
-				if (const auto& handle = nativeSession->find_torrent(hash.get_best()); handle.is_valid())
+				if (const auto& handle = FindTorrent(hash.get_best()); handle.is_valid())
 				{
-					handle.set_upload_limit(uploadRateLimit);
+					// A grouped torrent gets the new limit once it leaves its group
+					if (!bandwidthGroups->DeferUploadLimit(handle.info_hashes(), uploadRateLimit))
+					{
+						handle.set_upload_limit(uploadRateLimit);
+					}
 					return true;
 				}
 				return false;
@@ -695,139 +1141,1022 @@ namespace LibtorrentDotNet
 			finally
 			{
 				lock->ExitReadLock();
+				latency->RecordOperation("SetTorrentUploadRateLimit", started);
 			}
 		}
 
 		/// <summary>
-		/// Changes the interval at which events are raised. The default interval is once every second.
-		/// Adjusting this interval can increase or decrease the frequency of event invocations, which may impact performance.
+		/// Applies a configuration to the running session. Only the settings whose values differ from the session's
+		/// current settings are applied, so connected peers are kept and frequent calls are cheap.
 		/// </summary>
-		/// <param name="interval">The new interval to use, specified as a <see cref="TimeSpan"/>. The interval represents the duration between consecutive events.</param>
-		/// <remarks>Use caution when setting very short intervals, as it may result in a high frequency of events.</remarks>
-		virtual void ChangeEventTimerInterval(TimeSpan interval)
+		/// <param name="config">The configuration to apply. Settings without a value are left unchanged.</param>
+		/// <returns>The number of settings that were changed.</returns>
+		/// <exception cref="ArgumentException">Thrown if the advanced settings of the configuration are invalid.</exception>
+		/// <remarks>The streaming settings are only read when the session is created.</remarks>
+		virtual int UpdateSettings(TorrentSessionConfig^ config)
 		{
-			if (interval == TimeSpan::Zero)
+			ArgumentNullException::ThrowIfNull(config, "config");
+
+			const auto& requested = CreateSettingsPack(config);
+
+			const auto started = latency->Start();
+			EnterReadLock();
+			try
 			{
-				throw gcnew ArgumentException("Time span must be greater than zero.", "interval");
+				libtorrent::settings_pack changed;
+				const int changedCount = DiffSettings(nativeSession->get_settings(), requested, changed);
+				if (changedCount > 0)
+				{
+					nativeSession->apply_settings(changed);
+				}
+				return changedCount;
+			}
+			catch (const std::exception& e)
+			{
+				auto message = String::Format("Error when updating settings: {0}", gcnew String(e.what()));
+				logger->Log(ILogger::LogLevel::Error, message);
+				throw gcnew TorrentException(message);
+			}
+			finally
+			{
+				lock->ExitReadLock();
+				latency->RecordOperation("UpdateSettings", started);
 			}
-
-			alertTimer->Interval = interval.TotalMilliseconds;
 		}
 
 		/// <summary>
-		/// Gets the status of a specific torrent in the session.
+		/// Creates a bandwidth group, or updates the limits and weight of the group with the same name.
 		/// </summary>
-		/// <param name="torrentId">The ID of the torrent to get the status of.</param>
-		/// <returns>The status of the specified torrent.</returns>
-		virtual TorrentStatus^ GetTorrentStatus(TorrentId^ torrentId)
+		/// <param name="group">The group to create or update.</param>
+		/// <exception cref="ArgumentOutOfRangeException">Thrown if the weight of the group is less than 1.</exception>
+		virtual void SetBandwidthGroup(BandwidthGroup^ group)
 		{
-			ArgumentNullException::ThrowIfNull(torrentId, "torrentId");
+			ArgumentNullException::ThrowIfNull(group, "group");
 
-			lock->EnterReadLock();
+			const auto started = latency->Start();
 			try
 			{
-				const auto& hash = ParseInfoHash(torrentId);
-
-				if (const auto& handle = nativeSession->find_torrent(hash.get_best()); handle.is_valid())
-				{
-					return CreateTorrentStatus(handle.status(), torrentId);
-				}
-
-				throw gcnew InvalidOperationException("Torrent with the specified info hash was not found.");
+				bandwidthGroups->SetGroup(group);
 			}
 			finally
 			{
-				lock->ExitReadLock();
+				latency->RecordOperation("SetBandwidthGroup", started);
 			}
 		}
 
-
 		/// <summary>
-		/// Gets the status of all torrents in the session.
+		/// Removes a bandwidth group. Its torrents get back the rate limits they had before joining it.
 		/// </summary>
-		/// <returns>A list of the status of all torrents in the session.</returns>
-		virtual IReadOnlyList<TorrentStatus^>^ GetTorrentStatuses()
+		/// <param name="groupName">The name of the group to remove.</param>
+		/// <returns>True if the group was removed, false if it didn't exist.</returns>
+		virtual bool RemoveBandwidthGroup(String^ groupName)
 		{
-			std::vector<libtorrent::torrent_handle> handles;
+			ArgumentNullException::ThrowIfNull(groupName, "groupName");
 
-			lock->EnterReadLock();
+			const auto started = latency->Start();
+			EnterReadLock();
 			try
 			{
-				handles = nativeSession->get_torrents();
+				return bandwidthGroups->RemoveGroup(nativeSession, groupName);
 			}
 			finally
 			{
 				lock->ExitReadLock();
+				latency->RecordOperation("RemoveBandwidthGroup", started);
 			}
+		}
 
-			auto statuses = gcnew List<TorrentStatus^>(static_cast<long>(handles.size()));
-
-			for (const auto& handle : handles)
+		/// <summary>
+		/// Moves torrents into a bandwidth group, or out of their group if no group name is given.
+		/// </summary>
+		/// <param name="torrentIds">The IDs of the torrents to move.</param>
+		/// <param name="groupName">The name of the group to move the torrents to, or null to take them out of their group.</param>
+		/// <returns>The number of torrents that were found and moved.</returns>
+		/// <exception cref="ArgumentException">Thrown if no group with the given name exists.</exception>
+		virtual int AssignBandwidthGroup(IReadOnlyList<TorrentId^>^ torrentIds, String^ groupName)
+		{
+			ArgumentNullException::ThrowIfNull(torrentIds, "torrentIds");
+
+			const auto started = latency->Start();
+			EnterReadLock();
+			try
+			{
+				return bandwidthGroups->Assign(nativeSession, FindTorrents(torrentIds), groupName);
+			}
+			finally
+			{
+				lock->ExitReadLock();
+				latency->RecordOperation("AssignBandwidthGroup", started);
+			}
+		}
+
+		/// <summary>
+		/// Moves torrents in the download queue, which decides which auto managed torrents are active.
+		/// </summary>
+		/// <param name="torrentIds">The IDs of the torrents to move. Their order relative to each other is kept.</param>
+		/// <param name="move">Where to move the torrents.</param>
+		/// <returns>True if all torrents were found, false otherwise.</returns>
+		virtual bool MoveInQueue(IReadOnlyList<TorrentId^>^ torrentIds, QueueMove move)
+		{
+			ArgumentNullException::ThrowIfNull(torrentIds, "torrentIds");
+
+			const auto started = latency->Start();
+			EnterReadLock();
+			try
+			{
+				std::vector<std::pair<int, libtorrent::torrent_handle>> queued;
+				const auto& handles = FindTorrents(torrentIds);
+				for (const auto& handle : handles)
+				{
+					if (const int position = static_cast<int>(handle.queue_position()); position >= 0)
+					{
+						queued.emplace_back(position, handle);
+					}
+				}
+
+				// Moving the torrents in this order keeps their order relative to each other
+				const bool ascending = move == QueueMove::Up || move == QueueMove::Bottom;
+				std::sort(queued.begin(), queued.end(),
+					[ascending](const std::pair<int, libtorrent::torrent_handle>& a,
+						const std::pair<int, libtorrent::torrent_handle>& b)
+					{
+						return ascending ? a.first < b.first : a.first > b.first;
+					});
+
+				for (const auto& [position, handle] : queued)
+				{
+					switch (move)
+					{
+					case QueueMove::Up:
+						handle.queue_position_up();
+						break;
+					case QueueMove::Down:
+						handle.queue_position_down();
+						break;
+					case QueueMove::Top:
+						handle.queue_position_top();
+						break;
+					case QueueMove::Bottom:
+						handle.queue_position_bottom();
+						break;
+					}
+				}
+
+				return handles.size() == static_cast<size_t>(torrentIds->Count);
+			}
+			finally
+			{
+				lock->ExitReadLock();
+				latency->RecordOperation("MoveInQueue", started);
+			}
+		}
+
+		/// <summary>
+		/// Moves a torrent to a specific position in the download queue.
+		/// </summary>
+		/// <param name="torrentId">The ID of the torrent to move.</param>
+		/// <param name="position">The new position, where 0 is the front of the queue.</param>
+		/// <returns>True if the torrent was moved, false if it wasn't found.</returns>
+		virtual bool SetQueuePosition(TorrentId^ torrentId, int position)
+		{
+			ArgumentNullException::ThrowIfNull(torrentId, "torrentId");
+			ArgumentOutOfRangeException::ThrowIfNegative(position, "position");
+
+			const auto started = latency->Start();
+			EnterReadLock();
+			try
+			{
+				const auto& hash = ParseInfoHash(torrentId);
+
+				if (const auto& handle = FindTorrent(hash.get_best()); handle.is_valid())
+				{
+					handle.queue_position_set(libtorrent::queue_position_t(position));
+					return true;
+				}
+				return false;
+			}
+			finally
+			{
+				lock->ExitReadLock();
+				latency->RecordOperation("SetQueuePosition", started);
+			}
+		}
+
+		/// <summary>
+		/// Connects a torrent directly to a peer, without going through trackers, DHT or local service discovery.
+		/// This is how sessions on the same machine, such as a seeder and leechers listening on 127.0.0.1, are
+		/// made to find each other.
+		/// </summary>
+		/// <param name="torrentId">The ID of the torrent to connect.</param>
+		/// <param name="endPoint">The address and port the peer listens on.</param>
+		/// <returns>True if the connection attempt was started, false if the torrent wasn't found.</returns>
+		virtual bool ConnectPeer(TorrentId^ torrentId, IPEndPoint^ endPoint)
+		{
+			ArgumentNullException::ThrowIfNull(torrentId, "torrentId");
+			ArgumentNullException::ThrowIfNull(endPoint, "endPoint");
+
+			const auto started = latency->Start();
+			EnterReadLock();
+			try
+			{
+				marshal_context context;
+				const auto& address = boost::asio::ip::make_address(
+					context.marshal_as<std::string>(endPoint->Address->ToString()));
+				const auto& hash = ParseInfoHash(torrentId);
+
+				if (const auto& handle = FindTorrent(hash.get_best()); handle.is_valid())
+				{
+					handle.connect_peer(libtorrent::tcp::endpoint(address, static_cast<unsigned short>(endPoint->Port)));
+					return true;
+				}
+				return false;
+			}
+			catch (const std::exception& e)
+			{
+				auto message = String::Format("Failed to connect to peer {0}: {1}", endPoint, gcnew String(e.what()));
+				logger->Log(ILogger::LogLevel::Error, message);
+				throw gcnew TorrentException(message);
+			}
+			finally
+			{
+				lock->ExitReadLock();
+				latency->RecordOperation("ConnectPeer", started);
+			}
+		}
+
+		/// <summary>
+		/// Gets the port the session accepts incoming connections on.
+		/// </summary>
+		/// <returns>The listen port, or 0 if the session isn't listening.</returns>
+		virtual int GetListenPort()
+		{
+			const auto started = latency->Start();
+			EnterReadLock();
+			try
+			{
+				return nativeSession->listen_port();
+			}
+			finally
+			{
+				lock->ExitReadLock();
+				latency->RecordOperation("GetListenPort", started);
+			}
+		}
+
+		/// <summary>
+		/// Checks the files of torrents against their piece hashes again, e.g. after their disk was replaced. The
+		/// torrents wait for the session's checking slots, as auto managed torrents that get back their own flags
+		/// once checked. Progress is reported with RecheckProgressUpdated.
+		/// </summary>
+		/// <param name="torrentIds">The IDs of the torrents to recheck.</param>
+		/// <returns>The number of torrents whose recheck was started. Torrents without metadata are skipped.</returns>
+		virtual int RecheckTorrents(IReadOnlyList<TorrentId^>^ torrentIds)
+		{
+			return RecheckTorrents(torrentIds, gcnew RecheckOptions());
+		}
+
+		/// <summary>
+		/// Checks the files of torrents against their piece hashes again, e.g. after their disk was replaced. The
+		/// torrents wait for the checking slots set by the options, as auto managed torrents that get back their own
+		/// flags once checked. Progress is reported with RecheckProgressUpdated.
+		/// </summary>
+		/// <param name="torrentIds">The IDs of the torrents to recheck.</param>
+		/// <param name="options">How many torrents are checked at once, with how many hashing threads, and how fast
+		/// they may read from disk.</param>
+		/// <exception cref="ArgumentOutOfRangeException">Thrown if an option is out of range.</exception>
+		/// <returns>The number of torrents whose recheck was started. Torrents without metadata are skipped.</returns>
+		virtual int RecheckTorrents(IReadOnlyList<TorrentId^>^ torrentIds, RecheckOptions^ options)
+		{
+			ArgumentNullException::ThrowIfNull(torrentIds, "torrentIds");
+			ArgumentNullException::ThrowIfNull(options, "options");
+			ValidateRecheckOptions(options);
+
+			const auto started = latency->Start();
+			EnterReadLock();
+			try
+			{
+				const auto handles = FindTorrents(torrentIds);
+				auto ids = gcnew List<TorrentId^>(static_cast<int>(handles.size()));
+				for (const auto& handle : handles)
+				{
+					ids->Add(TorrentId::FromInfoHash(handle.info_hashes()));
+				}
+
+				const int rechecked = recheckScheduler->Start(nativeSession, handles, ids, options);
+				logger->Log(ILogger::LogLevel::Info, String::Format("Rechecking {0} torrents", rechecked));
+				return rechecked;
+			}
+			catch (const std::exception& e)
+			{
+				auto message = String::Format("Failed to recheck torrents: {0}", gcnew String(e.what()));
+				logger->Log(ILogger::LogLevel::Error, message);
+				throw gcnew TorrentException(message);
+			}
+			finally
+			{
+				lock->ExitReadLock();
+				latency->RecordOperation("RecheckTorrents", started);
+			}
+		}
+
+		/// <summary>
+		/// Changes the interval at which events are raised. The default interval is once every second.
+		/// Adjusting this interval can increase or decrease the frequency of event invocations, which may impact performance.
+		/// </summary>
+		/// <param name="interval">The new interval to use, specified as a <see cref="TimeSpan"/>. The interval represents the duration between consecutive events.</param>
+		/// <remarks>Use caution when setting very short intervals, as it may result in a high frequency of events.</remarks>
+		virtual void ChangeEventTimerInterval(TimeSpan interval)
+		{
+			if (interval == TimeSpan::Zero)
+			{
+				throw gcnew ArgumentException("Time span must be greater than zero.", "interval");
+			}
+
+			const auto started = latency->Start();
+			alertTimer->Interval = interval.TotalMilliseconds;
+			latency->RecordOperation("ChangeEventTimerInterval", started);
+		}
+
+		/// <summary>
+		/// Gets the status of a specific torrent in the session.
+		/// </summary>
+		/// <param name="torrentId">The ID of the torrent to get the status of.</param>
+		/// <returns>The status of the specified torrent.</returns>
+		virtual TorrentStatus^ GetTorrentStatus(TorrentId^ torrentId)
+		{
+			ArgumentNullException::ThrowIfNull(torrentId, "torrentId");
+
+			const auto started = latency->Start();
+			EnterReadLock();
+			try
+			{
+				const auto& hash = ParseInfoHash(torrentId);
+
+				if (const auto& handle = FindTorrent(hash.get_best()); handle.is_valid())
+				{
+					return CreateTorrentStatus(handle.status(), torrentId);
+				}
+
+				throw gcnew InvalidOperationException("Torrent with the specified info hash was not found.");
+			}
+			finally
+			{
+				lock->ExitReadLock();
+				latency->RecordOperation("GetTorrentStatus", started);
+			}
+		}
+
+
+		/// <summary>
+		/// Gets the status of all torrents in the session.
+		/// </summary>
+		/// <returns>A list of the status of all torrents in the session.</returns>
+		virtual IReadOnlyList<TorrentStatus^>^ GetTorrentStatuses()
+		{
+			const auto started = latency->Start();
+			std::vector<libtorrent::torrent_handle> handles;
+
+			EnterReadLock();
+			try
+			{
+				handles = nativeSession->get_torrents();
+			}
+			finally
+			{
+				lock->ExitReadLock();
+			}
+
+			auto statuses = gcnew List<TorrentStatus^>(static_cast<long>(handles.size()));
+
+			for (const auto& handle : handles)
 			{
 				if (handle.is_valid())
 				{
-					const auto status = handle.status();
-					TorrentId^ torrentId = InfoHashToTorrentId(handle.info_hashes());
-					TorrentStatus^ managedStatus = CreateTorrentStatus(status, torrentId);
-					statuses->Add(managedStatus);
+					const auto status = handle.status();
+					TorrentId^ torrentId = TorrentId::FromInfoHash(handle.info_hashes());
+					TorrentStatus^ managedStatus = CreateTorrentStatus(status, torrentId);
+					statuses->Add(managedStatus);
+				}
+			}
+
+			latency->RecordOperation("GetTorrentStatuses", started);
+			return statuses;
+		}
+
+		/// <summary>
+		/// Gets all torrents in the session.
+		/// </summary>
+		/// <returns>A list of all torrents in the session.</returns>
+		virtual IReadOnlyList<TorrentInfo^>^ GetTorrents()
+		{
+			const auto started = latency->Start();
+			std::vector<libtorrent::torrent_handle> handles;
+
+			EnterReadLock();
+			try
+			{
+				handles = nativeSession->get_torrents();
+			}
+			finally
+			{
+				lock->ExitReadLock();
+			}
+
+			auto torrents = gcnew List<TorrentInfo^>(static_cast<long>(handles.size()));
+
+			for (const auto& handle : handles)
+			{
+				if (handle.is_valid())
+				{
+					auto torrent = CreateTorrentInfo(handle);
+					torrents->Add(torrent);
+				}
+			}
+
+			latency->RecordOperation("GetTorrents", started);
+			return torrents;
+		}
+
+		/// <summary>
+		/// Gets the torrent info of a specific torrent in the session.
+		/// </summary>
+		/// <param name="torrentId">The ID of the torrent to get the torrent info of.</param>
+		/// <returns>The torrent info of the specified torrent.</returns>
+		virtual TorrentInfo^ GetTorrentInfo(TorrentId^ torrentId)
+		{
+			ArgumentNullException::ThrowIfNull(torrentId, "torrentId");
+
+			const auto started = latency->Start();
+			EnterReadLock();
+			try
+			{
+				const auto& hash = ParseInfoHash(torrentId);
+
+				if (const auto& handle = FindTorrent(hash.get_best()); handle.is_valid())
+				{
+					return CreateTorrentInfo(handle);
+				}
+
+				throw gcnew InvalidOperationException("Torrent with the specified info hash was not found.");
+			}
+			finally
+			{
+				lock->ExitReadLock();
+				latency->RecordOperation("GetTorrentInfo", started);
+			}
+		}
+
+		/// <summary>
+		/// Gets the most recent sample of the session's performance counters. The counters are also published as
+		/// System.Diagnostics.Metrics instruments on the "LibtorrentDotNet.Session" meter.
+		/// </summary>
+		/// <returns>The latest sample, or null if sampling is disabled or no sample was taken yet.</returns>
+		virtual SessionStatistics^ GetSessionStatistics()
+		{
+			const auto started = latency->Start();
+			auto statistics = statsCollector->Latest;
+			latency->RecordOperation("GetSessionStatistics", started);
+			return statistics;
+		}
+
+		/// <summary>
+		/// Gets how much time the session has spent in its public methods, in the steps inside them and in alert
+		/// handlers. The durations are also published as System.Diagnostics.Metrics histograms on the
+		/// "LibtorrentDotNet.Latency" meter.
+		/// </summary>
+		/// <returns>The latency histograms, which are empty unless latency tracking is enabled.</returns>
+		virtual LatencyReport^ GetLatencyReport()
+		{
+			return latency->CreateReport();
+		}
+
+		/// <summary>
+		/// Gets how much memory the session has allocated to its disk queue, send buffers, alert queue, stream
+		/// buffers and managed heap, and the budget they are held to.
+		/// </summary>
+		/// <returns>The allocations of the session.</returns>
+		virtual MemoryReport^ GetMemoryReport()
+		{
+			const auto started = latency->Start();
+			auto streams = GetOpenStreams();
+
+			EnterReadLock();
+			try
+			{
+				return memoryBudget->CreateReport(nativeSession, streams);
+			}
+			finally
+			{
+				lock->ExitReadLock();
+				latency->RecordOperation("GetMemoryReport", started);
+			}
+		}
+
+		/// <summary>
+		/// Starts writing every alert the session pops to a compact binary trace, with its type, its time and the
+		/// payload the session raised an event with. The trace can be replayed with ReplayAlertTrace to profile the
+		/// alert handling and the event subscribers offline.
+		/// </summary>
+		/// <param name="output">The stream to write the trace to. It is not closed by the session.</param>
+		/// <exception cref="InvalidOperationException">Thrown if a trace is already being recorded.</exception>
+		virtual void StartAlertTrace(Stream^ output)
+		{
+			ArgumentNullException::ThrowIfNull(output, "output");
+
+			const auto started = latency->Start();
+			Monitor::Enter(alertPumpSync);
+			try
+			{
+				if (alertTrace != nullptr)
+				{
+					throw gcnew InvalidOperationException("An alert trace is already being recorded.");
+				}
+
+				alertTrace = gcnew AlertTraceWriter(output);
+			}
+			finally
+			{
+				Monitor::Exit(alertPumpSync);
+				latency->RecordOperation("StartAlertTrace", started);
+			}
+		}
+
+		/// <summary>
+		/// Stops recording the alert trace started with StartAlertTrace and flushes it to its stream.
+		/// </summary>
+		/// <returns>True if a trace was being recorded, false otherwise.</returns>
+		virtual bool StopAlertTrace()
+		{
+			const auto started = latency->Start();
+			Monitor::Enter(alertPumpSync);
+			try
+			{
+				if (alertTrace == nullptr)
+				{
+					return false;
+				}
+
+				alertTrace->Flush();
+				alertTrace = nullptr;
+				return true;
+			}
+			finally
+			{
+				Monitor::Exit(alertPumpSync);
+				latency->RecordOperation("StopAlertTrace", started);
+			}
+		}
+
+		/// <summary>
+		/// Raises the events of a recorded alert trace again, through the same events as live alerts. Alerts the
+		/// session handles internally, such as read_piece_alert, are read but not dispatched. Replaying into a session
+		/// without torrents keeps the replayed events apart from live ones.
+		/// </summary>
+		/// <param name="input">The stream to read the trace from. It is not closed by the session.</param>
+		/// <param name="speed">Whether to keep the recorded spacing between alerts or replay them back to back.</param>
+		/// <returns>The number of alerts replayed and how long it took.</returns>
+		/// <exception cref="InvalidDataException">Thrown if the stream is not a valid alert trace.</exception>
+		virtual AlertReplayResult^ ReplayAlertTrace(Stream^ input, AlertReplaySpeed speed)
+		{
+			ArgumentNullException::ThrowIfNull(input, "input");
+
+			const auto started = latency->Start();
+			try
+			{
+				auto reader = gcnew AlertTraceReader(input);
+				auto clock = Diagnostics::Stopwatch::StartNew();
+				int alertCount = 0;
+				int dispatchedCount = 0;
+				TimeSpan recordedDuration = TimeSpan::Zero;
+
+				for (auto record = reader->Read(); record != nullptr; record = reader->Read())
+				{
+					if (speed == AlertReplaySpeed::Recorded)
+					{
+						WaitUntil(clock, record->Timestamp);
+					}
+
+					// Taken per alert, like a pump, so replayed events never interleave with a live batch
+					Monitor::Enter(alertPumpSync);
+					try
+					{
+						if (DispatchTracedAlert(record))
+						{
+							dispatchedCount++;
+						}
+					}
+					finally
+					{
+						Monitor::Exit(alertPumpSync);
+					}
+
+					alertCount++;
+					recordedDuration = record->Timestamp;
+				}
+
+				return gcnew AlertReplayResult(alertCount, dispatchedCount, recordedDuration, clock->Elapsed);
+			}
+			finally
+			{
+				latency->RecordOperation("ReplayAlertTrace", started);
+			}
+		}
+
+	internal:
+		// The hot paths below are internal so the benchmark project can drive them without a swarm.
+		libtorrent::torrent_handle FindTorrent(const libtorrent::sha1_hash& infoHash)
+		{
+			const auto started = latency->Start();
+			auto handle = nativeSession->find_torrent(infoHash);
+			latency->RecordStep("FindTorrent", started);
+			return handle;
+		}
+
+		libtorrent::info_hash_t ParseInfoHash(TorrentId^ torrentId)
+		{
+			const auto started = latency->Start();
+			try
+			{
+				// Decoded straight from the managed string, without marshalling it to a std::string first
+				const auto hashString = torrentId->ToString();
+				if (hashString->Length != 40 && hashString->Length != 64)
+				{
+					throw gcnew ArgumentException("Invalid info hash format");
+				}
+
+				const int hashSize = hashString->Length / 2;
+				char hashBytes[32];
+				for (int i = 0; i < hashSize; i++)
+				{
+					const int high = HexDigitValue(hashString[i * 2]);
+					const int low = HexDigitValue(hashString[i * 2 + 1]);
+					if (high < 0 || low < 0)
+					{
+						throw gcnew ArgumentException("Invalid info hash format");
+					}
+					hashBytes[i] = static_cast<char>(high << 4 | low);
+				}
+
+				if (hashSize == 20)
+				{
+					return libtorrent::info_hash_t(libtorrent::sha1_hash(hashBytes));
+				}
+
+				return libtorrent::info_hash_t(libtorrent::sha256_hash(hashBytes));
+			}
+			finally
+			{
+				latency->RecordStep("ParseInfoHash", started);
+			}
+		}
+
+		TorrentStatus^ CreateTorrentStatus(const libtorrent::torrent_status& status, TorrentId^ torrentId)
+		{
+			const auto started = latency->Start();
+			TorrentState torrentState;
+			switch (status.state)
+			{
+			case libtorrent::torrent_status::checking_files:
+				torrentState = TorrentState::CheckingFiles;
+				break;
+			case libtorrent::torrent_status::downloading_metadata:
+				torrentState = TorrentState::DownloadingMetadata;
+				break;
+			case libtorrent::torrent_status::downloading:
+				torrentState = TorrentState::Downloading;
+				break;
+			case libtorrent::torrent_status::finished:
+				torrentState = TorrentState::Finished;
+				break;
+			case libtorrent::torrent_status::seeding:
+				torrentState = TorrentState::Seeding;
+				break;
+			case libtorrent::torrent_status::checking_resume_data:
+				torrentState = TorrentState::CheckingResumeData;
+				break;
+			default:
+				torrentState = TorrentState::Unknown;
+				break;
+			}
+
+			auto managedStatus = gcnew TorrentStatus(
+				torrentId,
+				torrentState,
+				status.progress,
+				status.total_download,
+				status.total_upload,
+				status.download_rate,
+				status.upload_rate,
+				status.num_peers,
+				status.num_seeds,
+				static_cast<int>(status.queue_position));
+
+			latency->RecordStep("CreateTorrentStatus", started);
+			return managedStatus;
+		}
+
+		TorrentInfo^ CreateTorrentInfo(const libtorrent::torrent_handle& handle)
+		{
+			const auto started = latency->Start();
+			TorrentId^ torrentId = TorrentId::FromInfoHash(handle.info_hashes());
+			const auto& status = handle.status();
+			auto name = gcnew String(status.name.c_str());
+			auto savePath = gcnew String(status.save_path.c_str());
+			TorrentStatus^ managedStatus = CreateTorrentStatus(status, torrentId);
+			UInt64 totalSize = 0;
+
+			List<TorrentFileEntry^>^ fileEntries;
+			// torrent_file() is a round trip to the network thread, so it is only fetched once
+			if (const auto& torrentFile = handle.torrent_file())
+			{
+				const auto& files = torrentFile->files();
+				fileEntries = gcnew List<TorrentFileEntry^>(files.num_files());
+
+				for (const auto& index : files.file_range())
+				{
+					const auto& path = gcnew String(files.file_path(index, status.save_path).c_str());
+					const auto& fileName = files.file_name(index);
+					const auto& filename = gcnew String(fileName.data(), 0, static_cast<int>(fileName.size()));
+					const auto& size = files.file_size(index);
+
+					fileEntries->Add(gcnew TorrentFileEntry(static_cast<int>(index), path, filename, size));
+				}
+
+				totalSize = torrentFile->total_size();
+			}
+			else
+			{
+				fileEntries = gcnew List<TorrentFileEntry^>(0);
+			}
+
+			auto torrentInfo = gcnew TorrentInfo(torrentId, name, managedStatus, fileEntries, totalSize, savePath);
+			latency->RecordStep("CreateTorrentInfo", started);
+			return torrentInfo;
+		}
+
+		void ProcessAlert(libtorrent::alert* alert)
+		{
+			const auto started = latency->Start();
+			try
+			{
+				if (const auto* readPieceAlert = libtorrent::alert_cast<libtorrent::read_piece_alert>(alert))
+				{
+					if (alertTrace != nullptr)
+					{
+						alertTrace->WriteOther(alert->type());
+					}
+
+					if (!pieceReaders->IsEmpty)
+					{
+						pieceReaders->Dispatch(TorrentId::FromInfoHash(readPieceAlert->handle.info_hashes()),
+							readPieceAlert);
+					}
+				}
+				else if (const auto* statsAlert = libtorrent::alert_cast<libtorrent::session_stats_alert>(alert))
+				{
+					if (alertTrace != nullptr)
+					{
+						alertTrace->WriteOther(alert->type());
+					}
+
+					if (auto statistics = statsCollector->OnSessionStats(statsAlert); statistics != nullptr)
+					{
+						SessionStatisticsUpdated(this, gcnew SessionStatisticsEventArgs(statistics));
+					}
+				}
+				else if (const auto* addAlert = libtorrent::alert_cast<libtorrent::add_torrent_alert>(alert))
+				{
+					RaiseTorrentOperation(alert, addAlert->handle, TorrentOperationEvent::Added);
+				}
+				else if (const auto* finishAlert = libtorrent::alert_cast<libtorrent::torrent_finished_alert>(alert))
+				{
+					RaiseTorrentOperation(alert, finishAlert->handle, TorrentOperationEvent::Finished);
+				}
+				else if (const auto* removeAlert = libtorrent::alert_cast<libtorrent::torrent_removed_alert>(alert))
+				{
+					RaiseTorrentOperation(alert, removeAlert->handle, TorrentOperationEvent::Removed);
+				}
+				else if (const auto* errorAlert = libtorrent::alert_cast<libtorrent::torrent_error_alert>(alert))
+				{
+					TorrentId^ torrentId = TorrentId::FromInfoHash(errorAlert->handle.info_hashes());
+					auto error = gcnew String(errorAlert->error.message().c_str());
+					if (alertTrace != nullptr)
+					{
+						alertTrace->WriteError(alert->type(), torrentId, error);
+					}
+					recheckScheduler->OnTorrentError(nativeSession, errorAlert->handle, error);
+					TorrentError(this, gcnew TorrentErrorEventArgs(torrentId, error));
+				}
+				else if (const auto* checkedAlert = libtorrent::alert_cast<libtorrent::torrent_checked_alert>(alert))
+				{
+					if (alertTrace != nullptr)
+					{
+						alertTrace->WriteOther(alert->type());
+					}
+
+					recheckScheduler->OnTorrentChecked(nativeSession, checkedAlert->handle);
+				}
+				else if (const auto* pauseAlert = libtorrent::alert_cast<libtorrent::torrent_paused_alert>(alert))
+				{
+					RaiseTorrentOperation(alert, pauseAlert->handle, TorrentOperationEvent::Paused);
+				}
+				else if (const auto* resumeAlert = libtorrent::alert_cast<libtorrent::torrent_resumed_alert>(alert))
+				{
+					RaiseTorrentOperation(alert, resumeAlert->handle, TorrentOperationEvent::Resumed);
+				}
+				else if (const auto* stateAlert = libtorrent::alert_cast<libtorrent::state_update_alert>(alert))
+				{
+					auto torrentStats = gcnew List<TorrentStatus^>(static_cast<long>(stateAlert->status.size()));
+
+					for (const auto& status : stateAlert->status)
+					{
+						TorrentId^ torrentId = TorrentId::FromInfoHash(status.info_hashes);
+						torrentStats->Add(CreateTorrentStatus(status, torrentId));
+					}
+
+					if (alertTrace != nullptr)
+					{
+						alertTrace->WriteStateUpdate(alert->type(), torrentStats);
+					}
+					TorrentStateUpdated(this, gcnew TorrentStateUpdateEventArgs(torrentStats));
+				}
+				else if (const auto* metadataAlert = libtorrent::alert_cast<libtorrent::metadata_received_alert>(alert))
+				{
+					if (metadataAlert->handle.is_valid())
+					{
+						const auto torrentInfo = CreateTorrentInfo(metadataAlert->handle);
+						if (alertTrace != nullptr)
+						{
+							alertTrace->WriteMetadataReceived(alert->type(), torrentInfo);
+						}
+						TorrentMetadataReceived(this, gcnew TorrentMetadataEventArgs(torrentInfo));
+					}
+					else if (alertTrace != nullptr)
+					{
+						alertTrace->WriteOther(alert->type());
+					}
+				}
+				else if (alertTrace != nullptr)
+				{
+					alertTrace->WriteOther(alert->type());
 				}
 			}
+			catch (const std::exception& e)
+			{
+				auto message = String::Format("Error when processing alert: {0}", gcnew String(e.what()));
+				logger->Log(ILogger::LogLevel::Error, message);
+				throw gcnew TorrentException(message);
+			}
+			finally
+			{
+				latency->RecordAlert(alert, started);
+			}
+		}
 
-			return statuses;
+	private:
+		enum class TorrentOperation
+		{
+			Pause,
+			Resume,
+			Remove
+		};
+
+		libtorrent::torrent_handle FindStreamableTorrent(TorrentId^ torrentId)
+		{
+			const auto& infoHash = ParseInfoHash(torrentId);
+			const auto& handle = FindTorrent(infoHash.get_best());
+
+			if (!handle.is_valid())
+			{
+				throw gcnew ArgumentException("Invalid TorrentId");
+			}
+
+			if (!handle.torrent_file())
+			{
+				throw gcnew InvalidOperationException("Torrent metadata not available yet");
+			}
+
+			return handle;
 		}
 
-		/// <summary>
-		/// Gets all torrents in the session.
-		/// </summary>
-		/// <returns>A list of all torrents in the session.</returns>
-		virtual IReadOnlyList<TorrentInfo^>^ GetTorrents()
+		TorrentStream^ OpenStream(const libtorrent::torrent_handle& handle,
+			const std::vector<libtorrent::file_index_t>& fileIndices, TimeSpan timeout, TorrentStreamOptions^ options)
 		{
-			std::vector<libtorrent::torrent_handle> handles;
+			const auto* streamHandle = new libtorrent::torrent_handle(handle);
+			auto streamTorrentId = TorrentId::FromInfoHash(handle.info_hashes());
+			PieceReader^ pieceReader = nullptr;
+			if (options->ReadBackend == TorrentStreamReadBackend::Libtorrent)
+			{
+				pieceReader = pieceReaders->Open(streamHandle, streamTorrentId,
+					options->MaxCachedPieceBytes, gcnew Action(this, &TorrentSession::QueueAlertPump));
+			}
 
-			lock->EnterReadLock();
+			// Streams on the same torrent share one schedule so they do not reset each other's pieces
+			auto windowManager = pieceWindows->Acquire(handle, streamTorrentId);
+
+			auto stream = TorrentStream::Create(streamHandle, fileIndices, timeout, options, pieceReader, windowManager,
+				memoryBudget->GetStreamBufferSize(GetOpenStreams()));
+
+			Monitor::Enter(openStreams);
 			try
 			{
-				handles = nativeSession->get_torrents();
+				openStreams->Add(stream);
 			}
 			finally
 			{
-				lock->ExitReadLock();
+				Monitor::Exit(openStreams);
 			}
 
-			auto torrents = gcnew List<TorrentInfo^>(static_cast<long>(handles.size()));
+			stream->SetClosedCallback(gcnew Action<TorrentStream^>(this, &TorrentSession::OnStreamClosed));
+			return stream;
+		}
 
-			for (const auto& handle : handles)
+		void OnStreamClosed(TorrentStream^ stream)
+		{
+			Monitor::Enter(openStreams);
+			try
 			{
-				if (handle.is_valid())
+				openStreams->Remove(stream);
+			}
+			finally
+			{
+				Monitor::Exit(openStreams);
+			}
+		}
+
+		array<TorrentStream^>^ GetOpenStreams()
+		{
+			Monitor::Enter(openStreams);
+			try
+			{
+				return openStreams->ToArray();
+			}
+			finally
+			{
+				Monitor::Exit(openStreams);
+			}
+		}
+
+		void PublishStreamMetrics()
+		{
+			array<TorrentStream^>^ streams;
+
+			Monitor::Enter(openStreams);
+			try
+			{
+				if (openStreams->Count == 0 && !streamingScheduler->IsEnabled)
 				{
-					auto torrent = CreateTorrentInfo(handle);
-					torrents->Add(torrent);
+					return;
 				}
+				streams = openStreams->ToArray();
+			}
+			finally
+			{
+				Monitor::Exit(openStreams);
 			}
 
-			return torrents;
+			auto metrics = gcnew List<TorrentStreamMetrics^>(streams->Length);
+			for each (auto stream in streams)
+			{
+				try
+				{
+					metrics->Add(stream->GetMetrics());
+				}
+				catch (ObjectDisposedException^)
+				{
+					// Closed since the list was copied
+				}
+			}
+
+			if (metrics->Count > 0)
+			{
+				StreamMetricsUpdated(this, gcnew TorrentStreamMetricsEventArgs(metrics));
+			}
+
+			UpdateStreamingScheduler(metrics);
 		}
 
-		/// <summary>
-		/// Gets the torrent info of a specific torrent in the session.
-		/// </summary>
-		/// <param name="torrentId">The ID of the torrent to get the torrent info of.</param>
-		/// <returns>The torrent info of the specified torrent.</returns>
-		virtual TorrentInfo^ GetTorrentInfo(TorrentId^ torrentId)
+		void UpdateStreamingScheduler(IReadOnlyList<TorrentStreamMetrics^>^ metrics)
 		{
-			ArgumentNullException::ThrowIfNull(torrentId, "torrentId");
+			if (!streamingScheduler->IsEnabled)
+			{
+				return;
+			}
 
-			lock->EnterReadLock();
+			EnterReadLock();
 			try
 			{
-				const auto& hash = ParseInfoHash(torrentId);
-
-				if (const auto& handle = nativeSession->find_torrent(hash.get_best()); handle.is_valid())
+				// Keyed by the handles' own info hashes, which for hybrid torrents hold more than the ID does
+				std::unordered_set<libtorrent::info_hash_t> streamingTorrents;
+				for each (auto streamMetrics in metrics)
 				{
-					return CreateTorrentInfo(handle);
+					if (const auto handle = FindTorrent(ParseInfoHash(streamMetrics->Id).get_best()); handle.is_valid())
+					{
+						streamingTorrents.insert(handle.info_hashes());
+					}
 				}
 
-				throw gcnew InvalidOperationException("Torrent with the specified info hash was not found.");
+				streamingScheduler->Update(nativeSession, metrics, streamingTorrents);
 			}
 			finally
 			{
@@ -835,14 +2164,6 @@ namespace LibtorrentDotNet
 			}
 		}
 
-	private:
-		enum class TorrentOperation
-		{
-			Pause,
-			Resume,
-			Remove
-		};
-
 		void Initialize(Optional<TorrentSessionConfig^>^ config, Optional<ILogger^>^ logger)
 		{
 			if (logger->HasValue)
@@ -854,9 +2175,25 @@ namespace LibtorrentDotNet
 				this->logger = gcnew NullLogger();
 			}
 
-			nativeSession = new libtorrent::session();
+			latency = gcnew LatencyTracker(config->HasValue &&
+				config->Value->EnableLatencyTracking->GetValueOrDefault(false));
+			nativeSession = CreateNativeSession(config->HasValue ? config->Value->DiskBackend : DiskIoBackend::Default);
 			lock = gcnew ReaderWriterLockSlim();
 			isListeningToAlerts = false;
+			alertPumpSync = gcnew Object();
+			isPumpingAlerts = false;
+			isAlertPumpQueued = 0;
+			pieceReaders = gcnew PieceReaderRegistry();
+			pieceWindows = gcnew PieceWindowRegistry();
+			openStreams = gcnew List<TorrentStream^>();
+			pausedAutoManagedTorrents = gcnew HashSet<TorrentId^>();
+			streamingScheduler = gcnew StreamingBandwidthScheduler(
+				config->HasValue ? config->Value->StreamingSettings : nullptr);
+			bandwidthGroups = gcnew BandwidthGroupManager();
+			recheckScheduler = gcnew RecheckScheduler();
+			memoryBudget = gcnew MemoryBudgetManager(config->HasValue ? config->Value->MemoryBudget : nullptr,
+				this->logger);
+			statsCollector = gcnew SessionStatsCollector(config->HasValue ? config->Value->StatsSettings : nullptr);
 
 			if (config->HasValue)
 			{
@@ -900,86 +2237,338 @@ namespace LibtorrentDotNet
 			alertTimer->Stop();
 		}
 
-		bool PerformTorrentOperation(IReadOnlyList<TorrentId^>^ torrentIds, const TorrentOperation operation,
-			const bool deleteFiles)
+		void EnterReadLock()
 		{
-			ArgumentNullException::ThrowIfNull(torrentIds, "torrentIds");
+			const auto started = latency->Start();
+			lock->EnterReadLock();
+			latency->RecordStep("ReadLockWait", started);
+		}
+
+		void EnterWriteLock()
+		{
+			const auto started = latency->Start();
+			lock->EnterWriteLock();
+			latency->RecordStep("WriteLockWait", started);
+		}
+
+		std::vector<libtorrent::torrent_handle> FindTorrents(IReadOnlyList<TorrentId^>^ torrentIds)
+		{
+			// A single lookup is cheaper than copying the handles of every torrent in the session
+			if (torrentIds->Count == 1)
+			{
+				std::vector<libtorrent::torrent_handle> handles;
+				if (const auto& handle = FindTorrent(ParseInfoHash(torrentIds[0]).get_best()); handle.is_valid())
+				{
+					handles.push_back(handle);
+				}
+				return handles;
+			}
 
-			std::unordered_set<libtorrent::info_hash_t> infoHashSet;
+			// Compared by their best hash, since a hybrid torrent's ID only holds its v2 hash
+			std::unordered_set<libtorrent::sha1_hash> infoHashSet;
 			for each(TorrentId ^ torrentId in torrentIds)
 			{
-				infoHashSet.insert(ParseInfoHash(torrentId));
+				infoHashSet.insert(ParseInfoHash(torrentId).get_best());
 			}
 
 			std::vector<libtorrent::torrent_handle> handles;
-			lock->EnterReadLock();
+			for (const auto& handle : nativeSession->get_torrents())
+			{
+				if (handle.is_valid() && infoHashSet.contains(handle.info_hashes().get_best()))
+				{
+					handles.push_back(handle);
+				}
+			}
+			return handles;
+		}
+
+		static String^ GetOperationName(const TorrentOperation operation)
+		{
+			switch (operation)
+			{
+			case TorrentOperation::Pause:
+				return "PauseTorrents";
+			case TorrentOperation::Resume:
+				return "ResumeTorrents";
+			default:
+				return "RemoveTorrents";
+			}
+		}
+
+		bool PerformTorrentOperation(IReadOnlyList<TorrentId^>^ torrentIds, const TorrentOperation operation,
+			const bool deleteFiles)
+		{
+			ArgumentNullException::ThrowIfNull(torrentIds, "torrentIds");
+
+			const auto started = latency->Start();
+			std::vector<libtorrent::torrent_handle> handles;
+			EnterReadLock();
 			try
 			{
-				for (const auto& handle : nativeSession->get_torrents())
+				handles = FindTorrents(torrentIds);
+			}
+			finally
+			{
+				lock->ExitReadLock();
+			}
+
+			bool allSuccessful = true;
+			for (const auto& handle : handles)
+			{
+				bool operationSuccess = false;
+				switch (operation)
 				{
-					if (handle.is_valid() && infoHashSet.contains(handle.info_hashes()))
+				case TorrentOperation::Pause:
+					PauseHandle(handle);
+					operationSuccess = true;
+					break;
+				case TorrentOperation::Resume:
+					ResumeHandle(handle);
+					operationSuccess = true;
+					break;
+				case TorrentOperation::Remove:
+					ForgetPausedTorrent(handle);
+					EnterWriteLock();
+					try
+					{
+						if (deleteFiles)
+						{
+							nativeSession->remove_torrent(handle, libtorrent::session_handle::delete_files);
+							operationSuccess = true;
+						}
+						else
+						{
+							nativeSession->remove_torrent(handle);
+							operationSuccess = true;
+						}
+					}
+					finally
 					{
-						handles.push_back(handle);
+						lock->ExitWriteLock();
 					}
+					break;
+				}
+				allSuccessful &= operationSuccess;
+			}
+
+			// If no handles were found, consider the operation unsuccessful
+			if (handles.empty())
+			{
+				allSuccessful = false;
+			}
+
+			latency->RecordOperation(GetOperationName(operation), started);
+			return allSuccessful;
+		}
+
+		void PauseHandle(const libtorrent::torrent_handle& handle)
+		{
+			// A torrent the streaming scheduler paused is no longer flagged auto managed, but it was before
+			const bool throttledAutoManaged = streamingScheduler->OnTorrentPaused(handle.info_hashes());
+			const bool autoManaged = throttledAutoManaged ||
+				static_cast<bool>(handle.flags() & libtorrent::torrent_flags::auto_managed);
+
+			// The queue would resume an auto managed torrent right away, so it leaves the queue until it is resumed
+			handle.unset_flags(libtorrent::torrent_flags::auto_managed);
+			handle.pause();
+
+			if (autoManaged)
+			{
+				Monitor::Enter(pausedAutoManagedTorrents);
+				try
+				{
+					pausedAutoManagedTorrents->Add(TorrentId::FromInfoHash(handle.info_hashes()));
+				}
+				finally
+				{
+					Monitor::Exit(pausedAutoManagedTorrents);
 				}
 			}
+		}
+
+		void ResumeHandle(const libtorrent::torrent_handle& handle)
+		{
+			if (ForgetPausedTorrent(handle))
+			{
+				// Back in the queue, which resumes it once there is a free download or seed slot
+				handle.set_flags(libtorrent::torrent_flags::auto_managed);
+			}
+			handle.resume();
+		}
+
+		/// <summary>
+		/// Forgets whether a paused torrent was auto managed.
+		/// </summary>
+		/// <returns>true if the torrent was auto managed when it was paused.</returns>
+		bool ForgetPausedTorrent(const libtorrent::torrent_handle& handle)
+		{
+			Monitor::Enter(pausedAutoManagedTorrents);
+			try
+			{
+				return pausedAutoManagedTorrents->Remove(TorrentId::FromInfoHash(handle.info_hashes()));
+			}
 			finally
 			{
-				lock->ExitReadLock();
+				Monitor::Exit(pausedAutoManagedTorrents);
+			}
+		}
+
+		static void ValidateRecheckOptions(RecheckOptions^ options)
+		{
+			if (options->ActiveChecking->HasValue && options->ActiveChecking->Value < 1)
+			{
+				throw gcnew ArgumentOutOfRangeException("options", "ActiveChecking must be at least 1.");
+			}
+			if (options->HashingThreads->HasValue && options->HashingThreads->Value < 1)
+			{
+				throw gcnew ArgumentOutOfRangeException("options", "HashingThreads must be at least 1.");
+			}
+			if (options->MaxReadRate->HasValue && options->MaxReadRate->Value <= 0)
+			{
+				throw gcnew ArgumentOutOfRangeException("options", "MaxReadRate must be greater than 0.");
+			}
+		}
+
+		static void ApplyAddTorrentOptions(AddTorrentOptions^ options, libtorrent::add_torrent_params& params)
+		{
+			params.storage_mode = options->StorageMode == TorrentStorageMode::Allocate
+				? libtorrent::storage_mode_allocate
+				: libtorrent::storage_mode_sparse;
+
+			if (options->AutoManaged)
+			{
+				params.flags |= libtorrent::torrent_flags::auto_managed;
+			}
+			else
+			{
+				// A torrent outside the queue would stay paused forever
+				params.flags &= ~(libtorrent::torrent_flags::auto_managed | libtorrent::torrent_flags::paused);
+			}
+
+			if (options->FilePriorities != nullptr)
+			{
+				params.file_priorities.clear();
+				params.file_priorities.reserve(options->FilePriorities->Count);
+				for each (auto priority in options->FilePriorities)
+				{
+					params.file_priorities.push_back(ToNativePriority(priority));
+				}
+			}
+
+			// Seed mode trusts the files to match the metadata, so there has to be metadata
+			if (options->SeedMode && params.ti != nullptr)
+			{
+				params.flags |= libtorrent::torrent_flags::seed_mode;
+			}
+
+			// Without metadata the piece count is unknown, and libtorrent would reject the priorities
+			if (options->PiecePriorities != nullptr && params.ti != nullptr)
+			{
+				params.piece_priorities.clear();
+				params.piece_priorities.reserve(options->PiecePriorities->Count);
+				for each (auto priority in options->PiecePriorities)
+				{
+					params.piece_priorities.push_back(ToNativePriority(priority));
+				}
+			}
+		}
+
+		void StartSeedVerification(AddTorrentOptions^ options, const libtorrent::torrent_info& torrentInfo,
+			const std::string& savePath)
+		{
+			if (!options->SeedMode || options->SeedVerification == nullptr)
+			{
+				return;
+			}
+
+			TorrentId^ torrentId = TorrentId::FromInfoHash(torrentInfo.info_hashes());
+			auto verifier = SeedModeVerifier::Create(torrentId, torrentInfo, savePath, options->SeedVerification);
+			if (verifier == nullptr)
+			{
+				logger->Log(ILogger::LogLevel::Warning, String::Format(
+					"Torrent {0} has no v1 piece hashes to sample, relying on seed mode verification alone", torrentId));
+				return;
 			}
 
-			bool allSuccessful = true;
-			for (const auto& handle : handles)
+			verifier->Start(gcnew Action<SeedModeVerifier^>(this, &TorrentSession::OnSeedVerificationCompleted));
+		}
+
+		void OnSeedVerificationCompleted(SeedModeVerifier^ verifier)
+		{
+			bool recheckStarted = false;
+			if (verifier->FailedPieces->Count > 0 && verifier->Policy->RecheckOnFailure)
 			{
-				bool operationSuccess = false;
-				switch (operation)
+				EnterReadLock();
+				try
 				{
-				case TorrentOperation::Pause:
-					handle.pause();
-					operationSuccess = true;
-					break;
-				case TorrentOperation::Resume:
-					handle.resume();
-					operationSuccess = true;
-					break;
-				case TorrentOperation::Remove:
-					lock->EnterWriteLock();
-					try
+					// Leaving seed mode makes libtorrent check all of the files, like a failed piece request would
+					if (nativeSession != nullptr)
 					{
-						if (deleteFiles)
+						if (const auto handle = FindTorrent(ParseInfoHash(verifier->Id).get_best()); handle.is_valid())
 						{
-							nativeSession->remove_torrent(handle, libtorrent::session_handle::delete_files);
-							operationSuccess = true;
-						}
-						else
-						{
-							nativeSession->remove_torrent(handle);
-							operationSuccess = true;
+							handle.unset_flags(libtorrent::torrent_flags::seed_mode);
+							recheckStarted = true;
 						}
 					}
-					finally
-					{
-						lock->ExitWriteLock();
-					}
-					break;
 				}
-				allSuccessful &= operationSuccess;
+				catch (const std::exception& e)
+				{
+					logger->Log(ILogger::LogLevel::Error,
+						String::Format("Failed to leave seed mode: {0}", gcnew String(e.what())));
+				}
+				finally
+				{
+					lock->ExitReadLock();
+				}
 			}
 
-			// If no handles were found, consider the operation unsuccessful
-			if (handles.empty())
+			logger->Log(verifier->FailedPieces->Count == 0 ? ILogger::LogLevel::Info : ILogger::LogLevel::Warning,
+				String::Format("Seed verification of torrent {0}: {1} of {2} sampled pieces failed in {3:F0} ms",
+					verifier->Id, verifier->FailedPieces->Count, verifier->SampledPieces,
+					verifier->Elapsed.TotalMilliseconds));
+
+			SeedVerificationCompleted(this, gcnew SeedVerificationEventArgs(gcnew SeedVerificationResult(verifier->Id,
+				verifier->TotalPieces, verifier->SampledPieces, verifier->FailedPieces, recheckStarted,
+				verifier->Elapsed)));
+		}
+
+		static libtorrent::download_priority_t ToNativePriority(const DownloadPriority priority)
+		{
+			if (static_cast<int>(priority) > static_cast<int>(DownloadPriority::Top))
 			{
-				allSuccessful = false;
+				throw gcnew ArgumentOutOfRangeException("priority", priority, "Priorities range from 0 to 7.");
 			}
 
-			return allSuccessful;
+			return libtorrent::download_priority_t(static_cast<std::uint8_t>(priority));
 		}
 
-		void ApplySettings(TorrentSessionConfig^ config)
+		static libtorrent::session* CreateNativeSession(const DiskIoBackend diskBackend)
+		{
+			libtorrent::session_params params;
+			switch (diskBackend)
+			{
+			case DiskIoBackend::MemoryMapped:
+				params.disk_io_constructor = libtorrent::mmap_disk_io_constructor;
+				break;
+			case DiskIoBackend::Posix:
+				params.disk_io_constructor = libtorrent::posix_disk_io_constructor;
+				break;
+			case DiskIoBackend::Memory:
+				params.disk_io_constructor = CreateMemoryDiskIo;
+				break;
+			default:
+				params.disk_io_constructor = libtorrent::default_disk_io_constructor;
+				break;
+			}
+
+			return new libtorrent::session(std::move(params));
+		}
+
+		libtorrent::settings_pack CreateSettingsPack(TorrentSessionConfig^ config)
 		{
 			try
 			{
-				libtorrent::settings_pack settings;
+				libtorrent::settings_pack settings = config->AdvancedSettings->ToSettingsPack();
 				marshal_context context;
 
 				if (config->ListenInterfaces->HasValue)
@@ -1027,6 +2616,29 @@ namespace LibtorrentDotNet
 					settings.set_int(libtorrent::settings_pack::upload_rate_limit,
 						config->BandwidthSettings->UploadRateLimit->Value);
 				}
+				if (config->QueueSettings->ActiveDownloads->HasValue)
+				{
+					settings.set_int(libtorrent::settings_pack::active_downloads,
+						config->QueueSettings->ActiveDownloads->Value);
+				}
+				if (config->QueueSettings->ActiveSeeds->HasValue)
+				{
+					settings.set_int(libtorrent::settings_pack::active_seeds, config->QueueSettings->ActiveSeeds->Value);
+				}
+				if (config->QueueSettings->ActiveLimit->HasValue)
+				{
+					settings.set_int(libtorrent::settings_pack::active_limit, config->QueueSettings->ActiveLimit->Value);
+				}
+				if (config->QueueSettings->ActiveChecking->HasValue)
+				{
+					settings.set_int(libtorrent::settings_pack::active_checking,
+						config->QueueSettings->ActiveChecking->Value);
+				}
+				if (config->QueueSettings->DontCountSlowTorrents->HasValue)
+				{
+					settings.set_bool(libtorrent::settings_pack::dont_count_slow_torrents,
+						config->QueueSettings->DontCountSlowTorrents->Value);
+				}
 				if (config->ProxySettings->ProxyType != None)
 				{
 					settings.set_int(libtorrent::settings_pack::proxy_type, config->ProxySettings->ProxyType);
@@ -1052,6 +2664,22 @@ namespace LibtorrentDotNet
 					}
 				}
 
+				return settings;
+			}
+			catch (const std::exception& e)
+			{
+				auto message = String::Format("Error when applying settings: {0}", gcnew String(e.what()));
+				logger->Log(ILogger::LogLevel::Error, message);
+				throw gcnew TorrentException(message);
+			}
+		}
+
+		void ApplySettings(TorrentSessionConfig^ config)
+		{
+			const auto& settings = CreateSettingsPack(config);
+
+			try
+			{
 				nativeSession->apply_settings(settings);
 			}
 			catch (const std::exception& e)
@@ -1062,217 +2690,268 @@ namespace LibtorrentDotNet
 			}
 		}
 
-		static libtorrent::info_hash_t ParseInfoHash(TorrentId^ torrentId)
+		static int DiffSettings(const libtorrent::settings_pack& current, const libtorrent::settings_pack& requested,
+			libtorrent::settings_pack& changed)
 		{
-			marshal_context context;
+			int changedCount = 0;
 
-			if (const auto& hashStr = context.marshal_as<std::string>(torrentId->ToString()); hashStr.length() == 40 ||
-				hashStr.length() == 64)
+			for (int setting = libtorrent::settings_pack::string_type_base;
+				setting < libtorrent::settings_pack::max_string_setting_internal; setting++)
 			{
-				const size_t hashSize = hashStr.length() / 2;
-				std::vector<char> hashBytes(hashSize);
-				for (int i = 0; i < hashSize; i++)
+				if (requested.has_val(setting) && requested.get_str(setting) != current.get_str(setting))
 				{
-					hashBytes[i] = static_cast<char>(std::stoi(
-						hashStr.substr(static_cast<std::basic_string<char>::size_type>(i) * 2, 2), nullptr, 16));
+					changed.set_str(setting, requested.get_str(setting));
+					changedCount++;
 				}
+			}
 
-				if (hashStr.length() == 40)
+			for (int setting = libtorrent::settings_pack::int_type_base;
+				setting < libtorrent::settings_pack::max_int_setting_internal; setting++)
+			{
+				if (requested.has_val(setting) && requested.get_int(setting) != current.get_int(setting))
 				{
-					return libtorrent::info_hash_t(libtorrent::sha1_hash(hashBytes.data()));
+					changed.set_int(setting, requested.get_int(setting));
+					changedCount++;
 				}
+			}
 
-				return libtorrent::info_hash_t(libtorrent::sha256_hash(hashBytes.data()));
+			for (int setting = libtorrent::settings_pack::bool_type_base;
+				setting < libtorrent::settings_pack::max_bool_setting_internal; setting++)
+			{
+				if (requested.has_val(setting) && requested.get_bool(setting) != current.get_bool(setting))
+				{
+					changed.set_bool(setting, requested.get_bool(setting));
+					changedCount++;
+				}
 			}
 
-			throw gcnew ArgumentException("Invalid info hash format");
+			return changedCount;
 		}
 
-		static TorrentId^ InfoHashToTorrentId(const libtorrent::info_hash_t& infoHash)
+		static int HexDigitValue(const wchar_t digit)
 		{
-			const auto& hash = infoHash.get_best();
-			const int hashSize = infoHash.has_v2() ? 32 : 20;
-			auto hexString = gcnew Text::StringBuilder(hashSize * 2);
-			hexString->EnsureCapacity(hashSize * 2);
-
-			for (int i = 0; i < hashSize; i++)
+			if (digit >= L'0' && digit <= L'9')
 			{
-				hexString->AppendFormat("{0:X2}", hash[i]);
+				return digit - L'0';
 			}
-
-			return gcnew TorrentId(hexString->ToString());
+			if (digit >= L'a' && digit <= L'f')
+			{
+				return digit - L'a' + 10;
+			}
+			if (digit >= L'A' && digit <= L'F')
+			{
+				return digit - L'A' + 10;
+			}
+			return -1;
 		}
 
-		static TorrentStatus^ CreateTorrentStatus(const libtorrent::torrent_status& status, TorrentId^ torrentId)
+		void OnAlertTimerElapsed(Object^ sender, ElapsedEventArgs^ e)
 		{
-			TorrentState torrentState;
-			switch (status.state)
+			if (!isListeningToAlerts)
 			{
-			case libtorrent::torrent_status::checking_files:
-				torrentState = TorrentState::CheckingFiles;
-				break;
-			case libtorrent::torrent_status::downloading_metadata:
-				torrentState = TorrentState::DownloadingMetadata;
-				break;
-			case libtorrent::torrent_status::downloading:
-				torrentState = TorrentState::Downloading;
-				break;
-			case libtorrent::torrent_status::finished:
-				torrentState = TorrentState::Finished;
-				break;
-			case libtorrent::torrent_status::seeding:
-				torrentState = TorrentState::Seeding;
-				break;
-			case libtorrent::torrent_status::checking_resume_data:
-				torrentState = TorrentState::CheckingResumeData;
-				break;
-			default:
-				torrentState = TorrentState::Unknown;
-				break;
+				return;
 			}
 
-			auto managedStatus = gcnew TorrentStatus(
-				torrentId,
-				torrentState,
-				status.progress,
-				status.total_download,
-				status.total_upload,
-				status.download_rate,
-				status.upload_rate,
-				status.num_peers,
-				status.num_seeds);
+			nativeSession->post_torrent_updates();
+			if (statsCollector->IsSampleDue())
+			{
+				nativeSession->post_session_stats();
+			}
 
-			return managedStatus;
-		}
+			// The timer swallows exceptions, so one from an alert or an event subscriber would silently skip the
+			// steps after it on this tick
+			try
+			{
+				PumpAlerts();
+			}
+			catch (Exception^ ex)
+			{
+				logger->Log(ILogger::LogLevel::Error, "Failed to process alerts: " + ex->Message);
+			}
 
-		static TorrentInfo^ CreateTorrentInfo(const libtorrent::torrent_handle& handle)
-		{
-			TorrentId^ torrentId = InfoHashToTorrentId(handle.info_hashes());
-			const auto& status = handle.status();
-			auto name = gcnew String(status.name.c_str());
-			auto savePath = gcnew String(status.save_path.c_str());
-			TorrentStatus^ managedStatus = CreateTorrentStatus(status, torrentId);
-			UInt64 totalSize = 0;
+			try
+			{
+				PublishStreamMetrics();
+			}
+			catch (Exception^ ex)
+			{
+				logger->Log(ILogger::LogLevel::Error, "Failed to publish stream metrics: " + ex->Message);
+			}
 
-			List<TorrentFileEntry^>^ fileEntries;
-			if (handle.torrent_file())
+			RebalanceBandwidthGroups();
+
+			try
+			{
+				PublishRecheckProgress();
+			}
+			catch (Exception^ ex)
 			{
-				fileEntries = gcnew List<TorrentFileEntry^>(handle.torrent_file()->num_files());
+				logger->Log(ILogger::LogLevel::Error, "Failed to publish recheck progress: " + ex->Message);
+			}
 
-				for (const auto& torrentFile = handle.torrent_file(); const auto& index : torrentFile->files().file_range())
-				{
-					const auto& path = gcnew String(torrentFile->files().file_path(index, status.save_path).c_str());
-					const auto& filename = gcnew String(torrentFile->files().file_name(index).to_string().c_str());
-					const auto& size = torrentFile->files().file_size(index);
+			EnforceMemoryBudget();
+		}
 
-					fileEntries->Add(gcnew TorrentFileEntry(static_cast<int>(index), path, filename, size));
-				}
+		void RebalanceBandwidthGroups()
+		{
+			EnterReadLock();
+			try
+			{
+				bandwidthGroups->Rebalance(nativeSession, streamingScheduler);
+			}
+			finally
+			{
+				lock->ExitReadLock();
+			}
+		}
 
-				totalSize = handle.torrent_file()->total_size();
+		void PublishRecheckProgress()
+		{
+			RecheckProgressEventArgs^ progress;
+			EnterReadLock();
+			try
+			{
+				progress = recheckScheduler->Update(nativeSession);
 			}
-			else
+			finally
 			{
-				fileEntries = gcnew List<TorrentFileEntry^>(0);
+				lock->ExitReadLock();
 			}
 
-			return gcnew TorrentInfo(torrentId, name, managedStatus, fileEntries, totalSize, savePath);
+			if (progress != nullptr)
+			{
+				RecheckProgressUpdated(this, progress);
+			}
 		}
 
-		void OnAlertTimerElapsed(Object^ sender, ElapsedEventArgs^ e)
+		void EnforceMemoryBudget()
 		{
-			if (!isListeningToAlerts)
+			if (!memoryBudget->IsEnabled)
 			{
 				return;
 			}
 
-			nativeSession->post_torrent_updates();
-
-			std::vector<libtorrent::alert*> alerts;
+			auto streams = GetOpenStreams();
 
-			lock->EnterReadLock();
+			EnterReadLock();
 			try
 			{
-				nativeSession->pop_alerts(&alerts);
+				memoryBudget->Enforce(nativeSession, streams);
 			}
 			finally
 			{
 				lock->ExitReadLock();
 			}
+		}
 
-			for (libtorrent::alert* alert : alerts)
+		/// <summary>
+		/// Pumps the alerts on the thread pool rather than on the caller's thread. Streams waiting for a read_piece
+		/// alert call this from their reader, which must not run event handlers or see their exceptions.
+		/// </summary>
+		void QueueAlertPump()
+		{
+			if (Interlocked::CompareExchange(isAlertPumpQueued, 1, 0) == 0)
 			{
-				ProcessAlert(alert);
+				ThreadPool::QueueUserWorkItem(gcnew WaitCallback(this, &TorrentSession::PumpQueuedAlerts));
 			}
 		}
 
-		void ProcessAlert(libtorrent::alert* alert)
+		void PumpQueuedAlerts(Object^ state)
 		{
+			// Cleared first, so a stream that asks again while this pump runs gets another one
+			Interlocked::Exchange(isAlertPumpQueued, 0);
 			try
 			{
-				if (const auto* addAlert = libtorrent::alert_cast<libtorrent::add_torrent_alert>(alert))
-				{
-					TorrentId^ torrentId = InfoHashToTorrentId(addAlert->handle.info_hashes());
-					TorrentOperationChanged(
-						this, gcnew TorrentOperationEventArgs(torrentId, TorrentOperationEvent::Added));
-				}
-				else if (const auto* finishAlert = libtorrent::alert_cast<libtorrent::torrent_finished_alert>(alert))
-				{
-					TorrentId^ torrentId = InfoHashToTorrentId(finishAlert->handle.info_hashes());
-					TorrentOperationChanged(
-						this, gcnew TorrentOperationEventArgs(torrentId, TorrentOperationEvent::Finished));
-				}
-				else if (const auto* removeAlert = libtorrent::alert_cast<libtorrent::torrent_removed_alert>(alert))
-				{
-					TorrentId^ torrentId = InfoHashToTorrentId(removeAlert->handle.info_hashes());
-					TorrentOperationChanged(
-						this, gcnew TorrentOperationEventArgs(torrentId, TorrentOperationEvent::Removed));
-				}
-				else if (const auto* errorAlert = libtorrent::alert_cast<libtorrent::torrent_error_alert>(alert))
+				PumpAlerts();
+			}
+			catch (Exception^ ex)
+			{
+				logger->Log(ILogger::LogLevel::Error, "Failed to process alerts: " + ex->Message);
+			}
+		}
+
+		void PumpAlerts()
+		{
+			// Only one caller may pop at a time, and a pump from inside an event handler must not free the batch that is
+			// still being processed.
+			if (!isListeningToAlerts || isPumpingAlerts || !Monitor::TryEnter(alertPumpSync))
+			{
+				return;
+			}
+
+			try
+			{
+				isPumpingAlerts = true;
+				std::vector<libtorrent::alert*> alerts;
+
+				EnterReadLock();
+				try
 				{
-					TorrentId^ torrentId = InfoHashToTorrentId(errorAlert->handle.info_hashes());
-					TorrentError(
-						this, gcnew TorrentErrorEventArgs(
-							torrentId, gcnew String(errorAlert->error.message().c_str())));
+					nativeSession->pop_alerts(&alerts);
 				}
-				else if (const auto* pauseAlert = libtorrent::alert_cast<libtorrent::torrent_paused_alert>(alert))
+				finally
 				{
-					TorrentId^ torrentId = InfoHashToTorrentId(pauseAlert->handle.info_hashes());
-					TorrentOperationChanged(
-						this, gcnew TorrentOperationEventArgs(torrentId, TorrentOperationEvent::Paused));
+					lock->ExitReadLock();
 				}
-				else if (const auto* resumeAlert = libtorrent::alert_cast<libtorrent::torrent_resumed_alert>(alert))
+
+				for (libtorrent::alert* alert : alerts)
 				{
-					TorrentId^ torrentId = InfoHashToTorrentId(resumeAlert->handle.info_hashes());
-					TorrentOperationChanged(
-						this, gcnew TorrentOperationEventArgs(torrentId, TorrentOperationEvent::Resumed));
+					ProcessAlert(alert);
 				}
-				else if (const auto* stateAlert = libtorrent::alert_cast<libtorrent::state_update_alert>(alert))
-				{
-					auto torrentStats = gcnew List<TorrentStatus^>(static_cast<long>(stateAlert->status.size()));
+			}
+			finally
+			{
+				isPumpingAlerts = false;
+				Monitor::Exit(alertPumpSync);
+			}
+		}
 
-					for (const auto& status : stateAlert->status)
-					{
-						TorrentId^ torrentId = InfoHashToTorrentId(status.info_hashes);
-						torrentStats->Add(CreateTorrentStatus(status, torrentId));
-					}
+		void RaiseTorrentOperation(const libtorrent::alert* alert, const libtorrent::torrent_handle& handle,
+			const TorrentOperationEvent operationEvent)
+		{
+			TorrentId^ torrentId = TorrentId::FromInfoHash(handle.info_hashes());
+			if (alertTrace != nullptr)
+			{
+				alertTrace->WriteOperation(alert->type(), torrentId, operationEvent);
+			}
+			TorrentOperationChanged(this, gcnew TorrentOperationEventArgs(torrentId, operationEvent));
+		}
 
-					TorrentStateUpdated(this, gcnew TorrentStateUpdateEventArgs(torrentStats));
+		bool DispatchTracedAlert(AlertTraceRecord^ record)
+		{
+			switch (record->Kind)
+			{
+			case AlertTraceKind::Operation:
+				TorrentOperationChanged(this, gcnew TorrentOperationEventArgs(record->Id, record->OperationEvent));
+				return true;
+			case AlertTraceKind::Error:
+				TorrentError(this, gcnew TorrentErrorEventArgs(record->Id, record->Error));
+				return true;
+			case AlertTraceKind::StateUpdate:
+				TorrentStateUpdated(this, gcnew TorrentStateUpdateEventArgs(record->Statuses));
+				return true;
+			case AlertTraceKind::MetadataReceived:
+				TorrentMetadataReceived(this, gcnew TorrentMetadataEventArgs(record->Info));
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		static void WaitUntil(Diagnostics::Stopwatch^ clock, const TimeSpan target)
+		{
+			// Sleep through long gaps and spin through short ones, since a sleep can overshoot by a timer tick
+			for (auto remaining = target - clock->Elapsed; remaining > TimeSpan::Zero; remaining = target - clock->Elapsed)
+			{
+				if (remaining > TimeSpan::FromMilliseconds(15))
+				{
+					Thread::Sleep(remaining - TimeSpan::FromMilliseconds(15));
 				}
-				else if (const auto* metadataAlert = libtorrent::alert_cast<libtorrent::metadata_received_alert>(alert))
+				else
 				{
-					if (metadataAlert->handle.is_valid())
-					{
-						const auto torrentInfo = CreateTorrentInfo(metadataAlert->handle);
-						TorrentMetadataReceived(this, gcnew TorrentMetadataEventArgs(torrentInfo));
-					}
+					Thread::SpinWait(100);
 				}
 			}
-			catch (const std::exception& e)
-			{
-				auto message = String::Format("Error when processing alert: {0}", gcnew String(e.what()));
-				logger->Log(ILogger::LogLevel::Error, message);
-				throw gcnew TorrentException(message);
-			}
 		}
 	};
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "Optional.h"
+#include "SessionSettings.h"
 using namespace System;
 
 namespace LibtorrentDotNet
@@ -40,6 +41,35 @@ namespace LibtorrentDotNet
         HttpPassword
     };
 
+    /// <summary>
+    /// Represents where a session stores the data of its torrents.
+    /// </summary>
+    public enum class DiskIoBackend
+    {
+        /// <summary>
+        /// libtorrent's default backend for the platform.
+        /// </summary>
+        Default,
+
+        /// <summary>
+        /// Files are memory mapped and written through the operating system's page cache.
+        /// </summary>
+        MemoryMapped,
+
+        /// <summary>
+        /// Files are read and written with plain file I/O calls. This can behave better than memory mapping when the
+        /// data set is much larger than the page cache, e.g. when seeding a large library.
+        /// </summary>
+        Posix,
+
+        /// <summary>
+        /// Torrent data is only kept in memory and never written to disk; it is lost when a torrent is removed or the
+        /// session is closed. Intended for ephemeral streaming and benchmarks. The memory used grows with the amount
+        /// of data downloaded, and streams must use <see cref="TorrentStreamReadBackend::Libtorrent"/>.
+        /// </summary>
+        Memory
+    };
+
     /// <summary>
     /// Represents the configuration for a proxy server.
     /// </summary>
@@ -142,6 +172,161 @@ namespace LibtorrentDotNet
         }
     };
 
+    /// <summary>
+    /// Represents the configuration for queueing auto managed torrents, which keeps only a limited number of them
+    /// active at a time.
+    /// </summary>
+    public ref class QueueConfig sealed
+    {
+    public:
+        /// <summary>
+        /// Gets or sets the maximum number of auto managed torrents downloading at a time. Use -1 for unlimited.
+        /// </summary>
+        property Optional<int>^ ActiveDownloads;
+
+        /// <summary>
+        /// Gets or sets the maximum number of auto managed torrents seeding at a time. Use -1 for unlimited.
+        /// </summary>
+        property Optional<int>^ ActiveSeeds;
+
+        /// <summary>
+        /// Gets or sets the maximum number of auto managed torrents active at a time, downloading and seeding
+        /// combined. Use -1 for unlimited.
+        /// </summary>
+        property Optional<int>^ ActiveLimit;
+
+        /// <summary>
+        /// Gets or sets the maximum number of torrents checking their files at a time.
+        /// </summary>
+        property Optional<int>^ ActiveChecking;
+
+        /// <summary>
+        /// Gets or sets whether torrents that barely transfer anything are left out of the active limits, so that
+        /// stalled torrents do not hold on to slots.
+        /// </summary>
+        property Optional<bool>^ DontCountSlowTorrents;
+
+        /// <summary>
+        /// Initializes a new instance of the QueueConfig class with default values.
+        /// </summary>
+        QueueConfig()
+        {
+            ActiveDownloads = Optional<int>::None();
+            ActiveSeeds = Optional<int>::None();
+            ActiveLimit = Optional<int>::None();
+            ActiveChecking = Optional<int>::None();
+            DontCountSlowTorrents = Optional<bool>::None();
+        }
+    };
+
+    /// <summary>
+    /// Represents the configuration for sampling libtorrent's session performance counters.
+    /// </summary>
+    public ref class SessionStatsConfig sealed
+    {
+    public:
+        /// <summary>
+        /// Gets or sets whether the session samples its performance counters. The default is false.
+        /// </summary>
+        property Optional<bool>^ Enabled;
+
+        /// <summary>
+        /// Gets or sets how often the counters are sampled. Samples are taken on the event timer, so the interval
+        /// is rounded up to a multiple of its interval. The default is 5 seconds.
+        /// </summary>
+        property Optional<TimeSpan>^ SamplingInterval;
+
+        /// <summary>
+        /// Initializes a new instance of the SessionStatsConfig class with default values.
+        /// </summary>
+        SessionStatsConfig()
+        {
+            Enabled = Optional<bool>::None();
+            SamplingInterval = Optional<TimeSpan>::None();
+        }
+    };
+
+    /// <summary>
+    /// Represents the configuration for keeping the memory of the session under a budget.
+    /// </summary>
+    public ref class MemoryBudgetConfig sealed
+    {
+    public:
+        /// <summary>
+        /// Gets or sets the number of bytes the session may use. An estimate of the statuses and infos the session
+        /// builds for its torrents counts against it, and the rest is shared between libtorrent's disk write queue, the send buffers of its peers, its alert queue and the
+        /// buffers of open streams, which are resized as the load changes. While a budget is set, the session owns
+        /// the max_queued_disk_bytes, send_buffer_watermark and alert_queue_size settings. Each buffer keeps a
+        /// minimum size, so a very small budget can be exceeded; the session logs a warning and the memory report
+        /// shows it when that happens. Memory the rest of the process allocates does not count. By default there is
+        /// no budget.
+        /// </summary>
+        property Optional<Int64>^ MaxBytes;
+
+        /// <summary>
+        /// Initializes a new instance of the MemoryBudgetConfig class with default values.
+        /// </summary>
+        MemoryBudgetConfig()
+        {
+            MaxBytes = Optional<Int64>::None();
+        }
+    };
+
+    /// <summary>
+    /// Represents the configuration for giving open streams priority over the other torrents of the session.
+    /// </summary>
+    public ref class StreamingSchedulerConfig sealed
+    {
+    public:
+        /// <summary>
+        /// Gets or sets whether torrents without an open stream are throttled while a stream is running low on data.
+        /// The default is false.
+        /// </summary>
+        property Optional<bool>^ Enabled;
+
+        /// <summary>
+        /// Gets or sets whether torrents without an open stream are paused instead of rate limited. The default is false.
+        /// </summary>
+        property Optional<bool>^ PauseBackgroundTorrents;
+
+        /// <summary>
+        /// Gets or sets the download rate limit, in bytes per second, of torrents without an open stream while throttled.
+        /// The default is 32 KB/s.
+        /// </summary>
+        property Optional<int>^ BackgroundDownloadRateLimit;
+
+        /// <summary>
+        /// Gets or sets the maximum number of connections of torrents without an open stream while throttled.
+        /// The default is 4.
+        /// </summary>
+        property Optional<int>^ BackgroundMaxConnections;
+
+        /// <summary>
+        /// Gets or sets how little playback a stream may have buffered before the other torrents are throttled.
+        /// The default is 5 seconds.
+        /// </summary>
+        property Optional<TimeSpan>^ LowBufferThreshold;
+
+        /// <summary>
+        /// Gets or sets how much playback every stream needs to have buffered before the other torrents are restored.
+        /// The default is 20 seconds.
+        /// </summary>
+        property Optional<TimeSpan>^ HealthyBufferThreshold;
+
+        /// <summary>
+        /// Initializes a new instance of the StreamingSchedulerConfig class with default values.
+        /// </summary>
+        StreamingSchedulerConfig()
+        {
+            Enabled = Optional<bool>::None();
+            PauseBackgroundTorrents = Optional<bool>::None();
+            BackgroundDownloadRateLimit = Optional<int>::None();
+            BackgroundMaxConnections = Optional<int>::None();
+            LowBufferThreshold = Optional<TimeSpan>::None();
+            HealthyBufferThreshold = Optional<TimeSpan>::None();
+        }
+    };
+
     /// <summary>
     /// Represents the configuration for a torrent session.
     /// </summary>
@@ -173,6 +358,44 @@ namespace LibtorrentDotNet
         /// </summary>
         property DhtConfig^ DhtSettings;
 
+        /// <summary>
+        /// Gets or sets the settings that give open streams priority over the other torrents of the session.
+        /// </summary>
+        property StreamingSchedulerConfig^ StreamingSettings;
+
+        /// <summary>
+        /// Gets or sets the settings that limit how many auto managed torrents are active at a time.
+        /// </summary>
+        property QueueConfig^ QueueSettings;
+
+        /// <summary>
+        /// Gets or sets the settings for sampling the session's performance counters. They are only read when the
+        /// session is created.
+        /// </summary>
+        property SessionStatsConfig^ StatsSettings;
+
+        /// <summary>
+        /// Gets or sets whether the session records latency histograms of its methods and alert handlers, which
+        /// can be read with GetLatencyReport. It is only read when the session is created. The default is false.
+        /// </summary>
+        property Optional<bool>^ EnableLatencyTracking;
+
+        /// <summary>
+        /// Gets or sets the memory budget of the session. It is only read when the session is created.
+        /// </summary>
+        property MemoryBudgetConfig^ MemoryBudget;
+
+        /// <summary>
+        /// Gets or sets the performance tuning settings, applied before the other settings of this configuration.
+        /// </summary>
+        property SessionSettings^ AdvancedSettings;
+
+        /// <summary>
+        /// Gets or sets where the session stores torrent data. The default is <see cref="DiskIoBackend::Default"/>.
+        /// The backend is chosen when the session is created and cannot be changed with UpdateSettings.
+        /// </summary>
+        property DiskIoBackend DiskBackend;
+
         /// <summary>
         /// Gets or sets whether UPnP is enabled.
         /// </summary>
@@ -198,6 +421,13 @@ namespace LibtorrentDotNet
             ProxySettings = gcnew ProxyConfig();
             BandwidthSettings = gcnew BandwidthConfig();
             DhtSettings = gcnew DhtConfig();
+            StreamingSettings = gcnew StreamingSchedulerConfig();
+            QueueSettings = gcnew QueueConfig();
+            StatsSettings = gcnew SessionStatsConfig();
+            EnableLatencyTracking = Optional<bool>::None();
+            MemoryBudget = gcnew MemoryBudgetConfig();
+            AdvancedSettings = gcnew SessionSettings();
+            DiskBackend = DiskIoBackend::Default;
             EnableUpnp = Optional<bool>::None();
             EnableNatPmp = Optional<bool>::None();
             EnableLsd = Optional<bool>::None();
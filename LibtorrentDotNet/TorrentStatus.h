@@ -41,7 +41,43 @@ namespace LibtorrentDotNet
 			downloadRate(downloadRate),
 			uploadRate(uploadRate),
 			numPeers(numPeers),
-			numSeeds(numSeeds) {}
+			numSeeds(numSeeds),
+			queuePosition(-1) {}
+
+		/// <summary>
+		/// Initializes a new instance of the TorrentStatus class.
+		/// </summary>
+		/// <param name="torrentId">The unique identifier of the torrent.</param>
+		/// <param name="state">The current state of the torrent.</param>
+		/// <param name="progress">The download progress of the torrent (0.0 to 1.0).</param>
+		/// <param name="totalDownload">The total number of bytes downloaded.</param>
+		/// <param name="totalUpload">The total number of bytes uploaded.</param>
+		/// <param name="downloadRate">The current download rate in bytes per second.</param>
+		/// <param name="uploadRate">The current upload rate in bytes per second.</param>
+		/// <param name="numPeers">The number of peers connected to.</param>
+		/// <param name="numSeeds">The number of seeds connected to.</param>
+		/// <param name="queuePosition">The position of the torrent in the download queue, or -1 if it is not queued.</param>
+		TorrentStatus(
+			TorrentId^ torrentId,
+			const TorrentState state,
+			const double progress,
+			const Int64 totalDownload,
+			const Int64 totalUpload,
+			const int downloadRate,
+			const int uploadRate,
+			const int numPeers,
+			const int numSeeds,
+			const int queuePosition) :
+			torrentId(torrentId),
+			state(state),
+			progress(progress),
+			totalDownload(totalDownload),
+			totalUpload(totalUpload),
+			downloadRate(downloadRate),
+			uploadRate(uploadRate),
+			numPeers(numPeers),
+			numSeeds(numSeeds),
+			queuePosition(queuePosition) {}
 
 		/// <summary>
 		/// Gets the unique identifier of the torrent.
@@ -88,6 +124,12 @@ namespace LibtorrentDotNet
 		/// </summary>
 		property int NumSeeds { int get() { return numSeeds; } }
 
+		/// <summary>
+		/// Gets the position of the torrent in the download queue, where 0 is the first in line, or -1 if the torrent
+		/// is not queued, e.g. because it is seeding.
+		/// </summary>
+		property int QueuePosition { int get() { return queuePosition; } }
+
 	private:
 		TorrentId^ torrentId;
 		TorrentState state;
@@ -98,5 +140,6 @@ namespace LibtorrentDotNet
 		int uploadRate;
 		int numPeers;
 		int numSeeds;
+		int queuePosition;
 	};
 }
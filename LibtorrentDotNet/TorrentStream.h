@@ -6,21 +6,51 @@
 #include <libtorrent/session.hpp>
 #include <libtorrent/torrent_info.hpp>
 #include <libtorrent/torrent_status.hpp>
+#include <utility>
+#include <vector>
 #pragma managed(pop)
 
 #include <msclr/marshal_cppstd.h>
+#include "MediaIndexProbe.h"
+#include "PieceReader.h"
+#include "PieceWindowManager.h"
+#include "ReadAheadController.h"
+#include "TorrentStreamMetrics.h"
+#include "TorrentStreamOptions.h"
 
 using namespace System;
 using namespace System::Threading;
+using namespace System::Collections::Generic;
 using namespace System::IO;
 using namespace msclr::interop;
 using namespace System::Runtime::InteropServices;
 
 namespace LibtorrentDotNet
 {
+	/// <summary>
+	/// Maps a contiguous part of a stream onto the torrent's byte space.
+	/// </summary>
+	value struct StreamSegment
+	{
+		Int64 LogicalStart;
+		Int64 TorrentOffset;
+		Int64 Length;
+	};
+
+	/// <summary>
+	/// Tracks when a piece entered a stream's window and when its deadline is due.
+	/// </summary>
+	value struct PieceRequest
+	{
+		DateTime RequestedAt;
+		DateTime DueAt;
+		bool Missed;
+	};
+
 	/// <summary>
 	/// Provides a Stream implementation for reading torrent files while they are being downloaded.
 	/// This class enables streaming of media files before the complete download has finished.
+	/// A stream may also span several files, or the whole torrent, which are then read back to back.
 	/// </summary>
 	public ref class TorrentStream sealed : public Stream, IDisposable
 	{
@@ -31,9 +61,12 @@ namespace LibtorrentDotNet
 		static initonly Int32 MaxWaitTimeMs = 10000;
 		static initonly Int32 CheckIntervalMs = 50;
 		static initonly Int32 InitialPiecesToPrioritize = 30;
-		static initonly Int32 MinReadAheadPieces = 10;
-		static initonly Int32 MaxReadAheadPieces = 30;
-		static initonly double ReadRateSmoothing = 0.3;
+		static initonly Int32 SwarmSampleIntervalMs = 500;
+		static initonly Int32 DefaultTargetBufferSeconds = 10;
+		static initonly Int64 DefaultMaxReadAheadBytes = 128 * 1024 * 1024;
+		static initonly Int32 MediaHeaderProbeBytes = 256 * 1024;
+		static initonly Int32 MaxMediaIndexBytes = 64 * 1024 * 1024;
+		static initonly Int32 MediaIndexChunkBytes = 1024 * 1024;
 
 		const libtorrent::torrent_handle* torrentHandle;
 		const TimeSpan readTimeout;
@@ -42,15 +75,36 @@ namespace LibtorrentDotNet
 		Object^ syncRoot;
 		bool disposed;
 		Int32 pieceLength;
-		Int32 totalPieces;
+		array<StreamSegment>^ segments;
+		PieceReader^ pieceReader;
+		PieceWindowManager^ windowManager;
+		Object^ mediaIndexReservation;
 		FileStream^ fileStream;
+		bool directRead;
+		bool probeMediaIndex;
+		MediaIndex^ mediaIndex;
+		bool isParsingMediaIndex;
 		array<Byte>^ buffer;
 		int64_t bufferStart;
 		Int32 bufferLength;
-		double averageReadRate;
-		DateTime lastReadTime;
-		int64_t lastReadPosition;
-		int lastPrioritizedPiece;
+		Int32 maxBufferSize;
+		Int32 fileStreamBufferSize;
+		ReadAheadController^ readAhead;
+		DateTime lastSwarmSample;
+		Dictionary<int, PieceRequest>^ pieceRequests;
+		HashSet<int>^ windowPieces;
+		int windowStartPiece;
+		int windowEndPiece;
+		DateTime openedAt;
+		TimeSpan timeToFirstByte;
+		bool hasFirstByte;
+		bool isStalled;
+		DateTime stallStart;
+		int stallCount;
+		TimeSpan totalStallDuration;
+		int deadlineMisses;
+		Object^ metricsSyncRoot;
+		Action<TorrentStream^>^ closedCallback;
 
 		TorrentStream(const libtorrent::torrent_handle* torrentHandleParam, TimeSpan readTimeoutParam) :
 			torrentHandle(torrentHandleParam),
@@ -58,28 +112,66 @@ namespace LibtorrentDotNet
 			position(0),
 			syncRoot(gcnew Object()),
 			disposed(false),
+			pieceReader(nullptr),
+			windowManager(nullptr),
+			mediaIndexReservation(gcnew Object()),
+			fileStream(nullptr),
+			directRead(true),
+			probeMediaIndex(false),
+			mediaIndex(nullptr),
+			isParsingMediaIndex(false),
 			buffer(nullptr),
 			bufferStart(0),
 			bufferLength(0),
-			averageReadRate(0),
-			lastPrioritizedPiece(-1),
-			lastReadTime(DateTime::Now),
-			lastReadPosition(0)
+			maxBufferSize(DynamicBufferSize),
+			fileStreamBufferSize(0),
+			readAhead(nullptr),
+			lastSwarmSample(DateTime::MinValue),
+			pieceRequests(gcnew Dictionary<int, PieceRequest>()),
+			windowPieces(gcnew HashSet<int>()),
+			windowStartPiece(-1),
+			windowEndPiece(-1),
+			openedAt(DateTime::Now),
+			hasFirstByte(false),
+			isStalled(false),
+			stallCount(0),
+			deadlineMisses(0),
+			metricsSyncRoot(gcnew Object()),
+			closedCallback(nullptr)
 		{
 		}
 
 	internal:
 		/// <summary>
-		/// Creates a new instance of TorrentStream for the specified torrent handle and file index.
+		/// Creates a new instance of TorrentStream that reads the specified files of a torrent back to back, as one
+		/// continuous stream.
 		/// </summary>
+		/// <param name="fileIndices">The files to stream, in the order they appear in the stream.</param>
+		/// <param name="options">The options controlling how the stream reads and buffers data.</param>
+		/// <param name="pieceReader">
+		/// The reader used to read pieces through libtorrent, or null to read the file from the save path.
+		/// The stream takes ownership of the reader and closes it when disposed.
+		/// </param>
+		/// <param name="windowManager">
+		/// The manager that merges this stream's piece window with those of other streams on the same torrent.
+		/// The stream must already be attached to it and detaches when disposed.
+		/// </param>
+		/// <param name="bufferSize">The size of the read-ahead buffer, at most 8 MB, as set by the memory budget.</param>
 		static TorrentStream^ Create(const libtorrent::torrent_handle* torrentHandle,
-			const libtorrent::file_index_t& fileIndex, TimeSpan readTimeout)
+			const std::vector<libtorrent::file_index_t>& fileIndices, TimeSpan readTimeout, TorrentStreamOptions^ options,
+			PieceReader^ pieceReader, PieceWindowManager^ windowManager, const Int32 bufferSize)
 		{
 			if (!torrentHandle)
 			{
 				throw gcnew ArgumentNullException("torrentHandle");
 			}
 
+			if (windowManager == nullptr)
+			{
+				throw gcnew ArgumentNullException("windowManager");
+			}
+
+			TorrentStream^ stream = nullptr;
 			try
 			{
 				const auto& torrentInfo = torrentHandle->torrent_file();
@@ -89,61 +181,180 @@ namespace LibtorrentDotNet
 				}
 
 				const auto& fileStorage = torrentInfo->files();
-				if (fileIndex.operator int() < 0 || fileIndex.operator int() >= fileStorage.num_files())
+				if (fileIndices.empty())
 				{
-					throw gcnew ArgumentOutOfRangeException("fileIndex", "File index is out of range");
+					throw gcnew ArgumentException("At least one file index is required", "fileIndices");
 				}
 
-				const std::string& filePath = torrentHandle->status().save_path + "/" + fileStorage.file_path(
-					libtorrent::file_index_t(fileIndex));
+				for (const auto& fileIndex : fileIndices)
+				{
+					if (fileIndex.operator int() < 0 || fileIndex.operator int() >= fileStorage.num_files())
+					{
+						throw gcnew ArgumentOutOfRangeException("fileIndices", "File index is out of range");
+					}
+				}
+
+				if (options->TargetBufferDuration->HasValue && options->TargetBufferDuration->Value <= TimeSpan::Zero)
+				{
+					throw gcnew ArgumentOutOfRangeException("options", options->TargetBufferDuration->Value,
+						"The target buffer duration must be positive.");
+				}
+				if (options->MaxReadAheadBytes->HasValue && options->MaxReadAheadBytes->Value <= 0)
+				{
+					throw gcnew ArgumentOutOfRangeException("options", options->MaxReadAheadBytes->Value,
+						"The maximum read-ahead must be positive.");
+				}
+
+				// The probe reads offsets within one file, which a stream of several files does not map to
+				if (options->ProbeMediaIndex && fileIndices.size() != 1)
+				{
+					throw gcnew ArgumentException("Probing the media index needs a stream of a single file", "options");
+				}
 
-				if (!File::Exists(gcnew String(filePath.c_str())))
+				String^ filePath = nullptr;
+				if (pieceReader == nullptr)
 				{
-					throw gcnew FileNotFoundException(
-						String::Format("File not found: {0}", gcnew String(filePath.c_str())));
+					// Reading from the save path goes through a single FileStream
+					if (fileIndices.size() != 1)
+					{
+						throw gcnew ArgumentException("A stream spanning several files has to read through libtorrent",
+							"options");
+					}
+
+					filePath = gcnew String((torrentHandle->status().save_path + "/" +
+						fileStorage.file_path(fileIndices.front())).c_str());
+
+					if (!File::Exists(filePath))
+					{
+						throw gcnew FileNotFoundException(String::Format("File not found: {0}", filePath));
+					}
 				}
 
-				auto stream = gcnew TorrentStream(torrentHandle, readTimeout);
+				stream = gcnew TorrentStream(torrentHandle, readTimeout);
 
 				stream->pieceLength = torrentInfo->piece_length();
-				stream->totalPieces = torrentInfo->num_pieces();
-				stream->length = fileStorage.file_size(libtorrent::file_index_t(fileIndex));
+				stream->segments = CreateSegments(fileStorage, fileIndices);
+				stream->length = 0;
+				for each (StreamSegment segment in stream->segments)
+				{
+					stream->length += segment.Length;
+				}
+				stream->pieceReader = pieceReader;
+				stream->windowManager = windowManager;
+				stream->readAhead = gcnew ReadAheadController(stream->pieceLength,
+					options->TargetBufferDuration->GetValueOrDefault(TimeSpan::FromSeconds(DefaultTargetBufferSeconds)),
+					options->MaxReadAheadBytes->GetValueOrDefault(DefaultMaxReadAheadBytes));
+				stream->directRead = options->DirectRead;
+				stream->probeMediaIndex = options->ProbeMediaIndex;
+				stream->maxBufferSize = Math::Min(bufferSize, DynamicBufferSize);
 
 				torrentHandle->set_flags(libtorrent::torrent_flags::sequential_download);
 
-				const auto& firstPiece = fileStorage.map_file(libtorrent::file_index_t(fileIndex), 0, 1);
-				const auto& lastPiece = fileStorage.
-					map_file(libtorrent::file_index_t(fileIndex), stream->length - 1, 1);
+				auto initialPieces = stream->PiecesInRange(0,
+					static_cast<int64_t>(InitialPiecesToPrioritize) * stream->pieceLength);
+
+				std::vector<std::pair<libtorrent::piece_index_t, libtorrent::download_priority_t>> priorities;
+				std::vector<std::pair<libtorrent::piece_index_t, int>> deadlines;
+				priorities.reserve(initialPieces->Count);
+				deadlines.reserve(initialPieces->Count);
 
-				int piecesToPrioritize = Math::Min(
-					lastPiece.piece.operator int() - firstPiece.piece.operator int() + 1,
-					InitialPiecesToPrioritize);
+				const auto requestTime = DateTime::Now;
+				for (int i = 0; i < initialPieces->Count; ++i)
+				{
+					const auto piece = libtorrent::piece_index_t(initialPieces[i]);
+					priorities.emplace_back(piece, libtorrent::top_priority);
+					deadlines.emplace_back(piece, i * 50);
+					stream->pieceRequests[initialPieces[i]] = CreatePieceRequest(requestTime, i * 50);
+				}
 
-				for (int i = 0; i < piecesToPrioritize; ++i)
+				windowManager->Reserve(stream, priorities, deadlines);
+				if (initialPieces->Count > 0)
 				{
-					torrentHandle->piece_priority(libtorrent::piece_index_t(firstPiece.piece.operator int() + i),
-						libtorrent::top_priority);
-					torrentHandle->set_piece_deadline(libtorrent::piece_index_t(firstPiece.piece.operator int() + i),
-						i * 50);
+					stream->windowPieces->UnionWith(initialPieces);
+					stream->windowStartPiece = initialPieces[0];
+					stream->windowEndPiece = initialPieces[initialPieces->Count - 1];
 				}
 
-				stream->fileStream = gcnew FileStream(
-					gcnew String(filePath.c_str()),
-					FileMode::Open,
-					FileAccess::Read,
-					FileShare::ReadWrite,
-					MinBufferSize);
+				if (pieceReader == nullptr)
+				{
+					stream->fileStreamBufferSize = Math::Min(MinBufferSize, stream->maxBufferSize);
+					stream->fileStream = gcnew FileStream(
+						filePath,
+						FileMode::Open,
+						FileAccess::Read,
+						FileShare::ReadWrite,
+						stream->fileStreamBufferSize);
+				}
 
-				stream->buffer = gcnew array<Byte>(DynamicBufferSize);
+				// The header pieces may already be there, e.g. when streaming a file that is partially downloaded
+				stream->UpdateMediaIndex();
 
 				return stream;
 			}
 			catch (Exception^ ex)
 			{
+				if (pieceReader != nullptr)
+				{
+					pieceReader->Close();
+				}
+
+				if (stream != nullptr)
+				{
+					windowManager->Release(stream);
+					windowManager->Release(stream->mediaIndexReservation);
+				}
+				windowManager->Detach();
+
+				// Bad arguments and missing files keep their documented types so callers can tell them apart
+				if (dynamic_cast<ArgumentException^>(ex) != nullptr || dynamic_cast<IOException^>(ex) != nullptr)
+				{
+					throw;
+				}
 				throw gcnew InvalidOperationException("Failed to create TorrentStream instance", ex);
 			}
 		}
 
+		/// <summary>
+		/// Sets a callback that is invoked once when the stream is disposed.
+		/// </summary>
+		void SetClosedCallback(Action<TorrentStream^>^ callback)
+		{
+			closedCallback = callback;
+		}
+
+		/// <summary>
+		/// Gets the piece length of the streamed torrent.
+		/// </summary>
+		property Int32 PieceLength { Int32 get() { return pieceLength; } }
+
+		/// <summary>
+		/// Gets the number of bytes held by the stream's buffers and piece cache.
+		/// </summary>
+		property Int64 AllocatedBytes
+		{
+			Int64 get()
+			{
+				auto currentBuffer = buffer;
+				return (currentBuffer != nullptr ? currentBuffer->Length : 0) + fileStreamBufferSize +
+					(pieceReader != nullptr ? pieceReader->CachedBytes : 0);
+			}
+		}
+
+		/// <summary>
+		/// Resizes the stream's memory to fit the session's memory budget. A smaller read-ahead buffer takes effect
+		/// with the next fill; the piece cache is trimmed right away.
+		/// </summary>
+		/// <param name="bufferSize">The size of the read-ahead buffer, at most 8 MB.</param>
+		/// <param name="pieceCacheBytes">The most bytes the piece cache may hold.</param>
+		void LimitMemory(const Int32 bufferSize, const Int64 pieceCacheBytes)
+		{
+			maxBufferSize = Math::Min(bufferSize, DynamicBufferSize);
+			if (pieceReader != nullptr)
+			{
+				pieceReader->LimitCache(pieceCacheBytes);
+			}
+		}
+
 	public:
 		/// <summary>
 		/// Occurs when the stream starts buffering data.
@@ -180,6 +391,15 @@ namespace LibtorrentDotNet
 		/// </summary>
 		virtual property int64_t Length { int64_t get() override { return length; } }
 
+		/// <summary>
+		/// Gets the container format detected by the media index probe, or <see cref="MediaContainer::Unknown"/> if
+		/// probing is disabled, has not completed yet or did not recognize the file.
+		/// </summary>
+		property MediaContainer Container
+		{
+			MediaContainer get() { return mediaIndex != nullptr ? mediaIndex->Container : MediaContainer::Unknown; }
+		}
+
 		/// <summary>
 		/// Gets or sets the current position in the stream.
 		/// </summary>
@@ -209,6 +429,8 @@ namespace LibtorrentDotNet
 				if (position >= length)
 					return 0;
 
+				UpdateMediaIndex();
+
 				int bytesRead = 0;
 				DateTime startTime = DateTime::Now;
 				bool isCurrentlyBuffering = false;
@@ -217,18 +439,32 @@ namespace LibtorrentDotNet
 				{
 					try
 					{
-						if (!IsInBuffer(position))
+						if (!IsInBuffer(position) && directRead)
 						{
-							int currentPiece = static_cast<int>(position / pieceLength);
+							// Fully downloaded ranges go straight into the caller's buffer without staging them
+							int read = ReadDirect(outputBuffer, offset + bytesRead,
+								static_cast<int>(Math::Min(static_cast<int64_t>(count - bytesRead), length - position)));
+							if (read > 0)
+							{
+								bytesRead += read;
+								position += read;
+
+								if (position >= length) break;
+								continue;
+							}
+						}
 
+						if (!IsInBuffer(position))
+						{
 							// Start buffering if we need to wait for pieces
-							if (!VerifyPieceAvailability(currentPiece, CalculateReadAheadPieces()) && !isCurrentlyBuffering)
+							if (!VerifyPieceAvailability(position, CalculateReadAheadPieces()) && !isCurrentlyBuffering)
 							{
 								isCurrentlyBuffering = true;
+								BeginStall();
 								BufferingStarted(this, EventArgs::Empty);
 							}
 
-							while (!VerifyPieceAvailability(currentPiece, CalculateReadAheadPieces()) && DateTime::Now - startTime < readTimeout)
+							while (!VerifyPieceAvailability(position, CalculateReadAheadPieces()) && DateTime::Now - startTime < readTimeout)
 							{
 								Thread::Sleep(CheckIntervalMs);
 							}
@@ -237,6 +473,7 @@ namespace LibtorrentDotNet
 							if (isCurrentlyBuffering)
 							{
 								isCurrentlyBuffering = false;
+								EndStall();
 								BufferingCompleted(this, EventArgs::Empty);
 							}
 
@@ -246,7 +483,7 @@ namespace LibtorrentDotNet
 						int64_t bufferOffset = position - bufferStart;
 						int toRead = Math::Min(count - bytesRead, bufferLength - static_cast<int>(bufferOffset));
 
-						Array::Copy(buffer, static_cast<int>(bufferOffset), outputBuffer, offset + bytesRead, toRead);
+						Buffer::BlockCopy(buffer, static_cast<int>(bufferOffset), outputBuffer, offset + bytesRead, toRead);
 						bytesRead += toRead;
 						position += toRead;
 
@@ -259,7 +496,13 @@ namespace LibtorrentDotNet
 				}
 
 				// Update read rate for adaptive buffering
-				UpdateReadRate(bytesRead);
+				readAhead->RecordConsumption(bytesRead);
+
+				if (bytesRead > 0 && !hasFirstByte)
+				{
+					timeToFirstByte = DateTime::Now - openedAt;
+					hasFirstByte = true;
+				}
 
 				if (bytesRead == 0)
 				{
@@ -308,6 +551,8 @@ namespace LibtorrentDotNet
 				if (position < 0 || position > length)
 					throw gcnew ArgumentOutOfRangeException("Offset is out of range.");
 
+				PrefetchFromKeyframe();
+
 				return position;
 
 			}
@@ -340,6 +585,43 @@ namespace LibtorrentDotNet
 		{
 		}
 
+		/// <summary>
+		/// Gets a snapshot of the stream's playback health. Safe to call from any thread, also while a read is waiting.
+		/// </summary>
+		/// <returns>The current metrics of the stream.</returns>
+		TorrentStreamMetrics^ GetMetrics()
+		{
+			Monitor::Enter(metricsSyncRoot);
+			try
+			{
+				if (disposed)
+				{
+					throw gcnew ObjectDisposedException("TorrentStream");
+				}
+
+				const auto now = DateTime::Now;
+				const Int64 bufferedBytes = CountBufferedBytes();
+
+				return gcnew TorrentStreamMetrics(
+					windowManager->Id,
+					position,
+					length,
+					hasFirstByte ? Optional<TimeSpan>::Some(timeToFirstByte) : Optional<TimeSpan>::None(),
+					stallCount,
+					isStalled ? totalStallDuration + (now - stallStart) : totalStallDuration,
+					isStalled,
+					bufferedBytes,
+					readAhead->BufferedSeconds(bufferedBytes),
+					deadlineMisses,
+					readAhead->ConsumerRate,
+					readAhead->DownloadRate);
+			}
+			finally
+			{
+				Monitor::Exit(metricsSyncRoot);
+			}
+		}
+
 	protected:
 		!TorrentStream()
 		{
@@ -352,97 +634,566 @@ namespace LibtorrentDotNet
 		}
 
 	private:
-		void UpdateReadRate(int bytesRead)
+		static PieceRequest CreatePieceRequest(DateTime requestTime, int deadlineMs)
 		{
-			auto currentTime = DateTime::Now;
-			auto elapsed = (currentTime - lastReadTime).TotalSeconds;
-			if (elapsed > 0)
+			PieceRequest request;
+			request.RequestedAt = requestTime;
+			request.DueAt = requestTime.AddMilliseconds(deadlineMs);
+			request.Missed = false;
+			return request;
+		}
+
+		void BeginStall()
+		{
+			Monitor::Enter(metricsSyncRoot);
+			try
+			{
+				isStalled = true;
+				stallStart = DateTime::Now;
+			}
+			finally
+			{
+				Monitor::Exit(metricsSyncRoot);
+			}
+		}
+
+		void EndStall()
+		{
+			Monitor::Enter(metricsSyncRoot);
+			try
+			{
+				if (isStalled)
+				{
+					isStalled = false;
+					stallCount++;
+					totalStallDuration = totalStallDuration + (DateTime::Now - stallStart);
+				}
+			}
+			finally
+			{
+				Monitor::Exit(metricsSyncRoot);
+			}
+		}
+
+		/// <summary>
+		/// Counts the downloaded bytes that follow the read position without a gap.
+		/// </summary>
+		Int64 CountBufferedBytes()
+		{
+			if (position >= length)
+			{
+				return 0;
+			}
+
+			const auto& pieces = torrentHandle->status(libtorrent::torrent_handle::query_pieces).pieces;
+			if (pieces.empty())
 			{
-				double currentRate = bytesRead / elapsed;
-				averageReadRate = (averageReadRate * (1 - ReadRateSmoothing)) + (currentRate * ReadRateSmoothing);
-				lastReadTime = currentTime;
-				lastReadPosition = position;
+				return 0;
 			}
+
+			int64_t offset = position;
+			while (offset < length)
+			{
+				const auto segment = segments[FindSegment(offset)];
+				const int64_t torrentOffset = segment.TorrentOffset + (offset - segment.LogicalStart);
+				if (!pieces.get_bit(libtorrent::piece_index_t(static_cast<int>(torrentOffset / pieceLength))))
+				{
+					break;
+				}
+
+				// Skip to the end of the piece, or of the file if it ends first
+				offset += Math::Min(static_cast<int64_t>(pieceLength - torrentOffset % pieceLength),
+					segment.LogicalStart + segment.Length - offset);
+			}
+
+			return offset - position;
 		}
 
 		Int32 CalculateReadAheadPieces()
 		{
-			// Calculate pieces needed for 10 seconds of playback at the current average read rate
-			int piecesForTenSeconds = static_cast<int>((averageReadRate * 10) / pieceLength);
+			return readAhead->ReadAheadPieces();
+		}
 
-			// Limit the range to sensible bounds
-			return Math::Min(MaxReadAheadPieces, Math::Max(MinReadAheadPieces, piecesForTenSeconds));
+		void SampleSwarm()
+		{
+			auto now = DateTime::Now;
+			if ((now - lastSwarmSample).TotalMilliseconds < SwarmSampleIntervalMs)
+			{
+				return;
+			}
+			lastSwarmSample = now;
+
+			const auto& status = torrentHandle->status(libtorrent::torrent_handle::query_pieces);
+			readAhead->RecordDownloadRate(status.download_rate);
+
+			if (pieceRequests->Count == 0 || status.pieces.empty())
+			{
+				return;
+			}
+
+			auto arrivedPieces = gcnew List<int>();
+			auto overduePieces = gcnew List<int>();
+			for each (auto request in pieceRequests)
+			{
+				if (status.pieces.get_bit(libtorrent::piece_index_t(request.Key)))
+				{
+					readAhead->RecordPieceArrival(now - request.Value.RequestedAt);
+					arrivedPieces->Add(request.Key);
+				}
+				else if (!request.Value.Missed && now > request.Value.DueAt)
+				{
+					overduePieces->Add(request.Key);
+				}
+			}
+
+			for each (int piece in arrivedPieces)
+			{
+				pieceRequests->Remove(piece);
+			}
+
+			// Each piece counts as a miss once, however long it stays overdue
+			for each (int piece in overduePieces)
+			{
+				auto request = pieceRequests[piece];
+				request.Missed = true;
+				pieceRequests[piece] = request;
+				deadlineMisses++;
+			}
 		}
 
-		void UpdatePiecePriorities(int currentPiece)
+		void UpdatePiecePriorities(int64_t logicalPosition)
 		{
-			if (disposed || !torrentHandle) return;
+			if (disposed || !torrentHandle || length == 0) return;
 
 			int readAheadCount = CalculateReadAheadPieces();
 			static const int TopPriority = 7; // libtorrent::top_priority
 			static const int NormalPriority = 4; // libtorrent::normal_priority
 
-			// Determine the range of pieces to prioritize
-			int startPriorityPiece = Math::Max(0, currentPiece - 1); // One piece back for safety
-			int endPriorityPiece = Math::Min(totalPieces - 1, currentPiece + readAheadCount);
+			// Determine the pieces to prioritize, one piece back for safety, in stream order so that the window
+			// carries on into the next file
+			logicalPosition = Math::Max(0LL, Math::Min(logicalPosition, length - 1));
+			const int64_t windowStart = Math::Max(0LL, logicalPosition - pieceLength);
+			auto nextPieces = PiecesInRange(windowStart,
+				(logicalPosition - windowStart) + static_cast<int64_t>(readAheadCount + 1) * pieceLength);
 
-			// Skip recalculating priorities if the range hasn't changed significantly
-			if (startPriorityPiece == lastPrioritizedPiece && endPriorityPiece == lastPrioritizedPiece + readAheadCount)
+			// Skip recalculating priorities if the window hasn't changed
+			if (nextPieces[0] == windowStartPiece && nextPieces[nextPieces->Count - 1] == windowEndPiece &&
+				nextPieces->Count == windowPieces->Count)
 			{
 				return;
 			}
 
-			// Reset priorities for pieces outside the new range
-			if (lastPrioritizedPiece >= 0)
+			// A single status query replaces a have_piece roundtrip per piece in the window
+			const auto& pieces = torrentHandle->status(libtorrent::torrent_handle::query_pieces).pieces;
+			const auto hasPiece = [&pieces](int piece)
+			{
+				return !pieces.empty() && pieces.get_bit(libtorrent::piece_index_t(piece));
+			};
+
+			std::vector<std::pair<libtorrent::piece_index_t, libtorrent::download_priority_t>> priorities;
+			std::vector<std::pair<libtorrent::piece_index_t, int>> deadlines;
+			const auto requestTime = DateTime::Now;
+			priorities.reserve(nextPieces->Count);
+
+			// Pieces that leave the window are reset by the window manager once no other stream reserves them
+			auto nextWindow = gcnew HashSet<int>(nextPieces);
+			for each (int piece in windowPieces)
 			{
-				int previousEnd = lastPrioritizedPiece + readAheadCount;
-				for (int i = lastPrioritizedPiece; i <= previousEnd; i++)
+				if (!nextWindow->Contains(piece))
 				{
-					if (i < totalPieces)
+					pieceRequests->Remove(piece);
+				}
+			}
+
+			// Distances are counted in pieces along the stream, not in piece indices
+			const int currentIndex = Math::Max(0, nextPieces->IndexOf(PieceAt(logicalPosition)));
+
+			// Update priorities for the current range
+			for (int i = 0; i < nextPieces->Count; i++)
+			{
+				const int piece = nextPieces[i];
+				const int distance = i - currentIndex;
+
+				// Priority decays based on distance from current piece
+				int priority = Math::Max(NormalPriority, TopPriority - (distance / 5));
+				priorities.emplace_back(libtorrent::piece_index_t(piece),
+					static_cast<libtorrent::download_priority_t>(priority));
+
+				// Only pieces that are still missing need a deadline
+				if (!hasPiece(piece))
+				{
+					// Progressive deadline growth
+					int deadline = Math::Max(0, distance * (30 + distance * 2));
+					deadlines.emplace_back(libtorrent::piece_index_t(piece), deadline);
+					pieceRequests->TryAdd(piece, CreatePieceRequest(requestTime, deadline));
+				}
+			}
+
+			windowManager->Reserve(this, priorities, deadlines);
+
+			// Remember the window so the next shift only resets what actually left it
+			windowPieces = nextWindow;
+			windowStartPiece = nextPieces[0];
+			windowEndPiece = nextPieces[nextPieces->Count - 1];
+		}
+
+		/// <summary>
+		/// Builds the segments of a stream that reads the specified files back to back. Empty files are skipped.
+		/// </summary>
+		static array<StreamSegment>^ CreateSegments(const libtorrent::file_storage& fileStorage,
+			const std::vector<libtorrent::file_index_t>& fileIndices)
+		{
+			auto result = gcnew List<StreamSegment>(static_cast<int>(fileIndices.size()));
+			int64_t logicalStart = 0;
+
+			for (const auto& fileIndex : fileIndices)
+			{
+				const int64_t fileSize = fileStorage.file_size(fileIndex);
+				if (fileSize == 0)
+				{
+					continue;
+				}
+
+				StreamSegment segment;
+				segment.LogicalStart = logicalStart;
+				segment.TorrentOffset = fileStorage.file_offset(fileIndex);
+				segment.Length = fileSize;
+				result->Add(segment);
+
+				logicalStart += fileSize;
+			}
+
+			return result->ToArray();
+		}
+
+		/// <summary>
+		/// Finds the segment containing a position of the stream.
+		/// </summary>
+		int FindSegment(int64_t logicalOffset)
+		{
+			int low = 0;
+			int high = segments->Length - 1;
+			while (low < high)
+			{
+				const int middle = (low + high + 1) / 2;
+				if (segments[middle].LogicalStart <= logicalOffset)
+				{
+					low = middle;
+				}
+				else
+				{
+					high = middle - 1;
+				}
+			}
+			return low;
+		}
+
+		/// <summary>
+		/// Converts a position of the stream into an offset in the torrent's byte space.
+		/// </summary>
+		int64_t ToTorrentOffset(int64_t logicalOffset)
+		{
+			const auto segment = segments[FindSegment(logicalOffset)];
+			return segment.TorrentOffset + (logicalOffset - segment.LogicalStart);
+		}
+
+		/// <summary>
+		/// Gets the piece holding a position of the stream.
+		/// </summary>
+		int PieceAt(int64_t logicalOffset)
+		{
+			return static_cast<int>(ToTorrentOffset(logicalOffset) / pieceLength);
+		}
+
+		/// <summary>
+		/// Gets the pieces covering a range of the stream, in stream order and without duplicates. The range is
+		/// clamped to the stream.
+		/// </summary>
+		List<int>^ PiecesInRange(int64_t start, int64_t count)
+		{
+			auto result = gcnew List<int>();
+			start = Math::Max(0LL, start);
+			const int64_t end = Math::Min(length, start + count);
+			if (start >= end)
+			{
+				return result;
+			}
+
+			// Files that share a boundary piece would otherwise list it twice
+			auto seen = gcnew HashSet<int>();
+			for (int i = FindSegment(start); i < segments->Length && segments[i].LogicalStart < end; i++)
+			{
+				const auto segment = segments[i];
+				const int64_t segmentStart = Math::Max(start, segment.LogicalStart) - segment.LogicalStart;
+				const int64_t segmentEnd = Math::Min(end, segment.LogicalStart + segment.Length) - segment.LogicalStart;
+				const int firstPiece = static_cast<int>((segment.TorrentOffset + segmentStart) / pieceLength);
+				const int lastPiece = static_cast<int>((segment.TorrentOffset + segmentEnd - 1) / pieceLength);
+
+				for (int piece = firstPiece; piece <= lastPiece; piece++)
+				{
+					if (seen->Add(piece))
 					{
-						torrentHandle->piece_priority(libtorrent::piece_index_t(i), libtorrent::default_priority);
+						result->Add(piece);
 					}
 				}
 			}
 
-			// Update priorities for the current range
-			for (int i = startPriorityPiece; i <= endPriorityPiece; i++)
+			return result;
+		}
+
+		/// <summary>
+		/// Probes the header once its pieces are there, and starts parsing the index on the thread pool once the
+		/// index range is downloaded. The index can be tens of megabytes, which a read must not wait for.
+		/// </summary>
+		void UpdateMediaIndex()
+		{
+			if (!probeMediaIndex || isParsingMediaIndex || (mediaIndex != nullptr && mediaIndex->IsComplete))
+			{
+				return;
+			}
+
+			try
 			{
-				if (i < totalPieces)
+				if (mediaIndex == nullptr)
 				{
-					// Priority decays based on distance from current piece
-					int priority = Math::Max(NormalPriority, TopPriority - ((i - currentPiece) / 5));
-					torrentHandle->piece_priority(libtorrent::piece_index_t(i),
-						static_cast<libtorrent::download_priority_t>(priority));
+					const int headerLength = static_cast<int>(Math::Min(static_cast<int64_t>(MediaHeaderProbeBytes), length));
+					if (headerLength <= 0 || !IsRangeAvailable(0, headerLength))
+					{
+						return;
+					}
+
+					auto header = gcnew array<Byte>(headerLength);
+					mediaIndex = MediaIndexProbe::ProbeHeader(header, ReadAt(0, header, 0, headerLength), length);
+					if (mediaIndex->IndexRanges->Count == 0)
+					{
+						mediaIndex->IsComplete = true;
+						return;
+					}
+
+					// Fetch the index now rather than when the player asks for it
+					PrioritizeMediaIndexRanges();
+				}
+
+				auto range = mediaIndex->IndexRanges[0];
+				const int rangeLength = static_cast<int>(Math::Min(range.End - range.Start,
+					static_cast<int64_t>(MaxMediaIndexBytes)));
+				if (!IsRangeAvailable(range.Start, rangeLength))
+				{
+					return;
+				}
+
+				isParsingMediaIndex = true;
+				ThreadPool::QueueUserWorkItem(gcnew WaitCallback(this, &TorrentStream::ParseMediaIndex));
+			}
+			catch (IOException^)
+			{
+				// Retried on the next read
+			}
+			catch (Exception^)
+			{
+				// A file the probe cannot make sense of only loses the prefetch hints
+				mediaIndex = gcnew MediaIndex(MediaContainer::Unknown);
+				mediaIndex->IsComplete = true;
+			}
+		}
+
+		/// <summary>
+		/// Reads the index range a chunk at a time, taking the stream's lock only for each chunk so reads can go on
+		/// in between, then parses it into a copy of the index that replaces the current one when done.
+		/// </summary>
+		void ParseMediaIndex(Object^ state)
+		{
+			MediaIndex^ parsed;
+			array<Byte>^ data;
+			int dataLength = 0;
+
+			try
+			{
+				Monitor::Enter(syncRoot);
+				try
+				{
+					parsed = gcnew MediaIndex(mediaIndex->Container);
+					parsed->IndexRanges->AddRange(mediaIndex->IndexRanges);
+					parsed->SegmentDataOffset = mediaIndex->SegmentDataOffset;
+				}
+				finally
+				{
+					Monitor::Exit(syncRoot);
+				}
+
+				const auto range = parsed->IndexRanges[0];
+				data = gcnew array<Byte>(static_cast<int>(Math::Min(range.End - range.Start,
+					static_cast<int64_t>(MaxMediaIndexBytes))));
+
+				while (dataLength < data->Length)
+				{
+					Monitor::Enter(syncRoot);
+					try
+					{
+						if (disposed)
+						{
+							return;
+						}
+
+						const int read = ReadAt(range.Start + dataLength, data, dataLength,
+							Math::Min(MediaIndexChunkBytes, data->Length - dataLength));
+						if (read <= 0)
+						{
+							// Retried on the next read
+							isParsingMediaIndex = false;
+							return;
+						}
+						dataLength += read;
+					}
+					finally
+					{
+						Monitor::Exit(syncRoot);
+					}
+				}
+
+				MediaIndexProbe::ParseIndex(parsed, data, dataLength);
+			}
+			catch (IOException^)
+			{
+				parsed = nullptr;
+			}
+			catch (Exception^)
+			{
+				// A file the probe cannot make sense of only loses the prefetch hints
+				parsed = gcnew MediaIndex(MediaContainer::Unknown);
+				parsed->IsComplete = true;
+			}
+
+			Monitor::Enter(syncRoot);
+			try
+			{
+				if (parsed != nullptr)
+				{
+					mediaIndex = parsed;
+				}
+				isParsingMediaIndex = false;
+			}
+			finally
+			{
+				Monitor::Exit(syncRoot);
+			}
+		}
+
+		void PrioritizeMediaIndexRanges()
+		{
+			std::vector<std::pair<libtorrent::piece_index_t, libtorrent::download_priority_t>> priorities;
+			std::vector<std::pair<libtorrent::piece_index_t, int>> deadlines;
+
+			for each (MediaByteRange range in mediaIndex->IndexRanges)
+			{
+				auto rangePieces = PiecesInRange(range.Start,
+					Math::Min(range.End - range.Start, static_cast<int64_t>(MaxMediaIndexBytes)));
+
+				for (int i = 0; i < rangePieces->Count; i++)
+				{
+					priorities.emplace_back(libtorrent::piece_index_t(rangePieces[i]), libtorrent::top_priority);
+					deadlines.emplace_back(libtorrent::piece_index_t(rangePieces[i]), i * 50);
+				}
+			}
+
+			// Kept apart from the playback window so that moving the window does not drop the index pieces
+			windowManager->Reserve(mediaIndexReservation, priorities, deadlines);
+		}
 
-					// Apply progressive deadlines
-					int deadline = (i - currentPiece) * (30 + (i - currentPiece) * 2); // Progressive deadline growth
-					torrentHandle->set_piece_deadline(libtorrent::piece_index_t(i), deadline);
+		void PrefetchFromKeyframe()
+		{
+			if (mediaIndex == nullptr || mediaIndex->KeyframeOffsets->Count == 0)
+			{
+				return;
+			}
+
+			// Decoding resumes at the keyframe before the seek target, so the window has to start there
+			const int64_t keyframe = mediaIndex->FindKeyframe(position);
+			if (keyframe >= 0)
+			{
+				UpdatePiecePriorities(keyframe);
+			}
+		}
+
+		int ReadAt(int64_t readPosition, array<Byte>^ destination, int destinationOffset, int count)
+		{
+			if (pieceReader != nullptr)
+			{
+				return ReadFromPieces(readPosition, destination, destinationOffset, count);
+			}
+
+			int bytesRead = 0;
+			fileStream->Position = readPosition;
+			while (bytesRead < count)
+			{
+				const int read = fileStream->Read(destination, destinationOffset + bytesRead, count - bytesRead);
+				if (read <= 0)
+				{
+					break;
 				}
+				bytesRead += read;
+			}
+			return bytesRead;
+		}
+
+		void UpdateReadAheadWindow()
+		{
+			// Predict next buffer position based on read rate
+			int64_t predictedPosition = position + static_cast<int64_t>(readAhead->ConsumerRate * 2.0);
+
+			SampleSwarm();
+
+			UpdatePiecePriorities(predictedPosition);
+		}
+
+		int ReadDirect(array<Byte>^ outputBuffer, int outputOffset, int count)
+		{
+			if (count <= 0 || !IsRangeAvailable(position, count))
+			{
+				return 0;
 			}
 
-			// Update the last prioritized piece range
-			lastPrioritizedPiece = currentPiece;
+			// Direct reads bypass PreloadBuffer, so keep the read-ahead window moving from here
+			UpdateReadAheadWindow();
+
+			if (pieceReader != nullptr)
+			{
+				return ReadFromPieces(position, outputBuffer, outputOffset, count);
+			}
+
+			fileStream->Position = position;
+			return fileStream->Read(outputBuffer, outputOffset, count);
+		}
+
+		bool IsRangeAvailable(int64_t start, int count)
+		{
+			for each (int piece in PiecesInRange(start, count))
+			{
+				if (!torrentHandle->have_piece(libtorrent::piece_index_t(piece)))
+				{
+					return false;
+				}
+			}
+			return true;
 		}
 
 		void PreloadBuffer()
 		{
-			int startPiece = static_cast<int>(position / pieceLength);
 			int elapsedTime = 0;
 			int readAheadCount = CalculateReadAheadPieces();
+			auto upcomingPieces = PiecesInRange(position, static_cast<int64_t>(readAheadCount) * pieceLength);
 
-			// Predict next buffer position based on read rate
-			int64_t predictedPosition = position + static_cast<int64_t>(averageReadRate * 2.0);
-			int predictedPiece = static_cast<int>(predictedPosition / pieceLength);
+			// Near the end of the stream there may be fewer pieces left than we would like to wait for
+			const int requiredPieces = Math::Min(Math::Min(5, readAheadCount / 2), upcomingPieces->Count);
 
-			UpdatePiecePriorities(predictedPiece);
+			UpdateReadAheadWindow();
 
 			while (elapsedTime < MaxWaitTimeMs)
 			{
-				int consecutiveAvailable = GetConsecutiveAvailablePieces(startPiece);
+				int consecutiveAvailable = GetConsecutiveAvailablePieces(upcomingPieces);
 
 				// Break if we have enough consecutive pieces for smooth playback
-				if (consecutiveAvailable >= Math::Min(5, readAheadCount / 2)) 
+				if (consecutiveAvailable >= requiredPieces)
 				{
 					break;
 				}
@@ -452,22 +1203,105 @@ namespace LibtorrentDotNet
 			}
 
 			// Use larger buffer size for high read rates
-			int effectiveBufferSize = averageReadRate > 1024 * 1024 ? DynamicBufferSize : MinBufferSize;
+			const int bufferSize = maxBufferSize;
+			int effectiveBufferSize = readAhead->ConsumerRate > 1024 * 1024
+				? bufferSize
+				: Math::Min(MinBufferSize, bufferSize);
+
+			// The read-ahead buffer is only needed once a read has to wait for pieces, and is replaced when the
+			// memory budget resizes it
+			if (buffer == nullptr || buffer->Length != bufferSize)
+			{
+				buffer = gcnew array<Byte>(bufferSize);
+			}
 
-			fileStream->Position = position;
 			bufferStart = position;
-			bufferLength = fileStream->Read(buffer, 0, effectiveBufferSize);
+			if (pieceReader != nullptr)
+			{
+				bufferLength = ReadFromPieces(position, buffer, 0,
+					static_cast<int>(Math::Min(static_cast<int64_t>(effectiveBufferSize), length - position)));
+			}
+			else
+			{
+				fileStream->Position = position;
+				bufferLength = fileStream->Read(buffer, 0, effectiveBufferSize);
+			}
 		}
 
-		bool VerifyPieceAvailability(int startPiece, int count)
+		int ReadFromPieces(int64_t readPosition, array<Byte>^ destination, int destinationOffset, int count)
 		{
+			auto availablePieces = gcnew List<int>();
+			for each (int piece in PiecesInRange(readPosition, count))
+			{
+				if (!torrentHandle->have_piece(libtorrent::piece_index_t(piece)))
+				{
+					break;
+				}
+
+				availablePieces->Add(piece);
+			}
+
+			// Pieces are queued ahead of the read so libtorrent reads them in parallel, but only as many as the cache
+			// holds. Any more and the later pieces would evict the earlier ones before they are copied out.
+			const int requestAhead = pieceReader->GetPieceCapacity(pieceLength);
+			int requested = 0;
+
+			int bytesRead = 0;
+			while (bytesRead < count)
+			{
+				const int64_t logicalOffset = readPosition + bytesRead;
+				const auto segment = segments[FindSegment(logicalOffset)];
+				const int64_t torrentOffset = segment.TorrentOffset + (logicalOffset - segment.LogicalStart);
+				const int piece = static_cast<int>(torrentOffset / pieceLength);
+				const int pieceOffset = static_cast<int>(torrentOffset % pieceLength);
+
+				// Stop at the first missing piece, the next fill waits for it
+				const int index = availablePieces->IndexOf(piece);
+				if (index < 0)
+				{
+					break;
+				}
+
+				while (requested < availablePieces->Count && requested < index + requestAhead)
+				{
+					pieceReader->Request(availablePieces[requested++]);
+				}
+
+				// A single read never crosses a piece or a file boundary
+				const int toRead = static_cast<int>(Math::Min(
+					static_cast<int64_t>(Math::Min(count - bytesRead, pieceLength - pieceOffset)),
+					segment.LogicalStart + segment.Length - logicalOffset));
+				const int read = pieceReader->Read(piece, pieceOffset, destination, destinationOffset + bytesRead, toRead,
+					readTimeout);
+				if (read <= 0)
+				{
+					break;
+				}
+
+				bytesRead += read;
+			}
+
+			return bytesRead;
+		}
+
+		bool VerifyPieceAvailability(int64_t logicalPosition, int count)
+		{
+			auto upcomingPieces = PiecesInRange(logicalPosition, static_cast<int64_t>(count) * pieceLength);
+
+			// We want at least 3 consecutive pieces, or all of them when the stream ends sooner
+			const int requiredPieces = Math::Min(3, upcomingPieces->Count);
+			if (requiredPieces == 0)
+			{
+				return true;
+			}
+
 			int consecutiveAvailable = 0;
-			for (int i = 0; i < count; i++)
+			for each (int piece in upcomingPieces)
 			{
-				if (torrentHandle->have_piece(libtorrent::piece_index_t(startPiece + i)))
+				if (torrentHandle->have_piece(libtorrent::piece_index_t(piece)))
 				{
 					consecutiveAvailable++;
-					if (consecutiveAvailable >= 3) // We have at least 3 consecutive pieces
+					if (consecutiveAvailable >= requiredPieces)
 					{
 						return true;
 					}
@@ -480,14 +1314,14 @@ namespace LibtorrentDotNet
 			return false;
 		}
 
-		int GetConsecutiveAvailablePieces(int startPiece)
+		int GetConsecutiveAvailablePieces(List<int>^ upcomingPieces)
 		{
 			int consecutive = 0;
 			int maxConsecutive = 0;
 
-			for (int i = 0; i < totalPieces - startPiece; i++)
+			for each (int piece in upcomingPieces)
 			{
-				if (torrentHandle->have_piece(libtorrent::piece_index_t(startPiece + i))) 
+				if (torrentHandle->have_piece(libtorrent::piece_index_t(piece)))
 				{
 					consecutive++;
 					maxConsecutive = Math::Max(maxConsecutive, consecutive);
@@ -508,9 +1342,16 @@ namespace LibtorrentDotNet
 
 		void CleanupResources(bool disposing)
 		{
-			if (!disposed)
+			if (disposed)
+			{
+				return;
+			}
+
+			if (disposing)
 			{
-				if (disposing)
+				// Metrics snapshots are taken from other threads and must not see the handle go away under them
+				Monitor::Enter(metricsSyncRoot);
+				try
 				{
 					if (fileStream != nullptr)
 					{
@@ -518,17 +1359,48 @@ namespace LibtorrentDotNet
 						delete fileStream;
 					}
 
+					if (pieceReader != nullptr)
+					{
+						pieceReader->Close();
+						pieceReader = nullptr;
+					}
+
+					if (windowManager != nullptr)
+					{
+						windowManager->Release(this);
+						windowManager->Release(mediaIndexReservation);
+						windowManager->Detach();
+						windowManager = nullptr;
+					}
+
 					buffer = nullptr;
+					ReleaseHandle();
+				}
+				finally
+				{
+					Monitor::Exit(metricsSyncRoot);
 				}
 
-				if (torrentHandle != nullptr)
+				if (closedCallback != nullptr)
 				{
-					delete torrentHandle;
-					torrentHandle = nullptr;
+					closedCallback(this);
 				}
+			}
+			else
+			{
+				ReleaseHandle();
+			}
+		}
 
-				disposed = true;
+		void ReleaseHandle()
+		{
+			if (torrentHandle != nullptr)
+			{
+				delete torrentHandle;
+				torrentHandle = nullptr;
 			}
+
+			disposed = true;
 		}
 	};
 }
@@ -0,0 +1 @@
+#include "TorrentStreamMetrics.h"
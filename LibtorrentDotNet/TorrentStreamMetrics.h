@@ -0,0 +1,129 @@
+#pragma once
+#include "Optional.h"
+#include "TorrentId.h"
+
+using namespace System;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents a snapshot of the playback health of a <see cref="TorrentStream"/>.
+	/// </summary>
+	public ref class TorrentStreamMetrics sealed {
+	public:
+		/// <summary>
+		/// Initializes a new instance of the TorrentStreamMetrics class.
+		/// </summary>
+		/// <param name="torrentId">The unique identifier of the torrent the stream reads from.</param>
+		/// <param name="position">The current position in the stream.</param>
+		/// <param name="length">The length of the stream in bytes.</param>
+		/// <param name="timeToFirstByte">The time from opening the stream until the first byte was read, if any was read yet.</param>
+		/// <param name="stallCount">The number of times a read had to wait for pieces.</param>
+		/// <param name="totalStallDuration">The total time reads spent waiting for pieces.</param>
+		/// <param name="isStalled">Whether a read is currently waiting for pieces.</param>
+		/// <param name="bufferedBytes">The number of contiguous downloaded bytes from the current position.</param>
+		/// <param name="bufferedSeconds">The buffered bytes in seconds of playback at the consumer's rate.</param>
+		/// <param name="deadlineMisses">The number of pieces that arrived after their deadline or not at all.</param>
+		/// <param name="consumerRate">The rate at which the consumer reads the stream in bytes per second.</param>
+		/// <param name="downloadRate">The download rate of the torrent in bytes per second.</param>
+		TorrentStreamMetrics(
+			TorrentId^ torrentId,
+			const Int64 position,
+			const Int64 length,
+			Optional<TimeSpan>^ timeToFirstByte,
+			const int stallCount,
+			const TimeSpan totalStallDuration,
+			const bool isStalled,
+			const Int64 bufferedBytes,
+			const double bufferedSeconds,
+			const int deadlineMisses,
+			const double consumerRate,
+			const double downloadRate) :
+			torrentId(torrentId),
+			position(position),
+			length(length),
+			timeToFirstByte(timeToFirstByte),
+			stallCount(stallCount),
+			totalStallDuration(totalStallDuration),
+			isStalled(isStalled),
+			bufferedBytes(bufferedBytes),
+			bufferedSeconds(bufferedSeconds),
+			deadlineMisses(deadlineMisses),
+			consumerRate(consumerRate),
+			downloadRate(downloadRate) {}
+
+		/// <summary>
+		/// Gets the unique identifier of the torrent the stream reads from.
+		/// </summary>
+		property TorrentId^ Id { TorrentId^ get() { return torrentId; } }
+
+		/// <summary>
+		/// Gets the current position in the stream.
+		/// </summary>
+		property Int64 Position { Int64 get() { return position; } }
+
+		/// <summary>
+		/// Gets the length of the stream in bytes.
+		/// </summary>
+		property Int64 Length { Int64 get() { return length; } }
+
+		/// <summary>
+		/// Gets the time from opening the stream until its first byte was read, or none if nothing was read yet.
+		/// </summary>
+		property Optional<TimeSpan>^ TimeToFirstByte { Optional<TimeSpan>^ get() { return timeToFirstByte; } }
+
+		/// <summary>
+		/// Gets the number of times a read had to wait for pieces.
+		/// </summary>
+		property int StallCount { int get() { return stallCount; } }
+
+		/// <summary>
+		/// Gets the total time reads spent waiting for pieces, including a stall that is still in progress.
+		/// </summary>
+		property TimeSpan TotalStallDuration { TimeSpan get() { return totalStallDuration; } }
+
+		/// <summary>
+		/// Gets a value indicating whether a read is currently waiting for pieces.
+		/// </summary>
+		property bool IsStalled { bool get() { return isStalled; } }
+
+		/// <summary>
+		/// Gets the number of contiguous downloaded bytes from the current position.
+		/// </summary>
+		property Int64 BufferedBytes { Int64 get() { return bufferedBytes; } }
+
+		/// <summary>
+		/// Gets the buffered bytes expressed in seconds of playback at the consumer's rate, or 0 if the rate is not known yet.
+		/// </summary>
+		property double BufferedSeconds { double get() { return bufferedSeconds; } }
+
+		/// <summary>
+		/// Gets the number of pieces that were still missing when their deadline passed.
+		/// </summary>
+		property int DeadlineMisses { int get() { return deadlineMisses; } }
+
+		/// <summary>
+		/// Gets the smoothed rate at which the consumer reads the stream, in bytes per second.
+		/// </summary>
+		property double ConsumerRate { double get() { return consumerRate; } }
+
+		/// <summary>
+		/// Gets the most recently sampled download rate of the torrent, in bytes per second.
+		/// </summary>
+		property double DownloadRate { double get() { return downloadRate; } }
+
+	private:
+		TorrentId^ torrentId;
+		Int64 position;
+		Int64 length;
+		Optional<TimeSpan>^ timeToFirstByte;
+		int stallCount;
+		TimeSpan totalStallDuration;
+		bool isStalled;
+		Int64 bufferedBytes;
+		double bufferedSeconds;
+		int deadlineMisses;
+		double consumerRate;
+		double downloadRate;
+	};
+}
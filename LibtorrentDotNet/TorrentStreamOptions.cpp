@@ -0,0 +1 @@
+#include "TorrentStreamOptions.h"
@@ -0,0 +1,81 @@
+#pragma once
+#include "Optional.h"
+
+using namespace System;
+
+namespace LibtorrentDotNet
+{
+	/// <summary>
+	/// Represents where a <see cref="TorrentStream"/> reads downloaded data from.
+	/// </summary>
+	public enum class TorrentStreamReadBackend
+	{
+		/// <summary>
+		/// Pieces are read through libtorrent's disk layer, which serves recently written pieces from its cache and
+		/// does not require the file to exist on disk when the stream is opened.
+		/// </summary>
+		Libtorrent,
+
+		/// <summary>
+		/// The file is opened separately from the save path and read through the operating system.
+		/// The file must already exist when the stream is opened.
+		/// </summary>
+		File
+	};
+
+	/// <summary>
+	/// Represents the options used when opening a <see cref="TorrentStream"/>.
+	/// </summary>
+	public ref class TorrentStreamOptions sealed
+	{
+	public:
+		/// <summary>
+		/// Gets or sets where the stream reads downloaded data from. The default is <see cref="TorrentStreamReadBackend::Libtorrent"/>.
+		/// </summary>
+		property TorrentStreamReadBackend ReadBackend;
+
+		/// <summary>
+		/// Gets or sets the maximum number of bytes of piece data the stream keeps cached when reading through libtorrent.
+		/// </summary>
+		property Optional<int>^ MaxCachedPieceBytes;
+
+		/// <summary>
+		/// Gets or sets whether reads of fully downloaded ranges are copied straight into the caller's buffer instead of
+		/// going through the stream's internal read-ahead buffer. The default is true.
+		/// </summary>
+		property bool DirectRead;
+
+		/// <summary>
+		/// Gets or sets whether the stream parses MP4 and Matroska/WebM headers from the first pieces to prefetch the
+		/// file's index (such as a trailing moov box or Cues element) and to start seeks from the nearest keyframe.
+		/// The index is parsed on the thread pool once downloaded. Only a stream of a single file can probe it.
+		/// The default is false.
+		/// </summary>
+		property bool ProbeMediaIndex;
+
+		/// <summary>
+		/// Gets or sets how much playback, at the consumer's read rate, the stream tries to keep requested ahead of
+		/// the read position. It must be positive. The default is 10 seconds.
+		/// </summary>
+		property Optional<TimeSpan>^ TargetBufferDuration;
+
+		/// <summary>
+		/// Gets or sets the maximum number of bytes the read-ahead window may span, regardless of bitrate or piece size.
+		/// It must be positive. The default is 128 MB.
+		/// </summary>
+		property Optional<Int64>^ MaxReadAheadBytes;
+
+		/// <summary>
+		/// Initializes a new instance of the TorrentStreamOptions class with default values.
+		/// </summary>
+		TorrentStreamOptions()
+		{
+			ReadBackend = TorrentStreamReadBackend::Libtorrent;
+			MaxCachedPieceBytes = Optional<int>::None();
+			DirectRead = true;
+			ProbeMediaIndex = false;
+			TargetBufferDuration = Optional<TimeSpan>::None();
+			MaxReadAheadBytes = Optional<Int64>::None();
+		}
+	};
+}